@@ -4,9 +4,15 @@
 
 // function prototypes
 extern void testBankAccounts();
+extern void benchmarkTransactionEngine();
+extern void testTransactionBatch();
+extern void benchmarkTransactionBatch();
 
 int main() {
     testBankAccounts();
+    benchmarkTransactionEngine();
+    testTransactionBatch();
+    benchmarkTransactionBatch();
     return 0;
 }
 
@@ -0,0 +1,318 @@
+// ===========================================================================
+// TransactionBatch.cpp
+// ===========================================================================
+
+#include "BankAccount.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <variant>
+#include <initializer_list>
+#include <utility>
+#include <chrono>
+#include <random>
+
+namespace TransactionBatchDemo {
+
+    /**
+     * Closed set of commands with value semantics:
+     * a batch is a single contiguous array of std::variant objects,
+     * no heap allocation per command and no virtual call.
+     */
+    struct Deposit
+    {
+        BankAccount* m_account;
+        int m_amount;
+    };
+
+    struct Withdraw
+    {
+        BankAccount* m_account;
+        int m_amount;
+    };
+
+    struct Transfer
+    {
+        BankAccount* m_from;
+        BankAccount* m_to;
+        int m_amount;
+    };
+
+    using TransactionCommand = std::variant<Deposit, Withdraw, Transfer>;
+
+    template <typename... Ts>
+    struct Overloaded : Ts... { using Ts::operator()...; };
+
+    template <typename... Ts>
+    Overloaded(Ts...) -> Overloaded<Ts...>;
+
+    // a withdrawal fails, if it would overdraw the account - unlike
+    // BankAccountWithdrawCommand, which doesn't check the balance at all:
+    // a failing command is what triggers the rollback of a batch
+    static bool execute(const TransactionCommand& command)
+    {
+        return std::visit(
+            Overloaded{
+                [](const Deposit& deposit) {
+                    deposit.m_account->deposit(deposit.m_amount);
+                    return true;
+                },
+                [](const Withdraw& withdraw) {
+                    if (withdraw.m_account->getBalance() < withdraw.m_amount) {
+                        return false;
+                    }
+                    withdraw.m_account->withdraw(withdraw.m_amount);
+                    return true;
+                },
+                [](const Transfer& transfer) {
+                    if (transfer.m_from->getBalance() < transfer.m_amount) {
+                        return false;
+                    }
+                    transfer.m_from->withdraw(transfer.m_amount);
+                    transfer.m_to->deposit(transfer.m_amount);
+                    return true;
+                }
+            },
+            command
+        );
+    }
+
+    static void undo(const TransactionCommand& command)
+    {
+        std::visit(
+            Overloaded{
+                [](const Deposit& deposit) {
+                    deposit.m_account->withdraw(deposit.m_amount);
+                },
+                [](const Withdraw& withdraw) {
+                    withdraw.m_account->deposit(withdraw.m_amount);
+                },
+                [](const Transfer& transfer) {
+                    transfer.m_to->withdraw(transfer.m_amount);
+                    transfer.m_from->deposit(transfer.m_amount);
+                }
+            },
+            command
+        );
+    }
+
+    /**
+     * Invoker executing a batch of commands "all or nothing":
+     * if a command fails, all commands executed so far are undone
+     * in reverse order and the accounts are left unchanged.
+     * Only a successfully executed batch can be undone, and only once.
+     */
+    class TransactionBatch
+    {
+    private:
+        std::vector<TransactionCommand> m_commands;
+        size_t m_executed{};        // commands applied by the last successful execute()
+        bool m_undoable{};
+
+    public:
+        TransactionBatch() = default;
+
+        TransactionBatch(std::initializer_list<TransactionCommand> commands)
+            : m_commands{ commands } {}
+
+        void reserve(size_t count) { m_commands.reserve(count); }
+
+        void add(const TransactionCommand& command) { m_commands.push_back(command); }
+
+        template <typename TCommand, typename... TArgs>
+        void emplace(TArgs&&... args)
+        {
+            m_commands.emplace_back(TCommand{ std::forward<TArgs>(args)... });
+        }
+
+        size_t size() const { return m_commands.size(); }
+
+        // the effects of an executed batch remain, but it can't be undone anymore
+        void clear()
+        {
+            m_commands.clear();
+            m_executed = 0;
+            m_undoable = false;
+        }
+
+        // returns false, if a command failed or the batch has been executed already
+        // (and not undone): in both cases the accounts are left unchanged
+        bool execute()
+        {
+            if (m_undoable) {
+                return false;
+            }
+
+            for (size_t i = 0; i < m_commands.size(); ++i) {
+                if (!TransactionBatchDemo::execute(m_commands[i])) {
+                    rollback(i);
+                    return false;
+                }
+            }
+
+            m_executed = m_commands.size();
+            m_undoable = true;
+            return true;
+        }
+
+        // reverts the last successful execute(); returns false, if there is nothing to undo
+        bool undo()
+        {
+            if (!m_undoable) {
+                return false;
+            }
+
+            // commands added after execute() haven't been applied
+            rollback(m_executed);
+            m_executed = 0;
+            m_undoable = false;
+            return true;
+        }
+
+    private:
+        // undoes the first 'count' commands in reverse order
+        void rollback(size_t count) const
+        {
+            while (count != 0) {
+                --count;
+                TransactionBatchDemo::undo(m_commands[count]);
+            }
+        }
+    };
+}
+
+void testTransactionBatch()
+{
+    using namespace TransactionBatchDemo;
+
+    BankAccount ba1{ 1000 };
+    BankAccount ba2{ 1000 };
+
+    TransactionBatch batch
+    {
+        Withdraw{ &ba1, 300 },
+        Deposit{ &ba2, 300 },
+        Transfer{ &ba2, &ba1, 100 }
+    };
+
+    bool succeeded = batch.execute();
+
+    std::cout << std::boolalpha << succeeded << ": "
+        << ba1.getBalance() << ", " << ba2.getBalance() << std::endl;
+
+    succeeded = batch.undo();
+
+    std::cout << std::boolalpha << succeeded << ": "
+        << ba1.getBalance() << ", " << ba2.getBalance() << std::endl;
+
+    // a batch is undone only once
+    succeeded = batch.undo();
+
+    std::cout << std::boolalpha << succeeded << ": "
+        << ba1.getBalance() << ", " << ba2.getBalance() << std::endl;
+
+    // second transfer overdraws 'ba1': the whole batch is rolled back
+    TransactionBatch failing
+    {
+        Transfer{ &ba1, &ba2, 600 },
+        Transfer{ &ba1, &ba2, 600 }
+    };
+
+    succeeded = failing.execute();
+
+    std::cout << std::boolalpha << succeeded << ": "
+        << ba1.getBalance() << ", " << ba2.getBalance() << std::endl;
+
+    // nothing to undo: the failed batch has been rolled back already
+    succeeded = failing.undo();
+
+    std::cout << std::boolalpha << succeeded << ": "
+        << ba1.getBalance() << ", " << ba2.getBalance() << std::endl;
+}
+
+void benchmarkTransactionBatch()
+{
+    using namespace TransactionBatchDemo;
+
+    constexpr size_t NumAccounts = 1024;
+    constexpr size_t NumTransfers = 2'000'000;
+
+    struct Indices { size_t m_from; size_t m_to; int m_amount; };
+
+    std::mt19937 generator{ 4711 };
+    std::uniform_int_distribution<size_t> account{ 0, NumAccounts - 1 };
+    std::uniform_int_distribution<int> amount{ 1, 100 };
+
+    std::vector<Indices> transfers;
+    transfers.reserve(NumTransfers);
+    for (size_t i = 0; i < NumTransfers; ++i) {
+        transfers.push_back({ account(generator), account(generator), amount(generator) });
+    }
+
+    // shared_ptr commands with virtual execute
+    std::vector<BankAccount> accounts1(NumAccounts, BankAccount{ 1'000'000 });
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_ptr<Command>> commands;
+    commands.reserve(2 * NumTransfers);
+    for (const Indices& transfer : transfers) {
+        commands.push_back(std::make_shared<BankAccountWithdrawCommand>(accounts1[transfer.m_from], transfer.m_amount));
+        commands.push_back(std::make_shared<BankAccountDepositCommand>(accounts1[transfer.m_to], transfer.m_amount));
+    }
+
+    Transactions transactions{ std::move(commands) };
+    transactions.execute();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "Transactions (shared_ptr): " << NumTransfers << " transfers, "
+        << msecs << " msecs." << std::endl;
+
+    // std::variant commands in a contiguous array
+    std::vector<BankAccount> accounts2(NumAccounts, BankAccount{ 1'000'000 });
+
+    start = std::chrono::high_resolution_clock::now();
+
+    TransactionBatch batch;
+    batch.reserve(NumTransfers);
+    for (const Indices& transfer : transfers) {
+        batch.emplace<Transfer>(&accounts2[transfer.m_from], &accounts2[transfer.m_to], transfer.m_amount);
+    }
+
+    bool succeeded = batch.execute();
+
+    end = std::chrono::high_resolution_clock::now();
+    msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    bool equal = true;
+    for (size_t i = 0; i < NumAccounts; ++i) {
+        equal = equal and (accounts1[i].getBalance() == accounts2[i].getBalance());
+    }
+
+    std::cout << "TransactionBatch (variant): " << NumTransfers << " transfers, "
+        << msecs << " msecs, succeeded: " << std::boolalpha << succeeded
+        << ", balances are equal: " << equal << std::endl;
+
+    // rollback of the complete batch
+    start = std::chrono::high_resolution_clock::now();
+
+    batch.undo();
+
+    end = std::chrono::high_resolution_clock::now();
+    msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    bool restored = true;
+    for (const BankAccount& account : accounts2) {
+        restored = restored and (account.getBalance() == 1'000'000);
+    }
+
+    std::cout << "TransactionBatch (variant): undo in " << msecs
+        << " msecs, balances restored: " << restored << std::endl;
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -0,0 +1,396 @@
+// ===========================================================================
+// TransactionEngine.cpp
+// ===========================================================================
+
+#include "BankAccount.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+
+namespace TransactionEngineDemo {
+
+    /**
+     * Bounded lock-free multiple-producer single-consumer queue
+     * (ring buffer with a sequence number per cell, due to Dmitry Vyukov):
+     * no memory is allocated after construction.
+     */
+    template <typename T>
+    class BoundedMPSCQueue
+    {
+    public:
+        explicit BoundedMPSCQueue(size_t capacity)
+            : m_mask{ roundUp(capacity) - 1 },
+              m_cells{ new Cell[m_mask + 1] },
+              m_enqueuePos{ 0 },
+              m_dequeuePos{ 0 }
+        {
+            for (size_t i = 0; i <= m_mask; ++i) {
+                m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedMPSCQueue(const BoundedMPSCQueue&) = delete;
+        BoundedMPSCQueue& operator=(const BoundedMPSCQueue&) = delete;
+
+        // any thread; returns false, if the queue is full
+        bool push(const T& value)
+        {
+            size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+            while (true) {
+                Cell& cell = m_cells[pos & m_mask];
+                size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+                if (diff == 0) {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.m_value = value;
+                        cell.m_sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // consumer thread only; returns false, if the queue is empty
+        bool pop(T& value)
+        {
+            Cell& cell = m_cells[m_dequeuePos & m_mask];
+            size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+
+            if (sequence != m_dequeuePos + 1) {
+                return false;
+            }
+
+            value = cell.m_value;
+            cell.m_sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+            ++m_dequeuePos;
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> m_sequence;
+            T m_value;
+        };
+
+        static size_t roundUp(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            return size;
+        }
+
+        const size_t m_mask;
+        std::unique_ptr<Cell[]> m_cells;
+        alignas(64) std::atomic<size_t> m_enqueuePos;
+        alignas(64) size_t m_dequeuePos;
+    };
+
+    /**
+     * Commands as executed by the engine: small, trivially copyable values
+     * referring to an account by its index.
+     */
+    struct AccountCommand
+    {
+        enum class Kind : uint8_t { Deposit, Withdraw };
+
+        Kind m_kind;
+        uint32_t m_account;
+        int m_amount;
+    };
+
+    /**
+     * Executes commands submitted by any number of threads.
+     *
+     * The accounts are distributed over the worker threads in contiguous ranges
+     * (account * workers / accounts), so every account has exactly one writer and
+     * BankAccount needs no locking. Neighbouring accounts share a cache line,
+     * with ranges they share the writer, too (except at the range boundaries):
+     * interleaved shards would cause false sharing on every command.
+     * Each worker owns a lock-free queue and executes commands in batches.
+     * A transfer is split into a withdrawal and a deposit, which may be
+     * executed by two different workers.
+     */
+    class TransactionEngine
+    {
+    public:
+        TransactionEngine(std::vector<BankAccount>& accounts, size_t workers, size_t batchSize = 256)
+            : m_accounts{ accounts },
+              m_batchSize{ batchSize == 0 ? 1 : batchSize },
+              m_running{ true },
+              m_waiters{ 0 }
+        {
+            for (size_t i = 0; i < (workers == 0 ? 1 : workers); ++i) {
+                m_shards.push_back(std::make_unique<Shard>());
+            }
+
+            for (size_t i = 0; i < m_shards.size(); ++i) {
+                m_shards[i]->m_worker = std::thread{ &TransactionEngine::run, this, i };
+            }
+        }
+
+        ~TransactionEngine()
+        {
+            m_running = false;
+            for (auto& shard : m_shards) {
+                shard->m_worker.join();
+            }
+        }
+
+        TransactionEngine(const TransactionEngine&) = delete;
+        TransactionEngine& operator=(const TransactionEngine&) = delete;
+
+        void deposit(size_t account, int amount)
+        {
+            submit({ AccountCommand::Kind::Deposit, static_cast<uint32_t>(account), amount });
+        }
+
+        void withdraw(size_t account, int amount)
+        {
+            submit({ AccountCommand::Kind::Withdraw, static_cast<uint32_t>(account), amount });
+        }
+
+        void transfer(size_t from, size_t to, int amount)
+        {
+            withdraw(from, amount);
+            deposit(to, amount);
+        }
+
+        // waits until all commands submitted so far have been executed
+        void flush()
+        {
+            ++m_waiters;
+
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            for (auto& shard : m_shards) {
+                size_t submitted = shard->m_submitted.load();
+                m_executed.wait(lock, [&]() { return shard->m_executed.load() >= submitted; });
+            }
+
+            --m_waiters;
+        }
+
+    private:
+        struct Shard
+        {
+            Shard() : m_queue{ 64 * 1024 }, m_submitted{ 0 }, m_executed{ 0 } {}
+
+            BoundedMPSCQueue<AccountCommand> m_queue;
+            std::thread m_worker;
+            alignas(64) std::atomic<size_t> m_submitted;
+            alignas(64) std::atomic<size_t> m_executed;
+        };
+
+        void submit(const AccountCommand& command)
+        {
+            if (command.m_account >= m_accounts.size()) {
+                throw std::out_of_range{ "TransactionEngine: invalid account" };
+            }
+
+            Shard& shard = *m_shards[command.m_account * m_shards.size() / m_accounts.size()];
+
+            // queue is full: back pressure
+            while (!shard.m_queue.push(command)) {
+                std::this_thread::yield();
+            }
+
+            ++shard.m_submitted;
+        }
+
+        void run(size_t index)
+        {
+            Shard& shard = *m_shards[index];
+            std::vector<AccountCommand> batch(m_batchSize);
+            size_t idle = 0;
+
+            while (true) {
+
+                size_t count = 0;
+                while (count < m_batchSize and shard.m_queue.pop(batch[count])) {
+                    ++count;
+                }
+
+                if (count == 0) {
+                    if (!m_running.load() and shard.m_executed.load() == shard.m_submitted.load()) {
+                        break;
+                    }
+
+                    if (++idle < 64) {
+                        std::this_thread::yield();
+                    }
+                    else {
+                        std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    }
+                    continue;
+                }
+
+                idle = 0;
+
+                for (size_t i = 0; i < count; ++i) {
+                    const AccountCommand& command = batch[i];
+                    BankAccount& account = m_accounts[command.m_account];
+                    if (command.m_kind == AccountCommand::Kind::Deposit) {
+                        account.deposit(command.m_amount);
+                    }
+                    else {
+                        account.withdraw(command.m_amount);
+                    }
+                }
+
+                // sequentially consistent: either flush() sees the new count or we see the waiter
+                shard.m_executed.fetch_add(count);
+                if (m_waiters.load() != 0) {
+                    std::lock_guard<std::mutex> guard{ m_mutex };
+                    m_executed.notify_all();
+                }
+            }
+        }
+
+    private:
+        std::vector<BankAccount>& m_accounts;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        size_t m_batchSize;
+        std::atomic<bool> m_running;
+
+        // flush() waits for the workers
+        std::mutex m_mutex;
+        std::condition_variable m_executed;
+        std::atomic<size_t> m_waiters;
+    };
+
+    struct Transfer
+    {
+        size_t m_from;
+        size_t m_to;
+        int m_amount;
+    };
+
+    static std::vector<Transfer> createTransfers(size_t count, size_t accounts)
+    {
+        std::mt19937 generator{ 4711 };
+        std::uniform_int_distribution<size_t> account{ 0, accounts - 1 };
+        std::uniform_int_distribution<int> amount{ 1, 100 };
+
+        std::vector<Transfer> transfers;
+        transfers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            transfers.push_back({ account(generator), account(generator), amount(generator) });
+        }
+
+        return transfers;
+    }
+}
+
+void benchmarkTransactionEngine()
+{
+    using namespace TransactionEngineDemo;
+
+    constexpr size_t NumAccounts = 1024;
+    constexpr size_t NumTransfers = 2'000'000;
+
+    const std::vector<Transfer> transfers{ createTransfers(NumTransfers, NumAccounts) };
+
+    // serial: one shared_ptr command per withdrawal and deposit
+    std::vector<BankAccount> serialAccounts(NumAccounts, BankAccount{ 1000 });
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_ptr<Command>> commands;
+    commands.reserve(2 * NumTransfers);
+    for (const Transfer& transfer : transfers) {
+        commands.push_back(std::make_shared<BankAccountWithdrawCommand>(serialAccounts[transfer.m_from], transfer.m_amount));
+        commands.push_back(std::make_shared<BankAccountDepositCommand>(serialAccounts[transfer.m_to], transfer.m_amount));
+    }
+
+    Transactions transactions{ std::move(commands) };
+    transactions.execute();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "Transactions::execute:  " << NumTransfers << " transfers, "
+        << msecs << " msecs." << std::endl;
+
+    // engine: several producer threads, several workers
+    for (size_t workers : { 1, 2, 4 }) {
+
+        std::vector<BankAccount> accounts(NumAccounts, BankAccount{ 1000 });
+        constexpr size_t Producers = 4;
+
+        start = std::chrono::high_resolution_clock::now();
+
+        {
+            TransactionEngine engine{ accounts, workers };
+
+            std::vector<std::thread> producers;
+            for (size_t p = 0; p < Producers; ++p) {
+                producers.emplace_back([&engine, &transfers, p]() {
+                    for (size_t i = p; i < transfers.size(); i += Producers) {
+                        engine.transfer(transfers[i].m_from, transfers[i].m_to, transfers[i].m_amount);
+                    }
+                });
+            }
+
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+
+            engine.flush();
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+        msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+        bool equal = true;
+        for (size_t i = 0; i < NumAccounts; ++i) {
+            equal = equal and (accounts[i].getBalance() == serialAccounts[i].getBalance());
+        }
+
+        std::cout << "TransactionEngine:      " << NumTransfers << " transfers, "
+            << Producers << " producers, " << workers << " workers, "
+            << msecs << " msecs, balances are equal: " << std::boolalpha << equal << std::endl;
+    }
+
+    // latency: a single transfer on an idle engine
+    {
+        std::vector<BankAccount> accounts(NumAccounts, BankAccount{ 1000 });
+        TransactionEngine engine{ accounts, 2 };
+
+        constexpr size_t Rounds = 1000;
+        start = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < Rounds; ++i) {
+            engine.transfer(transfers[i].m_from, transfers[i].m_to, transfers[i].m_amount);
+            engine.flush();
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+        auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+        std::cout << "TransactionEngine:      average latency of a transfer: "
+            << (usecs / static_cast<long long>(Rounds)) << " usecs." << std::endl;
+    }
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
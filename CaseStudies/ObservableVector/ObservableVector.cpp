@@ -3,8 +3,14 @@
 // ===========================================================================
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace ObservableVectorDemo {
 
@@ -13,7 +19,8 @@ namespace ObservableVectorDemo {
         Add,
         Remove,
         Clear,
-        Assign
+        Assign,
+        Batch
     };
 
     std::string to_string(CollectionAction action)
@@ -28,29 +35,168 @@ namespace ObservableVectorDemo {
             return "clear";
         case CollectionAction::Assign:
             return "assign";
+        case CollectionAction::Batch:
+            return "batch";
         default:
             return "";
         }
     }
 
+    /**
+     * A range of indexes [m_first, m_first + m_count) affected by an action.
+     */
+    class IndexRange
+    {
+    public:
+        CollectionAction m_action;
+        size_t m_first;
+        size_t m_count;
+    };
+
+    /**
+     * Ranges of a change notification: a single range is stored inline,
+     * several ranges (of a batch) are referenced, not owned - so creating
+     * a notification never allocates memory.
+     * The ranges are valid during the notification only.
+     */
+    class RangeList
+    {
+    public:
+        RangeList() noexcept
+            : m_range{}, m_data{ nullptr }, m_size{} {}
+
+        explicit RangeList(const IndexRange& range) noexcept
+            : m_range{ range }, m_data{ nullptr }, m_size{ 1 } {}
+
+        RangeList(const IndexRange* data, size_t size) noexcept
+            : m_range{}, m_data{ data }, m_size{ size } {}
+
+        const IndexRange* begin() const noexcept { return m_data != nullptr ? m_data : &m_range; }
+        const IndexRange* end() const noexcept { return begin() + m_size; }
+        size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+
+    private:
+        IndexRange m_range;
+        const IndexRange* m_data;
+        size_t m_size;
+    };
+
+    /**
+     * m_action is the action of all ranges or CollectionAction::Batch,
+     * if a batch contains different actions. Ranges are reported in the
+     * order of the changes, each one refers to the indexes at the time
+     * of its change.
+     */
     class CollectionChangeNotification
     {
     public:
         CollectionAction m_action;
-        std::vector<size_t> m_indexes;
+        RangeList m_ranges;
     };
 
     class ICollectionObserver {
     public:
-        virtual void collectionChanged(CollectionChangeNotification notification) = 0;
+        virtual void collectionChanged(const CollectionChangeNotification& notification) = 0;
     };
 
+    /**
+     * Appends a change to a list of ranges,
+     * merging it with the previous range, if possible.
+     */
+    void appendRange(std::vector<IndexRange>& ranges, const IndexRange& range)
+    {
+        if (!ranges.empty()) {
+            IndexRange& last = ranges.back();
+            if (last.m_action == range.m_action) {
+                if (range.m_action == CollectionAction::Add and range.m_first == last.m_first + last.m_count) {
+                    last.m_count += range.m_count;      // e.g. push_back, push_back, ...
+                    return;
+                }
+                if (range.m_action == CollectionAction::Remove and range.m_first == last.m_first) {
+                    last.m_count += range.m_count;      // e.g. erase at the same position
+                    return;
+                }
+                if (range.m_action == CollectionAction::Remove and range.m_first + range.m_count == last.m_first) {
+                    last.m_first = range.m_first;       // e.g. pop_back, pop_back, ...
+                    last.m_count += range.m_count;
+                    return;
+                }
+            }
+        }
+
+        ranges.push_back(range);
+    }
+
+    // action of all ranges or CollectionAction::Batch
+    CollectionAction commonAction(const std::vector<IndexRange>& ranges)
+    {
+        CollectionAction action = ranges.front().m_action;
+        for (const IndexRange& range : ranges) {
+            if (range.m_action != action) {
+                return CollectionAction::Batch;
+            }
+        }
+
+        return action;
+    }
+
     template <typename T, class Allocator = std::allocator<T>>
     class ObservableVector final
     {
         typedef typename std::vector<T, Allocator>::size_type size_type;
 
     public:
+        /**
+         * RAII guard: all changes made during the lifetime of the guard are
+         * reported to the observers by one single notification.
+         * Guards can be nested, the outermost one sends the notification.
+         *
+         * commit() ends the batch explicitly, exceptions thrown by observers
+         * are propagated to the caller. Without commit(), the destructor sends
+         * the notification as a fallback: exceptions thrown by observers are
+         * swallowed there, since a destructor must not throw.
+         */
+        class BatchScope
+        {
+        public:
+            explicit BatchScope(ObservableVector& vector) : m_vector{ vector }, m_committed{ false }
+            {
+                ++m_vector.m_batchDepth;
+            }
+
+            ~BatchScope()
+            {
+                if (!m_committed) {
+                    try {
+                        commit();
+                    }
+                    catch (...) {
+                        // observers must not throw from here, use commit()
+                    }
+                }
+            }
+
+            BatchScope(const BatchScope&) = delete;
+            BatchScope& operator=(const BatchScope&) = delete;
+
+            void commit()
+            {
+                if (m_committed) {
+                    return;
+                }
+
+                m_committed = true;
+                if (--m_vector.m_batchDepth == 0) {
+                    m_vector.flushBatch();
+                }
+            }
+
+        private:
+            ObservableVector& m_vector;
+            bool m_committed;
+        };
+
         ObservableVector() noexcept(noexcept(Allocator()))
             : ObservableVector(Allocator()) {}
 
@@ -64,10 +210,10 @@ namespace ObservableVectorDemo {
             : m_data(count, alloc) {}
 
         ObservableVector(ObservableVector&& other) noexcept
-            : m_data(other.data) {}
+            : m_data(std::move(other.m_data)) {}
 
         ObservableVector(ObservableVector&& other, const Allocator& alloc)
-            : m_data(other.data, alloc) {}
+            : m_data(std::move(other.m_data), alloc) {}
 
         ObservableVector(std::initializer_list<T> init, const Allocator& alloc = Allocator())
             : m_data(init, alloc) {}
@@ -81,14 +227,7 @@ namespace ObservableVectorDemo {
             if (this != &other)
             {
                 m_data = other.m_data;
-                for (auto o : m_observers) {
-                    if (o != nullptr) {
-                        o->collectionChanged({
-                            CollectionAction::Assign,
-                            std::vector<size_t> {}
-                            });
-                    }
-                }
+                notify(CollectionAction::Assign, 0, m_data.size());
             }
             return *this;
         }
@@ -98,63 +237,73 @@ namespace ObservableVectorDemo {
             if (this != &other)
             {
                 m_data = std::move(other.m_data);
-                for (auto o : m_observers)
-                {
-                    if (o != nullptr)
-                    {
-                        o->collectionChanged({
-                            CollectionAction::Assign,
-                            std::vector<size_t> {}
-                            });
-                    }
-                }
+                notify(CollectionAction::Assign, 0, m_data.size());
             }
             return *this;
         }
 
-        void push_back(T&& value)
+        void push_back(const T& value)
         {
             m_data.push_back(value);
-            for (auto o : m_observers)
-            {
-                if (o != nullptr)
-                {
-                    o->collectionChanged({
-                        CollectionAction::Add,
-                        std::vector<size_t> {m_data.size() - 1}
-                        });
-                }
-            }
+            notify(CollectionAction::Add, m_data.size() - 1, 1);
+        }
+
+        void push_back(T&& value)
+        {
+            m_data.push_back(std::move(value));
+            notify(CollectionAction::Add, m_data.size() - 1, 1);
+        }
+
+        template<class... Args>
+        T& emplace_back(Args&&... args)
+        {
+            m_data.emplace_back(std::forward<Args>(args)...);
+            notify(CollectionAction::Add, m_data.size() - 1, 1);
+            return m_data.back();
+        }
+
+        template<class InputIt>
+        void insert(size_type pos, InputIt first, InputIt last)
+        {
+            size_type size = m_data.size();
+            m_data.insert(m_data.begin() + pos, first, last);
+            notify(CollectionAction::Add, pos, m_data.size() - size);
+        }
+
+        template<class Range>
+        void append_range(const Range& range)
+        {
+            insert(m_data.size(), std::begin(range), std::end(range));
         }
 
         void pop_back()
         {
             m_data.pop_back();
-            for (auto o : m_observers)
-            {
-                if (o != nullptr)
-                {
-                    o->collectionChanged({
-                        CollectionAction::Remove,
-                        std::vector<size_t> {m_data.size() + 1}
-                        });
-                }
-            }
+            notify(CollectionAction::Remove, m_data.size(), 1);
+        }
+
+        // removes the elements [first, last)
+        void erase(size_type first, size_type last)
+        {
+            m_data.erase(m_data.begin() + first, m_data.begin() + last);
+            notify(CollectionAction::Remove, first, last - first);
         }
 
         void clear() noexcept
         {
+            size_type size = m_data.size();
             m_data.clear();
-            for (auto o : m_observers)
-            {
-                if (o != nullptr)
-                {
-                    o->collectionChanged({
-                        CollectionAction::Clear,
-                        std::vector<size_t> {}
-                        });
-                }
-            }
+            notify(CollectionAction::Clear, 0, size);
+        }
+
+        void reserve(size_type capacity)
+        {
+            m_data.reserve(capacity);
+        }
+
+        const T& operator[](size_type pos) const
+        {
+            return m_data[pos];
         }
 
         size_type size() const noexcept
@@ -180,26 +329,336 @@ namespace ObservableVectorDemo {
             );
         }
 
+    private:
+        void notify(CollectionAction action, size_t first, size_t count)
+        {
+            if (m_batchDepth == 0) {
+                notify({ action, RangeList{ IndexRange{ action, first, count } } });
+                return;
+            }
+
+            appendRange(m_batch, IndexRange{ action, first, count });
+        }
+
+        void flushBatch()
+        {
+            if (m_batch.empty()) {
+                return;
+            }
+
+            try {
+                notify({ commonAction(m_batch), RangeList{ m_batch.data(), m_batch.size() } });
+            }
+            catch (...) {
+                m_batch.clear();
+                throw;
+            }
+
+            // keeps the capacity for the next batch
+            m_batch.clear();
+        }
+
+        // one notification object is shared by all observers
+        void notify(const CollectionChangeNotification& notification)
+        {
+            for (auto o : m_observers)
+            {
+                if (o != nullptr)
+                {
+                    o->collectionChanged(notification);
+                }
+            }
+        }
+
     private:
         std::vector<T, Allocator> m_data;
         std::vector<ICollectionObserver*> m_observers;
+        std::vector<IndexRange> m_batch;
+        size_t m_batchDepth = 0;
+    };
+
+    /**
+     * Thread-safe variant of ObservableVector:
+     *
+     * Mutations are NOT concurrent: one mutex (m_mutex) serializes all of
+     * them, as well as size() and at(). Every change depends on the current
+     * size of the vector and the change log must keep the order of the changes,
+     * so neither finer-grained locking nor a lock-free log would let two
+     * producers proceed in parallel. Instead, the mutex is held only for the
+     * change of the data and for appending the change to the change log
+     * (merged with the previous range, if possible - no allocation per change).
+     * A dispatcher thread swaps the change log for an empty vector under the
+     * same mutex and notifies the observers with one notification per swapped
+     * log - producers never wait for observers, but they contend with each
+     * other and, briefly, with the dispatcher.
+     *
+     * Lock-free is the observer side only: the observer list is copy-on-write,
+     * addObserver/removeObserver publish a new immutable list, the dispatcher
+     * reads it without any lock. Old lists are freed by the dispatcher itself
+     * between two batches. All observers are called on the dispatcher thread.
+     */
+    template <typename T>
+    class ConcurrentObservableVector final
+    {
+        typedef typename std::vector<T>::size_type size_type;
+        typedef std::vector<ICollectionObserver*> ObserverList;
+
+    public:
+        ConcurrentObservableVector()
+            : m_pending{ 0 },
+              m_observers{ new ObserverList{} },
+              m_hasRetired{ false },
+              m_running{ true },
+              m_epoch{ 0 },
+              m_logged{ 0 },
+              m_dispatched{ 0 }
+        {
+            m_dispatcher = std::thread{ &ConcurrentObservableVector::dispatch, this };
+        }
+
+        ~ConcurrentObservableVector()
+        {
+            m_running = false;
+            m_dispatcher.join();
+
+            delete m_observers.load();
+            for (const ObserverList* list : m_retired) {
+                delete list;
+            }
+        }
+
+        ConcurrentObservableVector(const ConcurrentObservableVector&) = delete;
+        ConcurrentObservableVector& operator=(const ConcurrentObservableVector&) = delete;
+
+        void push_back(const T& value)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            m_data.push_back(value);
+            log(CollectionAction::Add, m_data.size() - 1, 1);
+        }
+
+        void push_back(T&& value)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            m_data.push_back(std::move(value));
+            log(CollectionAction::Add, m_data.size() - 1, 1);
+        }
+
+        template<class... Args>
+        void emplace_back(Args&&... args)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            m_data.emplace_back(std::forward<Args>(args)...);
+            log(CollectionAction::Add, m_data.size() - 1, 1);
+        }
+
+        void pop_back()
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            m_data.pop_back();
+            log(CollectionAction::Remove, m_data.size(), 1);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            size_type size = m_data.size();
+            m_data.clear();
+            log(CollectionAction::Clear, 0, size);
+        }
+
+        size_type size() const
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            return m_data.size();
+        }
+
+        // returns a copy: the element may be changed by other threads
+        T at(size_type pos) const
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            return m_data.at(pos);
+        }
+
+        void addObserver(ICollectionObserver* o)
+        {
+            std::lock_guard<std::mutex> guard{ m_observersMutex };
+            ObserverList* list = new ObserverList{ *m_observers.load() };
+            list->push_back(o);
+            publish(list);
+        }
+
+        // when this method returns, the dispatcher doesn't use 'o' anymore
+        // (unless it is called by an observer on the dispatcher thread)
+        void removeObserver(const ICollectionObserver* o)
+        {
+            size_t epoch = 0;
+            {
+                std::lock_guard<std::mutex> guard{ m_observersMutex };
+                ObserverList* list = new ObserverList{ *m_observers.load() };
+                list->erase(
+                    std::remove(std::begin(*list), std::end(*list), o),
+                    std::end(*list)
+                );
+                publish(list);
+                epoch = m_epoch.load();
+            }
+
+            if (std::this_thread::get_id() != m_dispatcher.get_id()) {
+                // grace period: the dispatcher has started a new batch
+                while (m_epoch.load() == epoch) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // waits until all changes logged so far have been dispatched
+        void flush()
+        {
+            size_t logged = m_logged.load();
+            while (m_dispatched.load() < logged) {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        // called with m_mutex held: keeps the change log in the order of the changes
+        void log(CollectionAction action, size_t first, size_t count)
+        {
+            appendRange(m_log, IndexRange{ action, first, count });
+            ++m_pending;
+            m_logged.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // called with m_observersMutex held
+        void publish(ObserverList* list)
+        {
+            const ObserverList* old = m_observers.exchange(list, std::memory_order_acq_rel);
+            m_retired.push_back(old);
+            m_hasRetired = true;
+        }
+
+        void dispatch()
+        {
+            std::vector<IndexRange> batch;
+            size_t idle = 0;
+
+            while (true) {
+
+                // quiescent state: no observer list is in use
+                ++m_epoch;
+                if (m_hasRetired.load()) {
+                    std::lock_guard<std::mutex> guard{ m_observersMutex };
+                    for (const ObserverList* list : m_retired) {
+                        delete list;
+                    }
+                    m_retired.clear();
+                    m_hasRetired = false;
+                }
+
+                // take the whole change log, both vectors keep their capacity
+                batch.clear();
+                size_t count = 0;
+                {
+                    std::lock_guard<std::mutex> guard{ m_mutex };
+                    m_log.swap(batch);
+                    count = m_pending;
+                    m_pending = 0;
+                }
+
+                if (count == 0) {
+                    if (!m_running.load() and m_dispatched.load() == m_logged.load()) {
+                        break;
+                    }
+
+                    // back off: spin a little, then sleep
+                    if (++idle < 64) {
+                        std::this_thread::yield();
+                    }
+                    else {
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    }
+                    continue;
+                }
+
+                idle = 0;
+
+                const CollectionChangeNotification notification{
+                    commonAction(batch),
+                    RangeList{ batch.data(), batch.size() }
+                };
+
+                const ObserverList* observers = m_observers.load(std::memory_order_acquire);
+                for (ICollectionObserver* o : *observers) {
+                    if (o != nullptr) {
+                        o->collectionChanged(notification);
+                    }
+                }
+
+                m_dispatched += count;
+            }
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<T> m_data;
+        std::vector<IndexRange> m_log;     // guarded by m_mutex
+        size_t m_pending;                  // changes in m_log
+
+        std::atomic<const ObserverList*> m_observers;
+        std::mutex m_observersMutex;
+        std::vector<const ObserverList*> m_retired;
+        std::atomic<bool> m_hasRetired;
+
+        std::thread m_dispatcher;
+        std::atomic<bool> m_running;
+        std::atomic<size_t> m_epoch;
+        std::atomic<size_t> m_logged;
+        std::atomic<size_t> m_dispatched;
     };
 
     class Observer : public ICollectionObserver
     {
     public:
-        virtual void collectionChanged(CollectionChangeNotification notification) override
+        virtual void collectionChanged(const CollectionChangeNotification& notification) override
         {
             std::cout << "action: " << to_string(notification.m_action);
-            if (!notification.m_indexes.empty()) {
-                std::cout << ", indexes: ";
-                for (auto i : notification.m_indexes)
-                    std::cout << i << ' ';
+            if (!notification.m_ranges.empty()) {
+                std::cout << ", ranges: ";
+                for (const auto& range : notification.m_ranges) {
+                    if (notification.m_action == CollectionAction::Batch)
+                        std::cout << to_string(range.m_action) << ' ';
+                    std::cout << '[' << range.m_first << ", "
+                        << (range.m_first + range.m_count) << ") ";
+                }
             }
             std::cout << std::endl;
         }
     };
 
+    class ThrowingObserver : public ICollectionObserver
+    {
+    public:
+        virtual void collectionChanged(const CollectionChangeNotification&) override
+        {
+            throw std::runtime_error{ "observer failed" };
+        }
+    };
+
+    class CountingObserver : public ICollectionObserver
+    {
+    public:
+        CountingObserver() : m_count{} {}
+
+        virtual void collectionChanged(const CollectionChangeNotification& notification) override
+        {
+            for (const auto& range : notification.m_ranges) {
+                m_count += range.m_count;
+            }
+        }
+
+        size_t m_count;
+    };
 }
 
 void testObservableVector() 
@@ -222,6 +681,144 @@ void testObservableVector()
     v = ObservableVector<int>{ 7,8,9 };
 }
 
+void testObservableVectorBatch()
+{
+    using namespace ObservableVectorDemo;
+
+    ObservableVector<int> v;
+    Observer o;
+    v.addObserver(&o);
+
+    std::vector<int> values{ 1, 2, 3, 4, 5 };
+    v.append_range(values);
+    v.insert(1, values.begin(), values.begin() + 2);
+    v.erase(0, 3);
+
+    {
+        ObservableVector<int>::BatchScope batch{ v };
+        v.reserve(100);
+        for (int i = 0; i < 10; ++i) {
+            v.emplace_back(i);
+        }
+    }
+
+    {
+        ObservableVector<int>::BatchScope batch{ v };
+        v.pop_back();
+        v.pop_back();
+        v.push_back(123);
+        v.append_range(values);
+        batch.commit();
+    }
+
+    // commit() reports a failing observer, the destructor would swallow the exception
+    ThrowingObserver failing;
+    v.addObserver(&failing);
+
+    try {
+        ObservableVector<int>::BatchScope batch{ v };
+        v.push_back(456);
+        batch.commit();
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << "commit: " << e.what() << std::endl;
+    }
+
+    v.removeObserver(&failing);
+}
+
+void benchmarkObservableVector()
+{
+    using namespace ObservableVectorDemo;
+
+    constexpr size_t Count = 10'000'000;
+
+    ObservableVector<int> v;
+    CountingObserver o1, o2, o3;
+    v.addObserver(&o1);
+    v.addObserver(&o2);
+    v.addObserver(&o3);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < Count; ++i) {
+        v.push_back(static_cast<int>(i));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "push_back: " << Count << " elements, 3 observers, "
+        << (o1.m_count + o2.m_count + o3.m_count) << " notified indexes, "
+        << msecs << " msecs." << std::endl;
+
+    // same with one single notification
+    v.clear();
+    o1.m_count = o2.m_count = o3.m_count = 0;
+
+    start = std::chrono::high_resolution_clock::now();
+
+    {
+        ObservableVector<int>::BatchScope batch{ v };
+        v.reserve(Count);
+        for (size_t i = 0; i < Count; ++i) {
+            v.emplace_back(static_cast<int>(i));
+        }
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "BatchScope: " << Count << " elements, 3 observers, "
+        << (o1.m_count + o2.m_count + o3.m_count) << " notified indexes, "
+        << msecs << " msecs." << std::endl;
+}
+
+void benchmarkConcurrentObservableVector()
+{
+    using namespace ObservableVectorDemo;
+
+    constexpr size_t Count = 4'000'000;
+
+    for (size_t producers : { 1, 2, 4, 8 }) {
+
+        ConcurrentObservableVector<int> v;
+        CountingObserver o1, o2, o3;
+        v.addObserver(&o1);
+        v.addObserver(&o2);
+        v.addObserver(&o3);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&v, producers]() {
+                for (size_t i = 0; i < Count / producers; ++i) {
+                    v.push_back(static_cast<int>(i));
+                }
+            });
+        }
+
+        for (std::thread& t : threads) {
+            t.join();
+        }
+
+        v.flush();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+        v.removeObserver(&o1);
+        v.removeObserver(&o2);
+        v.removeObserver(&o3);
+
+        std::cout << "Producers: " << producers << ", elements: " << v.size()
+            << ", notified indexes: " << (o1.m_count + o2.m_count + o3.m_count)
+            << ", " << msecs << " msecs, "
+            << (msecs > 0 ? Count / static_cast<size_t>(msecs) * 1000 : Count) << " elements/sec." << std::endl;
+    }
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -4,9 +4,15 @@
 
 // function prototypes
 extern void testObservableVector();
+extern void testObservableVectorBatch();
+extern void benchmarkObservableVector();
+extern void benchmarkConcurrentObservableVector();
 
 int main() {
     testObservableVector();
+    testObservableVectorBatch();
+    benchmarkObservableVector();
+    benchmarkConcurrentObservableVector();
     return 0;
 }
 
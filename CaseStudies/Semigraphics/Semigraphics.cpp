@@ -2,11 +2,14 @@
 // Semigraphics.cpp
 // ===========================================================================
 
+// the flyweight pool is shared with the Flyweight pattern examples
+#include "../../Patterns/Flyweight/FlyweightPool.h"
+
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <array>
-#include <unordered_map>
 #include <random>
 
 // ===========================================================================
@@ -25,8 +28,8 @@ public:
         : m_color{ color }, m_font{ font } {}
 
     // getter
-    std::string getColor() const { return m_color; }
-    std::string getFont() const { return m_font; }
+    const std::string& getColor() const { return m_color; }
+    const std::string& getFont() const { return m_font; }
 
     friend std::ostream& operator<<(std::ostream&, const Character&);
 };
@@ -38,88 +41,111 @@ std::ostream& operator<<(std::ostream& os, const Character& ch)
 
 // ===========================================================================
 
+class CharacterFactory;
+
 class ConcreteCharacter
 {
 private:
-    std::shared_ptr<Character> m_sharedState;
+    const CharacterFactory* m_factory;
+    FlyweightPool::Handle m_sharedState;
 
 public:
-    ConcreteCharacter() = default;
-    explicit ConcreteCharacter(const std::shared_ptr<Character>& state) 
-        : m_sharedState{ state } {}
+    ConcreteCharacter() : m_factory{ nullptr }, m_sharedState{} {}
+    ConcreteCharacter(const CharacterFactory& factory, FlyweightPool::Handle state)
+        : m_factory{ &factory }, m_sharedState{ state } {}
     ~ConcreteCharacter() = default;
 
     void render(int x, int y) const noexcept;
     friend std::ostream& operator<<(std::ostream&, const ConcreteCharacter&);
 };
 
-void ConcreteCharacter::render(int x, int y) const noexcept {
-    std::cout 
-        << "Character: Position (" << x << ", " << y <<
-        ") with shared state " << *m_sharedState << std::endl;
-}
+// ===========================================================================
 
-std::ostream& operator<<(std::ostream& os, const ConcreteCharacter& cc)
+// non-owning view of the intrinsic state of a character
+struct CharacterKey
 {
-    return os << "[ConcreteCharacter: " << *cc.m_sharedState << "]";
-}
+    std::string_view m_color;
+    std::string_view m_font;
+};
 
-// ===========================================================================
+struct CharacterTraits
+{
+    static std::size_t hash(const CharacterKey& key) noexcept {
+        return FlyweightPool::hashStrings({ key.m_color, key.m_font });
+    }
+
+    static bool equal(const Character& ch, const CharacterKey& key) noexcept {
+        return ch.getColor() == key.m_color && ch.getFont() == key.m_font;
+    }
+
+    static Character make(const CharacterKey& key) {
+        return Character{ std::string{ key.m_color }, std::string{ key.m_font } };
+    }
+};
 
 class CharacterFactory {
 private:
-    std::unordered_map<std::string, std::shared_ptr<Character>> m_characterMap;
+    FlyweightPool::ShardedFlyweightPool<Character, CharacterTraits> m_characters;
 
 public:
-    void addCharacter(const std::string& color, const std::string& font);
-    ConcreteCharacter getConcreteCharacter(const std::string& color, const std::string& font);
-    std::string getKey(const std::string& color, const std::string& font) const;
+    void addCharacter(std::string_view color, std::string_view font);
+    ConcreteCharacter getConcreteCharacter(std::string_view color, std::string_view font);
+    const Character& getCharacter(FlyweightPool::Handle handle) const noexcept;
     friend std::ostream& operator<<(std::ostream&, const CharacterFactory&);
 };
 
 // returns an ConcreteCharacter with a given state or creates a new one
-ConcreteCharacter CharacterFactory::getConcreteCharacter(const std::string& color, const std::string& font) {
+ConcreteCharacter CharacterFactory::getConcreteCharacter(std::string_view color, std::string_view font) {
 
-    std::string key = getKey(color, font);
+    bool inserted{};
+    FlyweightPool::Handle handle{ m_characters.acquire(CharacterKey{ color, font }, inserted) };
 
-    if (m_characterMap.find(key) == m_characterMap.end()) {
+    if (inserted) {
         std::cout << "CharacterFactory: Can't find this character, creating new one." << std::endl;
-        std::shared_ptr<Character> chptr = std::make_shared<Character>(color, font);
-        m_characterMap[key] = chptr;
     }
     else {
         std::cout << "CharacterFactory: Reusing existing character." << std::endl;
     }
 
-    std::shared_ptr<Character> ptr = m_characterMap.at(key);
-    return ConcreteCharacter(ptr);
+    return ConcreteCharacter(*this, handle);
 }
 
-
-std::string CharacterFactory::getKey(const std::string& color, const std::string& font) const
+const Character& CharacterFactory::getCharacter(FlyweightPool::Handle handle) const noexcept
 {
-    return color + "_" + font;     // returns a hash for a given intrinsic state
+    return m_characters.get(handle);
 }
 
-void CharacterFactory::addCharacter(const std::string& color, const std::string& font)
+void CharacterFactory::addCharacter(std::string_view color, std::string_view font)
 {
-    std::string key = getKey(color, font);
-    m_characterMap[key] = std::make_shared<Character>(color, font);;
+    m_characters.acquire(CharacterKey{ color, font });
 }
 
 std::ostream& operator<<(std::ostream& os, const CharacterFactory& factory) {
-    size_t count = factory.m_characterMap.size();
+    size_t count = factory.m_characters.size();
     os << "CharacterFactory: " << count << " characters:" << std::endl;
 
-    for (std::pair<std::string, std::shared_ptr<Character>> ch : factory.m_characterMap) {
-        os << ch.first << " => " << *ch.second << std::endl;
-    }
+    factory.m_characters.forEach([&](FlyweightPool::Handle handle, const Character& ch) {
+        os << handle.id() << " => " << ch << std::endl;
+    });
 
     return os;
 }
 
 // ===========================================================================
 
+void ConcreteCharacter::render(int x, int y) const noexcept {
+    std::cout 
+        << "Character: Position (" << x << ", " << y <<
+        ") with shared state " << m_factory->getCharacter(m_sharedState) << std::endl;
+}
+
+std::ostream& operator<<(std::ostream& os, const ConcreteCharacter& cc)
+{
+    return os << "[ConcreteCharacter: " << cc.m_factory->getCharacter(cc.m_sharedState) << "]";
+}
+
+// ===========================================================================
+
 class CharacterClient {
 private:
     std::array<std::string, 7> m_colors;
@@ -1,7 +1,8 @@
 // ===========================================================================
-// FileTypeStrategy.cpp
+// ASyncTestStrategy.cpp
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
@@ -15,32 +16,45 @@
 //#include <map>
 //#include <list>
 #include <algorithm>
-#include <thread> 
+#include <iterator>
+#include <thread>
 #include <chrono>
 
 // ===========================================================================
 
 void ASyncTestStrategy::explore(const std::string& path)
 {
-    std::thread t([this]() {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            onFinish();
-        });
+    constexpr const char* extensions[] = { ".cpp", ".h", ".md", ".svg", ".txt" };
 
-    t.detach();
-}
+    beginExploration();
+
+    m_explorationResult.clear();
+    beginProgress(1);
+
+    for (size_t i = 0; i < m_entries and !m_cancelled; ++i) {
 
-void ASyncTestStrategy::exploreHelper(const std::string& path) {
+        const std::string ext{ extensions[i % std::size(extensions)] };
+        const uint64_t size{ 100 + i % 1000 };
 
+        m_explorationResult.add(ext, size);
+        reportProgress(0, ext, size);
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    endProgress();
+    onFinish();
 }
 
 void ASyncTestStrategy::printResults() {
 
+    const std::vector<ExplorationResult::Entry> entries{ m_explorationResult.sorted() };
+
     std::for_each(
-        std::begin(m_explorationResult),
-        std::end(m_explorationResult),
-        [](const std::pair<std::string, long>& entry) {
-            std::cout << "Ext: " << entry.first << " - Total Sizes: " << entry.second << '\n';
+        std::begin(entries),
+        std::end(entries),
+        [](const ExplorationResult::Entry& entry) {
+            std::cout << "Ext: " << entry.m_key << " - Total Sizes: " << entry.m_size << '\n';
         }
     );
 }
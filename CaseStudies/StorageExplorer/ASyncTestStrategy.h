@@ -4,17 +4,21 @@
 
 #include <string>
 
+/* Test strategy without any file system access: simulates a slow
+ * exploration of 'entries' files to test asynchronous exploration,
+ * progress notifications and cancellation.
+ */
 class ASyncTestStrategy : public ExplorationStrategy
 {
+private:
+    size_t m_entries;
+
 public:
-    ASyncTestStrategy() = default;
+    explicit ASyncTestStrategy(size_t entries = 10000) : m_entries{ entries } {}
     ~ASyncTestStrategy() = default;
 
     void explore(const std::string& path) override;
     void printResults() override;
-
-private:
-    void exploreHelper(const std::string& path);
 };
 
 // ===========================================================================
@@ -2,10 +2,12 @@
 // ExplorationObserver.cpp
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
 
+#include "TraversalEngine.h"
 #include "ExplorationStrategy.h"
 #include "FileTypeStrategy.h"
 #include "FolderStrategy.h"
@@ -18,10 +20,15 @@
 
 // ===========================================================================
 
-void ExplorationObserver::update(std::map<std::string, long> result) {
+void ExplorationObserver::update(const ExplorationResult& result) {
     std::cout << "Done: received " << result.size() << " results!" << std::endl;
 }
 
+void ExplorationObserver::progress(const ExplorationProgress& progress) {
+    std::cout << "Progress: " << progress.m_entries << " entries, "
+        << progress.m_delta.size() << " changes" << std::endl;
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -3,11 +3,11 @@
 // ===========================================================================
 
 #include <string>
-#include <map>
 
 class ExplorationObserver : public IExplorationObserver {
 public:
-    void update(std::map<std::string, long>) override;
+    void update(const ExplorationResult&) override;
+    void progress(const ExplorationProgress&) override;
 };
 
 // ===========================================================================
@@ -0,0 +1,207 @@
+// ===========================================================================
+// ExplorationResult.cpp
+// ===========================================================================
+
+#include "ExplorationResult.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ===========================================================================
+
+ExplorationResult::ExplorationResult() : m_block{ nullptr }, m_blockUsed{ 0 } {}
+
+ExplorationResult::ExplorationResult(const ExplorationResult& other) : ExplorationResult{}
+{
+    merge(other);
+}
+
+ExplorationResult::ExplorationResult(ExplorationResult&& other) noexcept
+    : m_blocks{ std::move(other.m_blocks) },
+      m_block{ other.m_block },
+      m_blockUsed{ other.m_blockUsed },
+      m_entries{ std::move(other.m_entries) },
+      m_slots{ std::move(other.m_slots) }
+{
+    other.clear();
+}
+
+ExplorationResult& ExplorationResult::operator=(const ExplorationResult& other)
+{
+    if (this != &other) {
+        clear();
+        merge(other);
+    }
+
+    return *this;
+}
+
+ExplorationResult& ExplorationResult::operator=(ExplorationResult&& other) noexcept
+{
+    if (this != &other) {
+        m_blocks = std::move(other.m_blocks);
+        m_block = other.m_block;
+        m_blockUsed = other.m_blockUsed;
+        m_entries = std::move(other.m_entries);
+        m_slots = std::move(other.m_slots);
+        other.clear();
+    }
+
+    return *this;
+}
+
+void ExplorationResult::add(std::string_view key, uint64_t size)
+{
+    findOrInsert(key).m_size += size;
+}
+
+uint64_t& ExplorationResult::operator[](std::string_view key)
+{
+    return findOrInsert(key).m_size;
+}
+
+const ExplorationResult::Entry* ExplorationResult::find(std::string_view key) const
+{
+    if (m_slots.empty()) {
+        return nullptr;
+    }
+
+    const uint64_t h = hash(key);
+    const size_t mask = m_slots.size() - 1;
+
+    for (size_t i = static_cast<size_t>(h) & mask; m_slots[i].m_index != 0; i = (i + 1) & mask) {
+        const Slot& slot = m_slots[i];
+        if (slot.m_hash == h and m_entries[slot.m_index - 1].m_key == key) {
+            return &m_entries[slot.m_index - 1];
+        }
+    }
+
+    return nullptr;
+}
+
+ExplorationResult::Entry* ExplorationResult::find(std::string_view key)
+{
+    return const_cast<Entry*>(static_cast<const ExplorationResult&>(*this).find(key));
+}
+
+void ExplorationResult::merge(const ExplorationResult& other)
+{
+    reserve(m_entries.size() + other.m_entries.size());
+
+    for (const Entry& entry : other.m_entries) {
+        add(entry.m_key, entry.m_size);
+    }
+}
+
+void ExplorationResult::clear()
+{
+    m_blocks.clear();
+    m_block = nullptr;
+    m_blockUsed = 0;
+    m_entries.clear();
+    m_slots.clear();
+}
+
+void ExplorationResult::reserve(size_t count)
+{
+    m_entries.reserve(count);
+
+    // load factor <= 0.5
+    if (2 * count > m_slots.size()) {
+        size_t slots = 16;
+        while (slots < 2 * count) {
+            slots *= 2;
+        }
+        rehash(slots);
+    }
+}
+
+std::vector<ExplorationResult::Entry> ExplorationResult::sorted() const
+{
+    std::vector<Entry> entries{ m_entries };
+
+    std::sort(
+        std::begin(entries),
+        std::end(entries),
+        [](const Entry& lhs, const Entry& rhs) { return lhs.m_key < rhs.m_key; }
+    );
+
+    return entries;
+}
+
+ExplorationResult::Entry& ExplorationResult::findOrInsert(std::string_view key)
+{
+    if (2 * (m_entries.size() + 1) > m_slots.size()) {
+        rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+    }
+
+    const uint64_t h = hash(key);
+    const size_t mask = m_slots.size() - 1;
+
+    size_t i = static_cast<size_t>(h) & mask;
+    for (; m_slots[i].m_index != 0; i = (i + 1) & mask) {
+        const Slot& slot = m_slots[i];
+        if (slot.m_hash == h and m_entries[slot.m_index - 1].m_key == key) {
+            return m_entries[slot.m_index - 1];
+        }
+    }
+
+    m_entries.push_back(Entry{ intern(key), 0 });
+    m_slots[i] = Slot{ h, static_cast<uint32_t>(m_entries.size()) };
+    return m_entries.back();
+}
+
+std::string_view ExplorationResult::intern(std::string_view key)
+{
+    char* data = nullptr;
+
+    if (key.size() > BlockSize / 4) {
+        // large keys get a block of their own
+        m_blocks.push_back(std::make_unique<char[]>(key.size()));
+        data = m_blocks.back().get();
+    }
+    else {
+        if (m_block == nullptr or m_blockUsed + key.size() > BlockSize) {
+            m_blocks.push_back(std::make_unique<char[]>(BlockSize));
+            m_block = m_blocks.back().get();
+            m_blockUsed = 0;
+        }
+
+        data = m_block + m_blockUsed;
+        m_blockUsed += key.size();
+    }
+
+    std::memcpy(data, key.data(), key.size());
+    return std::string_view{ data, key.size() };
+}
+
+void ExplorationResult::rehash(size_t slots)
+{
+    m_slots.assign(slots, Slot{ 0, 0 });
+    const size_t mask = slots - 1;
+
+    for (size_t index = 0; index < m_entries.size(); ++index) {
+        const uint64_t h = hash(m_entries[index].m_key);
+        size_t i = static_cast<size_t>(h) & mask;
+        while (m_slots[i].m_index != 0) {
+            i = (i + 1) & mask;
+        }
+        m_slots[i] = Slot{ h, static_cast<uint32_t>(index + 1) };
+    }
+}
+
+// FNV-1a
+uint64_t ExplorationResult::hash(std::string_view key)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (char ch : key) {
+        h ^= static_cast<unsigned char>(ch);
+        h *= 1099511628211ull;
+    }
+
+    return h;
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -0,0 +1,83 @@
+// ===========================================================================
+// ExplorationResult.h
+// ===========================================================================
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Result store of an exploration: key (folder name or file type) : size.
+ *
+ * Keys are interned once in an arena (a list of large character blocks),
+ * entries are kept in a contiguous vector, and an open-addressing hash
+ * table (linear probing) maps keys to entries. Updating an existing key
+ * doesn't allocate anything, so this is considerably cheaper than a
+ * std::map<std::string, long> for millions of updates.
+ */
+class ExplorationResult
+{
+public:
+    struct Entry
+    {
+        std::string_view m_key;     // points into the arena
+        uint64_t m_size;
+    };
+
+private:
+    struct Slot
+    {
+        uint64_t m_hash;
+        uint32_t m_index;           // index of entry + 1, 0: empty slot
+    };
+
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char* m_block;                  // current block
+    size_t m_blockUsed;
+    std::vector<Entry> m_entries;
+    std::vector<Slot> m_slots;
+
+public:
+    ExplorationResult();
+    ExplorationResult(const ExplorationResult& other);
+    ExplorationResult(ExplorationResult&& other) noexcept;
+    ExplorationResult& operator=(const ExplorationResult& other);
+    ExplorationResult& operator=(ExplorationResult&& other) noexcept;
+    ~ExplorationResult() = default;
+
+    // adds 'size' to the entry of 'key', the entry is created if necessary
+    void add(std::string_view key, uint64_t size);
+    uint64_t& operator[](std::string_view key);
+
+    // returns nullptr, if 'key' doesn't exist
+    const Entry* find(std::string_view key) const;
+    Entry* find(std::string_view key);
+
+    void merge(const ExplorationResult& other);
+    void clear();
+    void reserve(size_t count);
+
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    // read-only iteration in insertion order
+    std::vector<Entry>::const_iterator begin() const { return m_entries.cbegin(); }
+    std::vector<Entry>::const_iterator end() const { return m_entries.cend(); }
+
+    // entries sorted by key, e.g. for printing
+    std::vector<Entry> sorted() const;
+
+private:
+    Entry& findOrInsert(std::string_view key);
+    std::string_view intern(std::string_view key);
+    void rehash(size_t slots);
+
+    static uint64_t hash(std::string_view key);
+};
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -0,0 +1,275 @@
+// ===========================================================================
+// ExplorationSnapshot.cpp
+// ===========================================================================
+
+#include "TraversalEngine.h"
+#include "ExplorationSnapshot.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+// ===========================================================================
+
+// file format: header, root, number of directories, directory records
+static constexpr char SnapshotHeader[8] = { 'S', 'E', 'S', 'N', 'A', 'P', '0', '3' };
+
+// function prototypes
+template <typename T>
+static void write(std::ostream& os, T value);
+static void write(std::ostream& os, const std::string& value);
+template <typename T>
+static bool read(std::istream& is, T& value);
+static bool read(std::istream& is, std::string& value);
+static int64_t lastWriteTime(const std::filesystem::directory_entry& entry, std::error_code& ec);
+static bool equalFiles(const std::vector<ExplorationSnapshot::FileRecord>& lhs,
+    const std::vector<ExplorationSnapshot::FileRecord>& rhs);
+
+// ===========================================================================
+
+void ExplorationSnapshot::scan(
+    TraversalEngine& engine,
+    const std::string& root,
+    const ExplorationSnapshot* previous,
+    const TraversalEngine::DirectoryVisitor& filter,
+    const DirectoryVisitor& onRecord,
+    const std::atomic<bool>* cancelled)
+{
+    if (previous != nullptr and previous->m_root != root) {
+        previous = nullptr;
+    }
+
+    // per worker: directory => record, a directory is handled by one worker only
+    std::vector<std::map<std::string, DirectoryRecord>> partials(engine.threads());
+    std::vector<Statistics> statistics(engine.threads(), Statistics{ 0, 0, 0 });
+
+    auto onFile = [&](size_t worker, const std::filesystem::directory_entry& entry) {
+
+        // size and modification time of the same (cached) directory entry
+        ++statistics[worker].m_statCalls;
+
+        std::error_code ec;
+        uintmax_t size = entry.file_size(ec);
+        if (ec) {
+            std::cout << entry.path().string() << ": " << ec.message() << '\n';
+            return;
+        }
+
+        int64_t mtime = lastWriteTime(entry, ec);
+
+        DirectoryRecord& record = partials[worker][entry.path().parent_path().string()];
+        record.m_files.push_back(FileRecord{ entry.path().filename().string(), size, ec ? 0 : mtime });
+    };
+
+    // the directory has been listed: compare its files with the previous snapshot
+    auto onLeave = [&](size_t worker, const std::filesystem::path& directory) {
+
+        const std::string key{ directory.string() };
+        DirectoryRecord& record = partials[worker][key];
+
+        std::sort(
+            std::begin(record.m_files),
+            std::end(record.m_files),
+            [](const FileRecord& lhs, const FileRecord& rhs) { return lhs.m_name < rhs.m_name; }
+        );
+
+        const DirectoryRecord* old{ nullptr };
+        if (previous != nullptr) {
+            auto pos = previous->m_directories.find(key);
+            if (pos != previous->m_directories.end()) {
+                old = &pos->second;
+            }
+        }
+
+        if (old != nullptr and equalFiles(old->m_files, record.m_files)) {
+
+            // unchanged: take the totals from the previous snapshot
+            record.m_size = old->m_size;
+            record.m_extensions = old->m_extensions;
+            ++statistics[worker].m_reused;
+        }
+        else {
+
+            record.m_size = 0;
+            record.m_extensions.clear();
+            for (const FileRecord& file : record.m_files) {
+                record.m_size += file.m_size;
+                record.m_extensions[std::filesystem::path{ file.m_name }.extension().string()] += file.m_size;
+            }
+            ++statistics[worker].m_scanned;
+        }
+
+        if (onRecord) {
+            onRecord(worker, key, record);
+        }
+    };
+
+    // a trailing separator would break the parent_path() lookups above
+    std::filesystem::path rootPath{ root };
+    if (!rootPath.has_filename() and rootPath.has_relative_path()) {
+        rootPath = rootPath.parent_path();
+    }
+
+    engine.traverse(rootPath.string(), onFile, filter, onLeave, cancelled);
+
+    // merge partial results
+    m_root = root;
+    m_directories.clear();
+    m_statistics = Statistics{ 0, 0, 0 };
+
+    for (std::map<std::string, DirectoryRecord>& partial : partials) {
+        m_directories.merge(partial);
+    }
+
+    for (const Statistics& s : statistics) {
+        m_statistics.m_reused += s.m_reused;
+        m_statistics.m_scanned += s.m_scanned;
+        m_statistics.m_statCalls += s.m_statCalls;
+    }
+}
+
+bool ExplorationSnapshot::load(const std::string& fileName)
+{
+    std::ifstream is{ fileName, std::ios::binary };
+    if (!is) {
+        return false;
+    }
+
+    char header[sizeof(SnapshotHeader)]{};
+    if (!is.read(header, sizeof(header)) or
+        !std::equal(std::begin(header), std::end(header), std::begin(SnapshotHeader))) {
+        std::cout << fileName << ": no exploration snapshot" << '\n';
+        return false;
+    }
+
+    std::string root;
+    uint64_t count = 0;
+    if (!read(is, root) or !read(is, count)) {
+        return false;
+    }
+
+    std::map<std::string, DirectoryRecord> directories;
+
+    for (uint64_t i = 0; i < count; ++i) {
+
+        std::string path;
+        DirectoryRecord record{ 0, {}, {} };
+        uint64_t extensions = 0;
+
+        if (!read(is, path) or !read(is, record.m_size) or !read(is, extensions)) {
+            return false;
+        }
+
+        for (uint64_t k = 0; k < extensions; ++k) {
+            std::string ext;
+            uint64_t size = 0;
+            if (!read(is, ext) or !read(is, size)) {
+                return false;
+            }
+            record.m_extensions.emplace_hint(record.m_extensions.end(), std::move(ext), size);
+        }
+
+        uint64_t files = 0;
+        if (!read(is, files)) {
+            return false;
+        }
+
+        record.m_files.resize(static_cast<size_t>(files));
+        for (FileRecord& file : record.m_files) {
+            if (!read(is, file.m_name) or !read(is, file.m_size) or !read(is, file.m_mtime)) {
+                return false;
+            }
+        }
+
+        directories.emplace_hint(directories.end(), std::move(path), std::move(record));
+    }
+
+    m_root = std::move(root);
+    m_directories = std::move(directories);
+    return true;
+}
+
+bool ExplorationSnapshot::save(const std::string& fileName) const
+{
+    std::ofstream os{ fileName, std::ios::binary | std::ios::trunc };
+    if (!os) {
+        return false;
+    }
+
+    os.write(SnapshotHeader, sizeof(SnapshotHeader));
+    write(os, m_root);
+    write(os, static_cast<uint64_t>(m_directories.size()));
+
+    for (const auto& [path, record] : m_directories) {
+
+        write(os, path);
+        write(os, record.m_size);
+
+        write(os, static_cast<uint64_t>(record.m_extensions.size()));
+        for (const auto& [ext, size] : record.m_extensions) {
+            write(os, ext);
+            write(os, size);
+        }
+
+        write(os, static_cast<uint64_t>(record.m_files.size()));
+        for (const FileRecord& file : record.m_files) {
+            write(os, file.m_name);
+            write(os, file.m_size);
+            write(os, file.m_mtime);
+        }
+    }
+
+    return static_cast<bool>(os);
+}
+
+// ===========================================================================
+
+int64_t lastWriteTime(const std::filesystem::directory_entry& entry, std::error_code& ec)
+{
+    return static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count());
+}
+
+bool equalFiles(const std::vector<ExplorationSnapshot::FileRecord>& lhs,
+    const std::vector<ExplorationSnapshot::FileRecord>& rhs)
+{
+    return std::equal(
+        std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs),
+        [](const ExplorationSnapshot::FileRecord& a, const ExplorationSnapshot::FileRecord& b) {
+            return a.m_name == b.m_name and a.m_size == b.m_size and a.m_mtime == b.m_mtime;
+        }
+    );
+}
+
+template <typename T>
+void write(std::ostream& os, T value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write(std::ostream& os, const std::string& value)
+{
+    write(os, static_cast<uint32_t>(value.size()));
+    os.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+template <typename T>
+bool read(std::istream& is, T& value)
+{
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool read(std::istream& is, std::string& value)
+{
+    uint32_t length = 0;
+    if (!read(is, length)) {
+        return false;
+    }
+
+    value.resize(length);
+    return static_cast<bool>(is.read(value.data(), static_cast<std::streamsize>(length)));
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -0,0 +1,81 @@
+// ===========================================================================
+// ExplorationSnapshot.h
+// ===========================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/* Compact summary of a previous exploration, stored on disk:
+ * for every directory the name, size and modification time of the files
+ * directly contained in it and their total size (also per file extension).
+ *
+ * An incremental scan lists every directory exactly once, just like a full
+ * scan: size and modification time of the files are taken from the
+ * directory entries (on Windows they are part of the directory listing,
+ * no additional stat call is needed). Only directories whose files differ
+ * from the previous snapshot are aggregated again, the totals of all other
+ * directories are taken from the snapshot. Comparing the files one by one
+ * also detects in-place modifications (e.g. appending to a log file), which
+ * don't change the modification time of the directory.
+ */
+class ExplorationSnapshot
+{
+public:
+    struct FileRecord
+    {
+        std::string m_name;
+        uint64_t m_size;
+        int64_t m_mtime;                                // last write time
+    };
+
+    struct DirectoryRecord
+    {
+        uint64_t m_size;                                // files of this directory only
+        std::map<std::string, uint64_t> m_extensions;   // file extension : size
+        std::vector<FileRecord> m_files;                // sorted by name
+    };
+
+    struct Statistics
+    {
+        size_t m_reused;        // directories taken from the previous snapshot
+        size_t m_scanned;       // directories aggregated again
+        size_t m_statCalls;     // file size and modification time queries
+    };
+
+    // called for every directory, once its record is complete
+    using DirectoryVisitor =
+        std::function<void(size_t worker, const std::string& directory, const DirectoryRecord&)>;
+
+private:
+    std::string m_root;
+    std::map<std::string, DirectoryRecord> m_directories;
+    Statistics m_statistics;
+
+public:
+    ExplorationSnapshot() : m_statistics{ 0, 0, 0 } {}
+
+    // scans 'root', reusing unchanged directories of 'previous' (if any)
+    void scan(
+        TraversalEngine& engine,
+        const std::string& root,
+        const ExplorationSnapshot* previous,
+        const TraversalEngine::DirectoryVisitor& filter,
+        const DirectoryVisitor& onRecord,
+        const std::atomic<bool>* cancelled
+    );
+
+    bool load(const std::string& fileName);
+    bool save(const std::string& fileName) const;
+
+    const std::string& root() const { return m_root; }
+    const std::map<std::string, DirectoryRecord>& directories() const { return m_directories; }
+    const Statistics& statistics() const { return m_statistics; }
+};
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
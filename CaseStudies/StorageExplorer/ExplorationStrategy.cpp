@@ -8,25 +8,107 @@
 #include <list>
 #include <memory>
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
 
 #include "ExplorationStrategy.h"
 
+ExplorationStrategy::ExplorationStrategy()
+    : m_entries{ 0 },
+      m_batchEntries{ 1000 },
+      m_batchInterval{ 250 },
+      m_cancelled{ false },
+      m_asyncStart{ false }
+{}
+
+/**
+* asynchronous exploration
+*/
+std::future<void> ExplorationStrategy::exploreAsync(const std::string& path) {
+    m_cancelled = false;
+    m_asyncStart = true;
+    return std::async(std::launch::async, [this, path]() { explore(path); });
+}
+
+void ExplorationStrategy::cancel() {
+    m_cancelled = true;
+}
+
+void ExplorationStrategy::beginExploration() {
+    // synchronous runs start uncancelled, asynchronous runs were reset by exploreAsync
+    if (!m_asyncStart.exchange(false)) {
+        m_cancelled = false;
+    }
+}
+
+void ExplorationStrategy::setProgressBatch(size_t entries, std::chrono::milliseconds interval) {
+    m_batchEntries = (entries == 0) ? 1 : entries;
+    m_batchInterval = interval;
+}
+
+/**
+* progress notifications
+*/
+void ExplorationStrategy::beginProgress(size_t workers) {
+    m_entries = 0;
+    m_batches.assign(workers, ProgressBatch{ {}, 0, std::chrono::steady_clock::now() });
+}
+
+void ExplorationStrategy::reportProgress(size_t worker, std::string_view key, uint64_t size) {
+    ProgressBatch& batch = m_batches[worker];
+    batch.m_delta.add(key, size);
+    ++batch.m_entries;
+
+    if (batch.m_entries >= m_batchEntries or
+        std::chrono::steady_clock::now() - batch.m_lastFlush >= m_batchInterval)
+    {
+        flushProgress(batch);
+    }
+}
+
+void ExplorationStrategy::endProgress() {
+    for (ProgressBatch& batch : m_batches) {
+        flushProgress(batch);
+    }
+}
+
+void ExplorationStrategy::flushProgress(ProgressBatch& batch) {
+    m_entries += batch.m_entries;
+    batch.m_entries = 0;
+    batch.m_lastFlush = std::chrono::steady_clock::now();
+
+    if (batch.m_delta.empty()) {
+        return;
+    }
+
+    // moving leaves an empty delta behind
+    ExplorationProgress progress{ m_entries.load(), std::move(batch.m_delta) };
+
+    // observers are notified one batch at a time
+    std::lock_guard<std::mutex> guard{ m_observersMutex };
+    for (const std::shared_ptr<IExplorationObserver>& observer : m_list_observers) {
+        observer->progress(progress);
+    }
+}
+
 /**
 * observer management methods
 */
 void ExplorationStrategy::attach(std::shared_ptr<IExplorationObserver> observer) {
+    std::lock_guard<std::mutex> guard{ m_observersMutex };
     m_list_observers.push_back(observer);
 }
 
 void ExplorationStrategy::detach(std::shared_ptr<IExplorationObserver> observer) {
+    std::lock_guard<std::mutex> guard{ m_observersMutex };
     m_list_observers.remove(observer);
 }
 
 void ExplorationStrategy::onFinish() {
     std::cout << "got onFinish" << std::endl;
+    std::lock_guard<std::mutex> guard{ m_observersMutex };
     std::list<std::shared_ptr<IExplorationObserver>>::iterator iterator = m_list_observers.begin();
 
     while (iterator != m_list_observers.end()) {
@@ -2,10 +2,16 @@
 // ExplorationStrategy.h
 // ===========================================================================
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /* This class is the base class for the concrete strategy classes:
  * 1. FolderStrategy (obtain file size grouped by folder)
@@ -16,22 +22,79 @@ class ExplorationStrategy : public IExplorationStrategy
 private:
     std::list<std::shared_ptr<IExplorationObserver>> m_list_observers;
 
+    // guards the observer list: explorations may run on other threads;
+    // observers must not attach or detach from within a notification
+    std::mutex m_observersMutex;
+
+    // progress batches, one per worker thread
+    struct ProgressBatch
+    {
+        ExplorationResult m_delta;
+        size_t m_entries;
+        std::chrono::steady_clock::time_point m_lastFlush;
+    };
+
+    std::vector<ProgressBatch> m_batches;
+    std::atomic<size_t> m_entries;
+    size_t m_batchEntries;
+    std::chrono::milliseconds m_batchInterval;
+
 protected:
     // For holding the exploration result.
     // The key-value pair contain the following information:
     // FolderName : Size or FileType : Size
-    std::map<std::string, long> m_explorationResult;
+    ExplorationResult m_explorationResult;
+
+    std::atomic<bool> m_cancelled;
+
+    // set by exploreAsync, so that an early cancel() isn't lost
+    std::atomic<bool> m_asyncStart;
+
+    // incremental exploration: snapshot of the previous exploration
+    std::string m_snapshotFile;
 
 public:
-    ExplorationStrategy() = default;
+    ExplorationStrategy();
     ~ExplorationStrategy() = default;
 
+    /**
+    * asynchronous exploration
+    */
+    std::future<void> exploreAsync(const std::string& path) override;
+    void cancel() override;
+    bool cancelled() const override { return m_cancelled; }
+
+    /**
+    * progress notifications: a batch is sent after the given number of
+    * entries or after the given interval, whichever comes first
+    */
+    void setProgressBatch(size_t entries, std::chrono::milliseconds interval);
+
+    /**
+    * incremental exploration: the snapshot file is read before and
+    * written after each exploration, an empty name disables it
+    */
+    void setSnapshotFile(const std::string& fileName) { m_snapshotFile = fileName; }
+
     /**
     * observer management methods
     */
     void attach(std::shared_ptr<IExplorationObserver> observer) override;
     void detach(std::shared_ptr<IExplorationObserver> observer) override;
     void onFinish() override;
+
+protected:
+    // to be called by the concrete strategies at the start of every exploration:
+    // a cancel() only affects the current (or an already started asynchronous) run
+    void beginExploration();
+
+    // to be called by the concrete strategies while exploring
+    void beginProgress(size_t workers);
+    void reportProgress(size_t worker, std::string_view key, uint64_t size);
+    void endProgress();
+
+private:
+    void flushProgress(ProgressBatch& batch);
 };
 
 // ===========================================================================
@@ -2,45 +2,59 @@
 // FileTypeStrategy.cpp
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
 
+#include "TraversalEngine.h"
+#include "ExplorationSnapshot.h"
 #include "ExplorationStrategy.h"
 #include "FileTypeStrategy.h"
 
 #include <iostream>
 #include <string>
-//#include <map>
-//#include <list>
-//#include <iterator>
+#include <map>
+#include <vector>
+#include <algorithm>
 #include <filesystem>
-//#include <memory>
+
+// ===========================================================================
+
+// skip - at least for the moment - .git sub directory
+static bool skipDirectory(size_t, const std::filesystem::directory_entry& entry)
+{
+    return entry.path().filename() != ".git";
+}
 
 // ===========================================================================
 
 void FileTypeStrategy::explore(const std::string& path)
 {
-    exploreHelper(path);
+    beginExploration();
+
+    if (m_snapshotFile.empty()) {
+        scanFileTypes(path);
+    }
+    else {
+        scanIncremental(path);
+    }
+
     onFinish();
 }
 
-void FileTypeStrategy::exploreHelper(const std::string& path) {
-
-    std::filesystem::path p(path);
-    std::filesystem::directory_iterator start(p);
-    std::filesystem::directory_iterator end;
+void FileTypeStrategy::scanFileTypes(const std::string& path)
+{
+    // per worker: file type => total size
+    std::vector<ExplorationResult> partials(m_engine.threads());
+    beginProgress(m_engine.threads());
 
-    auto entriesLambda = [this](const std::filesystem::directory_entry& entry) mutable {
+    auto onFile = [&](size_t worker, const std::filesystem::directory_entry& entry) {
 
         const std::filesystem::path file = entry.path().filename();
-        const std::string name{ file.string() };
         const std::string ext{ file.extension().string() };
 
-        //std::cout << "Entry: " << " = " << name << '\n';
-        //std::cout << "Extension: [" << ext << "]" << '\n';
-
-        if (std::filesystem::is_regular_file(entry)) {
+        if (entry.is_regular_file()) {
 
             if (ext.empty()) {
                 // to be done - no extension !!!
@@ -50,46 +64,71 @@ void FileTypeStrategy::exploreHelper(const std::string& path) {
             uintmax_t size = 0;
             try
             {
-                size = file_size(entry);
+                size = entry.file_size();
             }
             catch (std::filesystem::filesystem_error& e) {
                 std::cout << e.what() << '\n';
             }
 
-            if (m_explorationResult.count(ext) > 0) {
-                m_explorationResult[ext] = static_cast<long>(m_explorationResult[ext] + size);
-            }
-            else {
-                m_explorationResult[ext] = static_cast<long>(size);;
-            }
+            partials[worker].add(ext, size);
+            reportProgress(worker, ext, size);
         }
-        else if (std::filesystem::is_directory(entry)) {
+    };
 
-            // do the same process to the subdirectories
+    m_engine.traverse(path, onFile, skipDirectory, &m_cancelled);
+    endProgress();
 
-            //  std::filesystem::directory_entry subEntry { entry };
-            std::string s = entry.path().string();
+    // merge partial results
+    m_explorationResult.clear();
+    for (const ExplorationResult& partial : partials) {
+        m_explorationResult.merge(partial);
+    }
+}
 
-            // skip - at least for the moment - .git sub directory
-            if (s == std::string(".git") or s == std::string(".git")) {
-                return;
+// unchanged directories are taken from the snapshot of the previous exploration
+void FileTypeStrategy::scanIncremental(const std::string& path)
+{
+    ExplorationSnapshot previous;
+    bool loaded = previous.load(m_snapshotFile);
+    beginProgress(m_engine.threads());
+
+    auto onRecord = [&](size_t worker, const std::string&,
+        const ExplorationSnapshot::DirectoryRecord& record) {
+        for (const auto& [ext, size] : record.m_extensions) {
+            if (!ext.empty()) {
+                reportProgress(worker, ext, size);
             }
-
-            exploreHelper(s);
         }
     };
 
-    std::for_each(start, end, entriesLambda);
+    ExplorationSnapshot snapshot;
+    snapshot.scan(m_engine, path, loaded ? &previous : nullptr, skipDirectory, onRecord, &m_cancelled);
+    endProgress();
+
+    if (!m_cancelled and !snapshot.save(m_snapshotFile)) {
+        std::cout << m_snapshotFile << ": cannot write snapshot" << '\n';
+    }
+
+    m_explorationResult.clear();
+    for (const auto& [directory, record] : snapshot.directories()) {
+        for (const auto& [ext, size] : record.m_extensions) {
+            if (!ext.empty()) {
+                m_explorationResult.add(ext, size);
+            }
+        }
+    }
 }
 
 void FileTypeStrategy::printResults()
 {
 
+    const std::vector<ExplorationResult::Entry> entries{ m_explorationResult.sorted() };
+
     std::for_each(
-        std::begin(m_explorationResult),
-        std::end(m_explorationResult),
-        [](const std::pair<std::string, uintmax_t>& entry) {
-            std::cout << "Ext: " << entry.first << " - Total Sizes: " << entry.second << '\n';
+        std::begin(entries),
+        std::end(entries),
+        [](const ExplorationResult::Entry& entry) {
+            std::cout << "Ext: " << entry.m_key << " - Total Sizes: " << entry.m_size << '\n';
         }
     );
 }
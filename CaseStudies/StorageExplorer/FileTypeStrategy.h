@@ -10,15 +10,22 @@
  */
 class FileTypeStrategy : public ExplorationStrategy
 {
+private:
+    TraversalEngine m_engine;
+
 public:
-    FileTypeStrategy() = default;
+    explicit FileTypeStrategy(size_t threads = TraversalEngine::defaultThreadCount())
+        : m_engine{ threads } {}
     ~FileTypeStrategy() = default;
 
     void explore(const std::string& path) override;
     void printResults() override;
 
+    void setThreads(size_t threads) { m_engine.setThreads(threads); }
+
 private:
-    void exploreHelper(const std::string& path);
+    void scanFileTypes(const std::string& path);
+    void scanIncremental(const std::string& path);
 };
 
 // ===========================================================================
@@ -2,78 +2,190 @@
 // FolderStrategy.cpp
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
 
+#include "TraversalEngine.h"
+#include "ExplorationSnapshot.h"
 #include "ExplorationStrategy.h"
 #include "FolderStrategy.h"
 
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
+#include <vector>
 
 // ===========================================================================
 
 // function prototypes
 static inline bool endsWith(const std::string& value, const std::string& ending);
-static long getFolderSize(const std::string& path);
+static bool isSkipped(const std::filesystem::path& folder, size_t rootLength);
 
 // ===========================================================================
 
 /* This class retrieves folders size under a given path;
  * then sizes are placed in a hashtable containing folder names
- * and the size of the folders
+ * and the size of the folders.
+ *
+ * The directory tree is walked exactly once by the traversal engine: each
+ * worker sums up the sizes of the files directly contained in a folder.
+ * Afterwards the folder sizes are accumulated bottom-up, deepest folders
+ * first, so every file is stat'ed only once and not once for every
+ * ancestor folder.
+ *
+ * With a snapshot file, folders unchanged since the previous exploration
+ * aren't aggregated again (see ExplorationSnapshot).
  */
 void FolderStrategy::explore(const std::string& path)
 {
-    exploreHelper(path);
+    beginExploration();
+
+    ExplorationResult sizes{
+        m_snapshotFile.empty() ? scanFolders(path) : scanIncremental(path)
+    };
+
+    accumulate(path, sizes);
     onFinish();
 }
 
-void FolderStrategy::exploreHelper(const std::string& path)
+// returns for each folder the size of the files directly contained in it
+ExplorationResult FolderStrategy::scanFolders(const std::string& path)
 {
-    std::filesystem::path p(path);
-    std::filesystem::directory_iterator start(p);
-    std::filesystem::directory_iterator end;
-
-    auto entriesLambda = [this](const std::filesystem::directory_entry& entry) mutable {
-
-        if (std::filesystem::is_directory(entry)) {
-
-            // skip - at least for the moment - .git and .vs sub directories
-            // const std::filesystem::path ext = entry.path().extension();
-            const std::string& s = entry.path().string();
-            if (endsWith(s, ".git") or endsWith(s, ".vs")) {
-                return;
-            }
-
-            // retrieve size of bytes of this folder
-            uintmax_t size = 0;
-            try
-            {
-                size = getFolderSize(entry.path().string());
-            }
-            catch (std::filesystem::filesystem_error& e) {
-                std::cout << e.what() << '\n';
-            }
-
-            // add size to the map
-            m_explorationResult[s] = static_cast<long>(size);
-
-            exploreHelper(s);
+    // per worker: folder => size of the files directly contained in it
+    std::vector<ExplorationResult> partials(m_engine.threads());
+    std::vector<size_t> statCalls(m_engine.threads(), 0);
+    beginProgress(m_engine.threads());
+
+    auto onFile = [&](size_t worker, const std::filesystem::directory_entry& entry) {
+
+        ++statCalls[worker];
+
+        std::error_code ec;
+        uintmax_t size = entry.file_size(ec);
+        if (ec) {
+            std::cout << entry.path().string() << ": " << ec.message() << '\n';
+            return;
         }
+
+        const std::string folder{ entry.path().parent_path().string() };
+        partials[worker].add(folder, size);
+
+        // progress: size of the files directly contained in the folder
+        reportProgress(worker, folder, size);
+    };
+
+    auto onDirectory = [&](size_t worker, const std::filesystem::directory_entry& entry) {
+
+        // register folder, even if it doesn't contain any files
+        partials[worker].add(entry.path().string(), 0);
+        return true;
     };
 
-    std::for_each(start, end, entriesLambda);
+    m_engine.traverse(path, onFile, onDirectory, &m_cancelled);
+    endProgress();
+
+    // merge partial results
+    ExplorationResult sizes;
+    for (const ExplorationResult& partial : partials) {
+        sizes.merge(partial);
+    }
+
+    m_statCalls = 0;
+    for (size_t count : statCalls) {
+        m_statCalls += count;
+    }
+
+    return sizes;
+}
+
+// same as scanFolders, but unchanged folders are taken from the snapshot
+ExplorationResult FolderStrategy::scanIncremental(const std::string& path)
+{
+    ExplorationSnapshot previous;
+    bool loaded = previous.load(m_snapshotFile);
+    beginProgress(m_engine.threads());
+
+    // progress: size of the files directly contained in the folder
+    auto onRecord = [&](size_t worker, const std::string& folder,
+        const ExplorationSnapshot::DirectoryRecord& record) {
+        reportProgress(worker, folder, record.m_size);
+    };
+
+    ExplorationSnapshot snapshot;
+    snapshot.scan(
+        m_engine,
+        path,
+        loaded ? &previous : nullptr,
+        [](size_t, const std::filesystem::directory_entry&) { return true; },
+        onRecord,
+        &m_cancelled
+    );
+
+    endProgress();
+
+    if (!m_cancelled and !snapshot.save(m_snapshotFile)) {
+        std::cout << m_snapshotFile << ": cannot write snapshot" << '\n';
+    }
+
+    m_statCalls = snapshot.statistics().m_statCalls;
+
+    ExplorationResult sizes;
+    sizes.reserve(snapshot.directories().size());
+    for (const auto& [folder, record] : snapshot.directories()) {
+        sizes.add(folder, record.m_size);
+    }
+
+    return sizes;
+}
+
+void FolderStrategy::accumulate(const std::string& path, ExplorationResult& sizes)
+{
+    // accumulate folder sizes bottom-up: deepest folders first
+    std::vector<std::pair<size_t, std::filesystem::path>> folders;
+    folders.reserve(sizes.size());
+    for (const ExplorationResult::Entry& entry : sizes) {
+        std::filesystem::path folder{ entry.m_key };
+        size_t depth = static_cast<size_t>(std::distance(folder.begin(), folder.end()));
+        folders.emplace_back(depth, std::move(folder));
+    }
+
+    std::sort(
+        std::begin(folders),
+        std::end(folders),
+        [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; }
+    );
+
+    for (const auto& [depth, folder] : folders) {
+        ExplorationResult::Entry* parent = sizes.find(folder.parent_path().string());
+        if (parent != nullptr) {
+            parent->m_size += sizes[folder.string()];
+        }
+    }
+
+    // skip - at least for the moment - .git and .vs sub directories:
+    // their size contributes to the parent folder, but they are not listed
+    const size_t rootLength = std::filesystem::path{ path }.string().size();
+
+    m_explorationResult.clear();
+    m_explorationResult.reserve(folders.size());
+    for (const auto& [depth, folder] : folders) {
+        if (folder.string().size() > rootLength and !isSkipped(folder, rootLength)) {
+            m_explorationResult.add(folder.string(), sizes[folder.string()]);
+        }
+    }
 }
 
 void FolderStrategy::printResults()
 {
+    const std::vector<ExplorationResult::Entry> entries{ m_explorationResult.sorted() };
+
     std::for_each(
-        std::begin(m_explorationResult),
-        std::end(m_explorationResult),
-        [](const std::pair<std::string, uintmax_t>& entry) {
-            std::cout << "Folder: " << entry.first << " - Size: " << entry.second << '\n';
+        std::begin(entries),
+        std::end(entries),
+        [](const ExplorationResult::Entry& entry) {
+            std::cout << "Folder: " << entry.m_key << " - Size: " << entry.m_size << '\n';
         }
     );
 }
@@ -84,26 +196,17 @@ inline bool endsWith(const std::string& value, const std::string& ending)
     return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
 }
 
-long getFolderSize(const std::string& path)
+// checks the folder itself and all its ancestors below the root folder
+bool isSkipped(const std::filesystem::path& folder, size_t rootLength)
 {
-    uintmax_t r = 0;
-    try {
-        if (!std::filesystem::is_directory(path))
-        {
-            r += std::filesystem::file_size(path);
+    for (std::filesystem::path p{ folder }; p.string().size() > rootLength; p = p.parent_path()) {
+        const std::string& s = p.string();
+        if (endsWith(s, ".git") or endsWith(s, ".vs")) {
+            return true;
         }
-        else
-        {
-            for (auto entry : std::filesystem::directory_iterator(path))
-                r += getFolderSize(entry.path().string());
-        }
-    }
-    catch (std::filesystem::filesystem_error& e)
-    {
-        std::cout << e.what() << '\n';
     }
 
-    return static_cast<long>(r);
+    return false;
 }
 
 // ===========================================================================
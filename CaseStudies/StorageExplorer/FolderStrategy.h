@@ -3,18 +3,31 @@
 // ===========================================================================
 
 #include <string>
+#include <cstdint>
 
 class FolderStrategy : public ExplorationStrategy
 {
+private:
+    TraversalEngine m_engine;
+
+    // number of file size queries (stat calls) of the last exploration
+    size_t m_statCalls;
+
 public:
-    FolderStrategy() = default;
+    explicit FolderStrategy(size_t threads = TraversalEngine::defaultThreadCount())
+        : m_engine{ threads }, m_statCalls{ 0 } {}
     ~FolderStrategy() = default;
 
     void explore(const std::string& path) override;
     void printResults() override;
 
+    void setThreads(size_t threads) { m_engine.setThreads(threads); }
+    size_t statCalls() const { return m_statCalls; }
+
 private:
-    void exploreHelper(const std::string& path);
+    ExplorationResult scanFolders(const std::string& path);
+    ExplorationResult scanIncremental(const std::string& path);
+    void accumulate(const std::string& path, ExplorationResult& sizes);
 };
 
 // ===========================================================================
@@ -0,0 +1,232 @@
+// ===========================================================================
+// FolderStrategyBenchmark.cpp
+// ===========================================================================
+
+#include "ExplorationResult.h"
+#include "IExplorationObserver.h"
+#include "IExplorationStrategy.h"
+#include "ExplorationObserver.h"
+
+#include "TraversalEngine.h"
+#include "ExplorationStrategy.h"
+#include "FolderStrategy.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <map>
+#include <memory>
+#include <filesystem>
+#include <chrono>
+
+// ===========================================================================
+
+namespace FolderStrategyBenchmark {
+
+    /* Former implementation of the FolderStrategy: the size of each folder
+     * is computed by a separate recursive walk (getFolderSize), so each file
+     * is stat'ed once for every ancestor folder.
+     */
+    class NaiveFolderExplorer
+    {
+    private:
+        size_t m_statCalls;
+        std::map<std::string, uint64_t> m_result;
+
+    public:
+        NaiveFolderExplorer() : m_statCalls{ 0 } {}
+
+        void explore(const std::string& path) {
+            m_statCalls = 0;
+            m_result.clear();
+            exploreHelper(path);
+        }
+
+        size_t statCalls() const { return m_statCalls; }
+
+        const std::map<std::string, uint64_t>& result() const { return m_result; }
+
+    private:
+        void exploreHelper(const std::string& path) {
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                if (entry.is_directory()) {
+                    const std::string& s = entry.path().string();
+                    m_result[s] = getFolderSize(s);
+                    exploreHelper(s);
+                }
+            }
+        }
+
+        uint64_t getFolderSize(const std::string& path) {
+            uintmax_t r = 0;
+            if (!std::filesystem::is_directory(path)) {
+                ++m_statCalls;
+                r += std::filesystem::file_size(path);
+            }
+            else {
+                for (const auto& entry : std::filesystem::directory_iterator(path))
+                    r += getFolderSize(entry.path().string());
+            }
+
+            return static_cast<uint64_t>(r);
+        }
+    };
+
+    // observer just keeping a copy of the result of the last exploration
+    class ResultObserver : public IExplorationObserver
+    {
+    public:
+        std::map<std::string, uint64_t> m_result;
+
+        void update(const ExplorationResult& result) override {
+            m_result.clear();
+            for (const ExplorationResult::Entry& entry : result) {
+                m_result.emplace(entry.m_key, entry.m_size);
+            }
+        }
+    };
+
+    // creates a directory tree with 'fanout' subfolders per folder
+    // and 'files' small files in every folder
+    static size_t createTree(const std::filesystem::path& root, int depth, int fanout, int files)
+    {
+        std::filesystem::create_directories(root);
+
+        size_t count = 0;
+        for (int i = 0; i < files; ++i) {
+            std::ofstream file{ root / ("file_" + std::to_string(i) + ".txt") };
+            file << std::string(static_cast<size_t>(16 * (i + 1)), 'x');
+            ++count;
+        }
+
+        if (depth > 0) {
+            for (int i = 0; i < fanout; ++i) {
+                count += createTree(root / ("folder_" + std::to_string(i)), depth - 1, fanout, files);
+            }
+        }
+
+        return count;
+    }
+
+    static void benchmark(int depth, int fanout, int files)
+    {
+        const std::filesystem::path root{
+            std::filesystem::temp_directory_path() / "StorageExplorerBenchmark"
+        };
+
+        std::filesystem::remove_all(root);
+        size_t numFiles = createTree(root, depth, fanout, files);
+
+        std::cout << "Tree: depth = " << depth << ", fanout = " << fanout
+            << ", files = " << numFiles << std::endl;
+
+        // former approach
+        NaiveFolderExplorer naive{};
+        auto start = std::chrono::high_resolution_clock::now();
+        naive.explore(root.string());
+        auto end = std::chrono::high_resolution_clock::now();
+        auto naiveMsecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+        std::cout << "Naive:       " << naive.statCalls() << " stat calls, "
+            << naiveMsecs << " msecs." << std::endl;
+
+        // single-pass approach, sequential and parallel
+        for (size_t threads : { 1, 4, 16 }) {
+
+            std::shared_ptr<FolderStrategy> strategy = std::make_shared<FolderStrategy>(threads);
+            std::shared_ptr<ResultObserver> observer = std::make_shared<ResultObserver>();
+            strategy->attach(observer);
+
+            start = std::chrono::high_resolution_clock::now();
+            strategy->explore(root.string());
+            end = std::chrono::high_resolution_clock::now();
+            auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+            std::cout << "Single-pass: " << strategy->statCalls() << " stat calls, "
+                << msecs << " msecs, " << threads << " thread(s)." << std::endl;
+            std::cout << "Results are equal: " << std::boolalpha
+                << (naive.result() == observer->m_result) << std::endl;
+        }
+
+        std::filesystem::remove_all(root);
+    }
+
+    static void benchmarkIncremental(int depth, int fanout, int files)
+    {
+        const std::filesystem::path root{
+            std::filesystem::temp_directory_path() / "StorageExplorerBenchmark"
+        };
+
+        const std::filesystem::path snapshotFile{
+            std::filesystem::temp_directory_path() / "StorageExplorerBenchmark.snapshot"
+        };
+
+        std::filesystem::remove_all(root);
+        std::filesystem::remove(snapshotFile);
+        size_t numFiles = createTree(root, depth, fanout, files);
+
+        std::cout << "Tree: depth = " << depth << ", fanout = " << fanout
+            << ", files = " << numFiles << std::endl;
+
+        std::shared_ptr<FolderStrategy> strategy = std::make_shared<FolderStrategy>(4);
+        std::shared_ptr<ResultObserver> observer = std::make_shared<ResultObserver>();
+        strategy->attach(observer);
+        strategy->setSnapshotFile(snapshotFile.string());
+
+        auto explore = [&](const std::string& title) {
+            auto start = std::chrono::high_resolution_clock::now();
+            strategy->explore(root.string());
+            auto end = std::chrono::high_resolution_clock::now();
+            auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+            NaiveFolderExplorer naive{};
+            naive.explore(root.string());
+
+            std::cout << title << strategy->statCalls() << " stat calls, "
+                << msecs << " msecs, results are equal: " << std::boolalpha
+                << (naive.result() == observer->m_result) << std::endl;
+        };
+
+        // first exploration writes the snapshot
+        explore("Full scan:        ");
+
+        // change a single folder deep down in the tree
+        std::filesystem::path folder{ root };
+        for (int i = 0; i < depth; ++i) {
+            folder /= "folder_0";
+        }
+
+        std::ofstream{ folder / "new_file.txt" } << std::string(1000, 'x');
+
+        explore("Incremental scan: ");
+
+        // modify an existing file in place: the folder's modification time doesn't change
+        std::ofstream{ root / "folder_1" / "file_0.txt", std::ios::app } << std::string(500, 'y');
+
+        explore("In-place append:  ");
+
+        std::filesystem::remove_all(root);
+        std::filesystem::remove(snapshotFile);
+    }
+}
+
+void benchmarkFolderStrategy()
+{
+    using namespace FolderStrategyBenchmark;
+
+    benchmark(3, 4, 10);
+    benchmark(6, 3, 5);
+    benchmark(12, 2, 2);
+}
+
+void benchmarkIncrementalExploration()
+{
+    using namespace FolderStrategyBenchmark;
+
+    benchmarkIncremental(6, 3, 5);
+    benchmarkIncremental(12, 2, 2);
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -3,13 +3,25 @@
 // ===========================================================================
 
 #include <string>
-#include <map>
+
+/* Batch of intermediate results sent while an exploration is running:
+ * the delta contains the sizes added since the previous batch only.
+ */
+struct ExplorationProgress
+{
+    size_t m_entries;                       // entries processed so far
+    ExplorationResult m_delta;              // key : size added since last batch
+};
 
 class IExplorationObserver {
 public:
     virtual ~IExplorationObserver() = default;
 
-    virtual void update(std::map<std::string, long>) = 0;
+    // read-only view of the result, valid during the call only
+    virtual void update(const ExplorationResult&) = 0;
+
+    // optional: called from the exploring thread(s), one call at a time
+    virtual void progress(const ExplorationProgress&) {}
 };
 
 // ===========================================================================
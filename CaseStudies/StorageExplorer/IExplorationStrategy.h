@@ -4,6 +4,7 @@
 
 #include <string>
 #include <memory>
+#include <future>
 
 class IExplorationStrategy {
 public:
@@ -11,6 +12,14 @@ public:
     virtual void explore(const std::string& path) = 0;
     virtual void printResults() = 0;
 
+    // asynchronous exploration: returns immediately,
+    // the exploration can be stopped with cancel()
+    virtual std::future<void> exploreAsync(const std::string& path) = 0;
+    virtual void cancel() = 0;
+
+    // true, if the last exploration was stopped by cancel(): its result is partial
+    virtual bool cancelled() const = 0;
+
     // observer management methods
     virtual void attach(std::shared_ptr<IExplorationObserver>) = 0;
     virtual void detach(std::shared_ptr<IExplorationObserver>) = 0;
@@ -2,6 +2,7 @@
 // ListViewAdapter.cpp
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
@@ -34,7 +35,7 @@ ListViewAdapter::~ListViewAdapter()
 {
 }
 
-void ListViewAdapter::update(std::map<std::string, long> result)
+void ListViewAdapter::update(const ExplorationResult& result)
 {
     // TODO HIer result adden ....
     std::cout << "Yeahhhhhhhhhhhhhhhh" << std::endl;
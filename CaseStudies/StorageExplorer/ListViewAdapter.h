@@ -3,7 +3,6 @@
 // ===========================================================================
 
 #include <string>
-#include <map>
 
 class ListViewAdapter : public IExplorationObserver
 {
@@ -14,7 +13,7 @@ public:
     ListViewAdapter();
     ~ListViewAdapter();
 
-    void update(std::map<std::string, long>) override;
+    void update(const ExplorationResult&) override;
 
 private:
 };
@@ -12,10 +12,12 @@
 
 // ===========================================================================
 
+#include "ExplorationResult.h"
 #include "IExplorationObserver.h"
 #include "IExplorationStrategy.h"
 #include "ExplorationObserver.h"
 
+#include "TraversalEngine.h"
 #include "ExplorationStrategy.h"
 #include "FileTypeStrategy.h"
 #include "FolderStrategy.h"
@@ -25,6 +27,9 @@
 #include "ListViewAdapter.h"
 
 #include <iostream>
+#include <future>
+#include <thread>
+#include <chrono>
 //#include <string>
 //#include <map>
 //#include <list>
@@ -33,6 +38,12 @@
 
 // ===========================================================================
 
+// function prototypes
+extern void benchmarkFolderStrategy();
+extern void benchmarkIncrementalExploration();
+
+// ===========================================================================
+
 void testStategyPattern() {
 
     // initialization section: setup strategy
@@ -49,7 +60,7 @@ void testStategyPattern() {
 
     // initialization section: setup listviewadapter
     std::shared_ptr<ListViewAdapter> adapter = std::make_shared<ListViewAdapter>();
-    std::map<std::string, long> empty;
+    ExplorationResult empty;
     adapter->update(empty);
     folderStrategy->attach(adapter);
     fileTypeStrategy->attach(adapter);
@@ -80,17 +91,47 @@ void testStategyPattern() {
     constexpr const char* path =
         R"(C:\Development\GitRepositoryCPlusPlus\Cpp_DesignPatterns)";
 
-    explorer->explore(path);
+    std::future<void> exploration = explorer->exploreAsync(path);
+
+    // the main thread could do other work meanwhile, here it just waits for the end of the exploration
+    exploration.get();
     // explorer->printResults();
+}
+
+void testAsyncExploration() {
+
+    std::shared_ptr<ExplorationStrategy> explorer = std::make_shared<ASyncTestStrategy>(100000);
+    explorer->setProgressBatch(500, std::chrono::milliseconds(50));
+
+    std::shared_ptr<IExplorationObserver> concreteObserver = std::make_shared<ExplorationObserver>();
+    explorer->attach(concreteObserver);
+
+    // start exploration, observers receive progress notifications meanwhile
+    std::future<void> exploration = explorer->exploreAsync("");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // stop exploration, observers receive the partial result
+    explorer->cancel();
+    exploration.get();
+    if (explorer->cancelled()) {
+        std::cout << "Exploration cancelled, partial result:" << std::endl;
+    }
+    explorer->printResults();
 
-    // block main thread
-    char ch;
-    std::cin >> ch;
+    // a cancel() doesn't affect later explorations
+    std::shared_ptr<ExplorationStrategy> next = std::make_shared<ASyncTestStrategy>(1000);
+    next->cancel();
+    next->explore("");
+    std::cout << "Next exploration " << (next->cancelled() ? "cancelled" : "completed") << std::endl;
 }
 
 int main() {
     std::cout << "Cpp Design Patterns Case Studies: Storage Explorer" << std::endl;
+    benchmarkFolderStrategy();
+    benchmarkIncrementalExploration();
     testStategyPattern();
+    testAsyncExploration();
     std::cout << "Done." << std::endl;
     return 0; 
 }
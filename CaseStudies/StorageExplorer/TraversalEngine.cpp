@@ -0,0 +1,230 @@
+// ===========================================================================
+// TraversalEngine.cpp
+// ===========================================================================
+
+#include "TraversalEngine.h"
+
+#include <iostream>
+#include <thread>
+
+// ===========================================================================
+
+TraversalEngine::TraversalEngine(size_t threads)
+    : m_threads{ 1 }, m_pending{ 0 }, m_queued{ 0 }, m_idleWorkers{ 0 }, m_cancelled{ nullptr }
+{
+    setThreads(threads);
+}
+
+void TraversalEngine::setThreads(size_t threads)
+{
+    m_threads = (threads == 0) ? 1 : threads;
+
+    m_queues.clear();
+    for (size_t i = 0; i < m_threads; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+size_t TraversalEngine::defaultThreadCount()
+{
+    size_t threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : threads;
+}
+
+void TraversalEngine::traverse(
+    const std::string& root,
+    const FileVisitor& onFile,
+    const DirectoryVisitor& onDirectory,
+    const std::atomic<bool>* cancelled)
+{
+    traverse(root, onFile, onDirectory, LeaveVisitor{}, cancelled);
+}
+
+void TraversalEngine::traverse(
+    const std::string& root,
+    const FileVisitor& onFile,
+    const DirectoryVisitor& onDirectory,
+    const LeaveVisitor& onLeave,
+    const std::atomic<bool>* cancelled)
+{
+    m_cancelled = cancelled;
+    m_exception = nullptr;
+    m_pending = 1;
+    m_queued = 1;
+    m_queues[0]->m_directories.push_back(std::filesystem::path{ root });
+
+    // worker 0 runs on the calling thread
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < m_threads; ++i) {
+        threads.emplace_back(
+            &TraversalEngine::run, this, i, std::cref(onFile), std::cref(onDirectory), std::cref(onLeave));
+    }
+
+    run(0, onFile, onDirectory, onLeave);
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    m_cancelled = nullptr;
+
+    if (m_exception) {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+void TraversalEngine::run(
+    size_t worker,
+    const FileVisitor& onFile,
+    const DirectoryVisitor& onDirectory,
+    const LeaveVisitor& onLeave)
+{
+    std::filesystem::path directory;
+
+    while (m_pending.load() != 0) {
+
+        if (!pop(worker, directory)) {
+            // other workers are still scanning and may push new work
+            waitForWork();
+            continue;
+        }
+
+        try
+        {
+            // when cancelled, remaining directories are just dropped
+            if (m_cancelled == nullptr or !m_cancelled->load()) {
+
+                scan(worker, directory, onFile, onDirectory);
+
+                // a partially listed directory isn't complete
+                if (onLeave and (m_cancelled == nullptr or !m_cancelled->load())) {
+                    onLeave(worker, directory);
+                }
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        if (--m_pending == 0) {
+            wakeUp(true);
+        }
+    }
+}
+
+bool TraversalEngine::pop(size_t worker, std::filesystem::path& directory)
+{
+    // own queue: LIFO, keeps the walk depth-first and cache friendly
+    {
+        WorkQueue& queue = *m_queues[worker];
+        std::lock_guard<std::mutex> guard{ queue.m_mutex };
+        if (!queue.m_directories.empty()) {
+            directory = std::move(queue.m_directories.back());
+            queue.m_directories.pop_back();
+            --m_queued;
+            return true;
+        }
+    }
+
+    // steal from the other workers: FIFO, takes the oldest (largest) subtrees
+    for (size_t i = 1; i < m_threads; ++i) {
+        WorkQueue& victim = *m_queues[(worker + i) % m_threads];
+        std::lock_guard<std::mutex> guard{ victim.m_mutex };
+        if (!victim.m_directories.empty()) {
+            directory = std::move(victim.m_directories.front());
+            victim.m_directories.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TraversalEngine::push(size_t worker, std::filesystem::path directory)
+{
+    ++m_pending;
+
+    {
+        WorkQueue& queue = *m_queues[worker];
+        std::lock_guard<std::mutex> guard{ queue.m_mutex };
+        queue.m_directories.push_back(std::move(directory));
+        ++m_queued;
+    }
+
+    wakeUp(false);
+}
+
+void TraversalEngine::waitForWork()
+{
+    std::unique_lock<std::mutex> lock{ m_idleMutex };
+
+    ++m_idleWorkers;
+    m_wakeUp.wait(lock, [this]() {
+        return m_queued.load() != 0 or m_pending.load() == 0;
+    });
+    --m_idleWorkers;
+}
+
+void TraversalEngine::wakeUp(bool all)
+{
+    // m_queued or m_pending has just been changed (sequentially consistent):
+    // either a worker going to sleep sees the change in its wait predicate,
+    // or it has already registered itself in m_idleWorkers
+    if (m_idleWorkers.load() == 0) {
+        return;
+    }
+
+    // holding the mutex ensures the worker has reached its wait() call
+    std::lock_guard<std::mutex> guard{ m_idleMutex };
+    if (all) {
+        m_wakeUp.notify_all();
+    }
+    else {
+        m_wakeUp.notify_one();
+    }
+}
+
+void TraversalEngine::scan(
+    size_t worker,
+    const std::filesystem::path& directory,
+    const FileVisitor& onFile,
+    const DirectoryVisitor& onDirectory)
+{
+    std::error_code ec;
+    std::filesystem::directory_iterator iter{ directory, ec };
+    if (ec) {
+        std::cout << directory.string() << ": " << ec.message() << '\n';
+        return;
+    }
+
+    for (std::filesystem::directory_iterator end; iter != end; iter.increment(ec)) {
+
+        if (m_cancelled != nullptr and m_cancelled->load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        const std::filesystem::directory_entry& entry = *iter;
+
+        if (entry.is_directory(ec)) {
+            if (onDirectory(worker, entry)) {
+                push(worker, entry.path());
+            }
+        }
+        else {
+            onFile(worker, entry);
+        }
+    }
+
+    if (ec) {
+        std::cout << directory.string() << ": " << ec.message() << '\n';
+    }
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
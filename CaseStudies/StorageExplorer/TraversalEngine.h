@@ -0,0 +1,108 @@
+// ===========================================================================
+// TraversalEngine.h
+// ===========================================================================
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Parallel directory traversal shared by the exploration strategies.
+ * Every worker thread owns a queue of directories still to be scanned:
+ * subdirectories found by a worker are pushed onto its own queue (and taken
+ * from the back again), idle workers steal directories from the front of
+ * the queues of the other workers. A worker finding all queues empty
+ * sleeps until new directories are pushed or the traversal has ended.
+ *
+ * The callbacks receive the index of the calling worker, so a strategy can
+ * collect partial results per thread without any locking and merge them
+ * once traverse() has returned.
+ */
+class TraversalEngine
+{
+public:
+    // called for every non-directory entry
+    using FileVisitor =
+        std::function<void(size_t worker, const std::filesystem::directory_entry&)>;
+
+    // called for every subdirectory; returning false skips the subdirectory
+    using DirectoryVisitor =
+        std::function<bool(size_t worker, const std::filesystem::directory_entry&)>;
+
+    // called after all entries of a directory have been visited
+    using LeaveVisitor =
+        std::function<void(size_t worker, const std::filesystem::path&)>;
+
+private:
+    struct WorkQueue
+    {
+        std::mutex m_mutex;
+        std::deque<std::filesystem::path> m_directories;
+    };
+
+    size_t m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::atomic<size_t> m_pending;       // directories queued or being scanned
+    std::atomic<size_t> m_queued;        // directories queued
+    std::atomic<size_t> m_idleWorkers;   // workers waiting for m_wakeUp
+    std::mutex m_idleMutex;
+    std::condition_variable m_wakeUp;
+    const std::atomic<bool>* m_cancelled;
+    std::mutex m_mutex;
+    std::exception_ptr m_exception;
+
+public:
+    explicit TraversalEngine(size_t threads = defaultThreadCount());
+
+    TraversalEngine(const TraversalEngine&) = delete;
+    TraversalEngine& operator=(const TraversalEngine&) = delete;
+
+    size_t threads() const { return m_threads; }
+    void setThreads(size_t threads);
+
+    // stops early, when 'cancelled' becomes true
+    void traverse(
+        const std::string& root,
+        const FileVisitor& onFile,
+        const DirectoryVisitor& onDirectory,
+        const std::atomic<bool>* cancelled = nullptr
+    );
+
+    void traverse(
+        const std::string& root,
+        const FileVisitor& onFile,
+        const DirectoryVisitor& onDirectory,
+        const LeaveVisitor& onLeave,
+        const std::atomic<bool>* cancelled = nullptr
+    );
+
+    static size_t defaultThreadCount();
+
+private:
+    void run(
+        size_t worker,
+        const FileVisitor& onFile,
+        const DirectoryVisitor& onDirectory,
+        const LeaveVisitor& onLeave
+    );
+    bool pop(size_t worker, std::filesystem::path& directory);
+    void push(size_t worker, std::filesystem::path directory);
+    void waitForWork();
+    void wakeUp(bool all);
+    void scan(
+        size_t worker,
+        const std::filesystem::path& directory,
+        const FileVisitor& onFile,
+        const DirectoryVisitor& onDirectory
+    );
+};
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
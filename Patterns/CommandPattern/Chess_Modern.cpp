@@ -6,8 +6,20 @@
 #include <queue> 
 #include <stack>
 #include <stdexcept>
+#include <cstddef>
+#include <new>
+#include <type_traits>
 #include <memory>
 #include <utility>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace ChessExample_Modern {
 
@@ -84,6 +96,9 @@ namespace ChessExample_Modern {
         // shared_ptr ist hier richtig, da mehrere Moves dieselbe Figur referenzieren
         std::shared_ptr<ChessPiece> m_piece;
 
+        // für Commands, die kein ChessPiece-Objekt bewegen
+        Move() = default;
+
     public:
         virtual ~Move() = default;
 
@@ -133,49 +148,162 @@ namespace ChessExample_Modern {
     };
 
     // Der Invoker / Receiver-Manager
+    //
+    // Modern: Die Commands liegen ohne Heap-Allokation in einem Ringpuffer
+    // fester Tiefe. Layout (fortlaufende Indizes, Modulo Tiefe):
+    //   [m_first, m_current)   ausgeführt, können rückgängig gemacht werden
+    //   [m_current, m_pending) rückgängig gemacht, können wiederholt werden
+    //   [m_pending, m_end)     eingereiht, noch nicht ausgeführt
+    // Ist der Puffer voll, werden die ältesten ausgeführten Züge verworfen:
+    // Ihr Effekt bleibt im Zustand der Figuren erhalten (Kompaktierung).
     class Board {
+    public:
+        static constexpr std::size_t DefaultDepth{ 1024 };
+        static constexpr std::size_t StorageSize{ 48 };
+
     private:
-        // Modern: Ein Move gehört exklusiv dem Board-Verlauf, daher unique_ptr
-        std::queue<std::unique_ptr<Move>> m_moves;
-        std::stack<std::unique_ptr<Move>> m_undos;
+        struct Slot {
+            alignas(std::max_align_t) std::byte m_storage[StorageSize];
+            Move* m_command{ nullptr };
+            void (*m_relocate)(Slot& from, Slot& to) { nullptr };
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::size_t   m_depth;
+        std::uint64_t m_first{};
+        std::uint64_t m_current{};
+        std::uint64_t m_pending{};
+        std::uint64_t m_end{};
+        std::uint64_t m_compacted{};
 
     public:
-        Board() = default;
+        explicit Board(std::size_t depth = DefaultDepth)
+            : m_slots{ std::make_unique<Slot[]>(depth == 0 ? 1 : depth) }, m_depth{ depth == 0 ? 1 : depth }
+        {}
+
+        Board(const Board&) = delete;
+        Board& operator=(const Board&) = delete;
 
-        // Nimmt das Command per unique_ptr und Eigentumsübergang an
-        void enqueue(std::unique_ptr<Move> spielzug) {
-            m_moves.push(std::move(spielzug));
+        ~Board() {
+            while (m_first != m_end) {
+                destroy(slot(m_first++));
+            }
         }
 
-        void play() {
-            std::println("Spiele {} Spielzuege:", m_moves.size());
+        // Konstruiert das Command direkt im Ringpuffer; verwirft Züge für redo
+        template <typename TMove, typename... TArgs>
+        void enqueue(TArgs&&... args) {
+            static_assert(std::is_base_of_v<Move, TMove>);
+            static_assert(sizeof(TMove) <= StorageSize && alignof(TMove) <= alignof(std::max_align_t),
+                "Command passt nicht in einen Eintrag des Verlaufs");
 
-            while (!m_moves.empty()) {
-                // Eigentum aus der Queue herausbewegen (ab C++23 via .pop() direkt, 
-                // in C++20 via front() + pop())
-                std::unique_ptr<Move> move = std::move(m_moves.front());
-                m_moves.pop();
+            discardRedo();
 
-                move->doMove();
-                m_undos.push(std::move(move)); // Weiter in den Undo-Stack schieben
+            if (m_end - m_first == m_depth) {
+                if (m_first == m_current)
+                    throw std::length_error("Zu viele Spielzuege in der Warteschlange");
+                destroy(slot(m_first++));
+                ++m_compacted;
             }
 
-            std::println("Done.");
+            Slot& entry{ slot(m_end) };
+            entry.m_command = ::new (static_cast<void*>(entry.m_storage)) TMove(std::forward<TArgs>(args)...);
+            entry.m_relocate = &relocate<TMove>;
+            ++m_end;
         }
 
-        void undo() {
-            std::println("Starte Undo:");
+        // Führt alle eingereihten Züge aus. Wirft ein Zug eine Ausnahme,
+        // bleiben er und alle folgenden Züge eingereiht (siehe discardPending)
+        std::size_t play() {
+            discardRedo();
 
-            if (!m_undos.empty()) {
-                std::unique_ptr<Move> move = std::move(m_undos.top());
-                m_undos.pop();
+            std::size_t count{};
+            while (m_current != m_end) {
+                slot(m_current).m_command->doMove();
+                m_pending = ++m_current;
+                ++count;
+            }
 
-                move->undoMove();
-                std::println("Undo ausgefuehrt");
+            return count;
+        }
+
+        bool undo() {
+            if (m_current == m_first) {
+                return false;
             }
-            else {
-                std::println("Keine Zuege zum Rueckgaengigmachen vorhanden.");
+
+            slot(m_current - 1).m_command->undoMove();
+            --m_current;
+            return true;
+        }
+
+        bool redo() {
+            if (m_current == m_pending) {
+                return false;
+            }
+
+            slot(m_current).m_command->doMove();
+            ++m_current;
+            return true;
+        }
+
+        // Verwirft alle eingereihten, noch nicht ausgeführten Züge
+        void discardPending() {
+            while (m_end != m_pending) {
+                destroy(slot(--m_end));
+            }
+        }
+
+        // Behält höchstens 'keep' Züge für undo, der Rest wird verworfen
+        void compact(std::size_t keep) {
+            while (m_current - m_first > keep) {
+                destroy(slot(m_first++));
+                ++m_compacted;
+            }
+        }
+
+        std::size_t depth() const { return m_depth; }
+        std::size_t undoCount() const { return static_cast<std::size_t>(m_current - m_first); }
+        std::size_t redoCount() const { return static_cast<std::size_t>(m_pending - m_current); }
+        std::size_t pendingCount() const { return static_cast<std::size_t>(m_end - m_pending); }
+        std::uint64_t compactedCount() const { return m_compacted; }
+
+    private:
+        Slot& slot(std::uint64_t index) { return m_slots[index % m_depth]; }
+
+        static void destroy(Slot& entry) {
+            entry.m_command->~Move();
+            entry.m_command = nullptr;
+        }
+
+        template <typename TMove>
+        static void relocate(Slot& from, Slot& to) {
+            TMove* command{ static_cast<TMove*>(from.m_command) };
+            to.m_command = ::new (static_cast<void*>(to.m_storage)) TMove(std::move(*command));
+            to.m_relocate = from.m_relocate;
+            command->~TMove();
+            from.m_command = nullptr;
+        }
+
+        // Neue Züge beenden die Möglichkeit, rückgängig gemachte Züge zu wiederholen;
+        // bereits eingereihte Züge rücken nach
+        void discardRedo() {
+            if (m_current == m_pending) {
+                return;
+            }
+
+            for (std::uint64_t index{ m_current }; index != m_pending; ++index) {
+                destroy(slot(index));
             }
+
+            std::uint64_t target{ m_current };
+            for (std::uint64_t index{ m_pending }; index != m_end; ++index) {
+                Slot& from{ slot(index) };
+                from.m_relocate(from, slot(target++));
+            }
+
+            m_end = target;
+            m_pending = m_current;
         }
     };
 
@@ -187,19 +315,577 @@ namespace ChessExample_Modern {
         ChessGame() = default;
 
         void play(const std::shared_ptr<ChessPiece>& piece, Position position) {
-            // make_unique statt make_shared für das Command
-            m_board.enqueue(std::make_unique<SimpleMove>(piece, std::move(position)));
-            m_board.play();
+            m_board.enqueue<SimpleMove>(piece, std::move(position));
+            play();
         }
 
         void enqueue(const std::shared_ptr<ChessPiece>& piece, Position position) {
-            m_board.enqueue(std::make_unique<SimpleMove>(piece, std::move(position)));
+            m_board.enqueue<SimpleMove>(piece, std::move(position));
+        }
+
+        void play() {
+            std::println("Spiele {} Spielzuege:", m_board.pendingCount());
+
+            try {
+                m_board.play();
+                std::println("Done.");
+            }
+            catch (const std::invalid_argument& ex) {
+                std::println("Ungueltiger Zug: {}", ex.what());
+                std::println("{} Spielzuege werden verworfen.", m_board.pendingCount());
+                m_board.discardPending();
+            }
+        }
+
+        void undo() {
+            std::println("Starte Undo:");
+
+            if (m_board.undo()) {
+                std::println("Undo ausgefuehrt");
+            }
+            else {
+                std::println("Keine Zuege zum Rueckgaengigmachen vorhanden.");
+            }
+        }
+
+        void redo() {
+            std::println("Starte Redo:");
+
+            if (m_board.redo()) {
+                std::println("Redo ausgefuehrt");
+            }
+            else {
+                std::println("Keine Zuege zum Wiederholen vorhanden.");
+            }
+        }
+    };
+
+    // =======================================================================
+    // Bitboard-Darstellung: Jede Figurenart einer Farbe ist ein 64-Bit-Wert,
+    // Bit n entspricht dem Feld n (a1 = 0, h1 = 7, ..., h8 = 63).
+    // Die Züge werden über dieselbe doMove/undoMove-Schnittstelle ausgeführt
+    // und zurückgenommen und eignen sich so für die Suche im Spielbaum.
+
+    using Bitboard = std::uint64_t;
+
+    // Kompakter Zug: 6 Bit Start-, 6 Bit Zielfeld, 4 Bit Art des Zugs
+    class CompactMove {
+    private:
+        std::uint16_t m_value{};
+
+    public:
+        enum Flags : int {
+            Quiet = 0, DoublePawnPush = 1, KingCastle = 2, QueenCastle = 3,
+            Capture = 4, EnPassant = 5, Promotion = 8
+        };
+
+        CompactMove() = default;
+        CompactMove(int from, int to, int flags)
+            : m_value{ static_cast<std::uint16_t>(from | (to << 6) | (flags << 12)) }
+        {}
+
+        int from() const { return m_value & 0x3F; }
+        int to() const { return (m_value >> 6) & 0x3F; }
+        int flags() const { return m_value >> 12; }
+
+        bool isCapture() const { return (flags() & Capture) != 0; }
+        bool isPromotion() const { return (flags() & Promotion) != 0; }
+
+        // Springer = 1, Läufer = 2, Turm = 3, Dame = 4
+        int promotionType() const { return 1 + (flags() & 3); }
+
+        // Notation wie im UCI-Protokoll, zum Beispiel "e2e4" oder "e7e8q"
+        std::string toString() const {
+            std::string text{
+                static_cast<char>('a' + from() % 8), static_cast<char>('1' + from() / 8),
+                static_cast<char>('a' + to() % 8), static_cast<char>('1' + to() / 8)
+            };
+
+            if (isPromotion()) {
+                text += "nbrq"[promotionType() - 1];
+            }
+
+            return text;
+        }
+    };
+
+    static_assert(sizeof(CompactMove) == 2);
+
+    // Zugliste fester Größe: keine dynamische Speicherallokation
+    class MoveList {
+    private:
+        std::array<CompactMove, 256> m_moves;
+        std::size_t m_size{};
+
+    public:
+        void push_back(CompactMove move) { m_moves[m_size++] = move; }
+        std::size_t size() const { return m_size; }
+
+        const CompactMove* begin() const { return m_moves.data(); }
+        const CompactMove* end() const { return m_moves.data() + m_size; }
+    };
+
+    // Zustand, der sich durch einen Zug nicht wiederherstellen lässt
+    struct UndoInfo {
+        std::uint8_t m_captured;
+        std::uint8_t m_castling;
+        std::int8_t  m_enPassant;
+        std::uint16_t m_halfmoves;
+    };
+
+    static int lsb(Bitboard bits) { return std::countr_zero(bits); }
+    static int msb(Bitboard bits) { return 63 - std::countl_zero(bits); }
+
+    static int popLsb(Bitboard& bits) {
+        int square{ lsb(bits) };
+        bits &= bits - 1;
+        return square;
+    }
+
+    static constexpr Bitboard bit(int square) { return Bitboard{ 1 } << square; }
+
+    // Vorberechnete Angriffe und Strahlen je Feld
+    struct AttackTables {
+        std::array<Bitboard, 64> m_knight{};
+        std::array<Bitboard, 64> m_king{};
+        std::array<std::array<Bitboard, 64>, 2> m_pawn{};
+
+        // Strahlen 0 bis 3 laufen zu höheren Feldnummern (N, O, NO, NW),
+        // Strahlen 4 bis 7 zu niedrigeren (S, W, SO, SW)
+        std::array<std::array<Bitboard, 64>, 8> m_rays{};
+
+        // Maske der Rochaderechte, die nach einem Zug von/auf ein Feld erhalten bleiben
+        std::array<std::uint8_t, 64> m_castlingMask{};
+
+        AttackTables() {
+            auto at = [](int file, int rank) -> Bitboard {
+                return (file >= 0 && file < 8 && rank >= 0 && rank < 8) ? bit(rank * 8 + file) : 0;
+            };
+
+            constexpr int knight[8][2]{ { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+            constexpr int king[8][2]{ { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+            constexpr int rays[8][2]{ { 0, 1 }, { 1, 0 }, { 1, 1 }, { -1, 1 }, { 0, -1 }, { -1, 0 }, { 1, -1 }, { -1, -1 } };
+
+            for (int square{}; square < 64; ++square) {
+                int file{ square % 8 };
+                int rank{ square / 8 };
+
+                for (int i{}; i < 8; ++i) {
+                    m_knight[square] |= at(file + knight[i][0], rank + knight[i][1]);
+                    m_king[square] |= at(file + king[i][0], rank + king[i][1]);
+
+                    for (int f{ file + rays[i][0] }, r{ rank + rays[i][1] }; at(f, r) != 0; f += rays[i][0], r += rays[i][1]) {
+                        m_rays[i][square] |= at(f, r);
+                    }
+                }
+
+                m_pawn[0][square] = at(file - 1, rank + 1) | at(file + 1, rank + 1);
+                m_pawn[1][square] = at(file - 1, rank - 1) | at(file + 1, rank - 1);
+
+                m_castlingMask[square] = 0x0F;
+            }
+
+            m_castlingMask[0] = static_cast<std::uint8_t>(~2 & 0x0F);
+            m_castlingMask[4] = static_cast<std::uint8_t>(~3 & 0x0F);
+            m_castlingMask[7] = static_cast<std::uint8_t>(~1 & 0x0F);
+            m_castlingMask[56] = static_cast<std::uint8_t>(~8 & 0x0F);
+            m_castlingMask[60] = static_cast<std::uint8_t>(~12 & 0x0F);
+            m_castlingMask[63] = static_cast<std::uint8_t>(~4 & 0x0F);
+        }
+    };
+
+    static const AttackTables s_attacks;
+
+    // Angriffe einer Linienfigur entlang eines Strahls bis zur ersten blockierenden Figur
+    static Bitboard rayAttacks(int ray, int square, Bitboard occupied) {
+        Bitboard attacks{ s_attacks.m_rays[ray][square] };
+        Bitboard blockers{ attacks & occupied };
+
+        if (blockers != 0) {
+            attacks ^= s_attacks.m_rays[ray][ray < 4 ? lsb(blockers) : msb(blockers)];
+        }
+
+        return attacks;
+    }
+
+    static Bitboard bishopAttacks(int square, Bitboard occupied) {
+        return rayAttacks(2, square, occupied) | rayAttacks(3, square, occupied) |
+            rayAttacks(6, square, occupied) | rayAttacks(7, square, occupied);
+    }
+
+    static Bitboard rookAttacks(int square, Bitboard occupied) {
+        return rayAttacks(0, square, occupied) | rayAttacks(1, square, occupied) |
+            rayAttacks(4, square, occupied) | rayAttacks(5, square, occupied);
+    }
+
+    class BitboardPosition {
+    public:
+        enum Color : int { White, Black };
+        enum PieceType : int { Pawn, Knight, Bishop, Rook, Queen, King };
+        enum Castling : int { WhiteKingSide = 1, WhiteQueenSide = 2, BlackKingSide = 4, BlackQueenSide = 8 };
+
+        static constexpr int NoPiece{ 12 };
+
+        static constexpr std::string_view StartPosition{
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+        };
+
+    private:
+        std::array<Bitboard, 12>     m_pieces{};     // Index: Farbe * 6 + Figurenart
+        std::array<Bitboard, 2>      m_colors{};
+        std::array<std::uint8_t, 64> m_squares{};    // Figur je Feld oder NoPiece
+        int m_side{ White };
+        int m_castling{};
+        int m_enPassant{ -1 };
+        int m_halfmoves{};
+
+    public:
+        // Stellung in der Forsyth-Edwards-Notation (FEN)
+        explicit BitboardPosition(std::string_view fen = StartPosition) {
+            m_squares.fill(NoPiece);
+
+            auto next = [&]() {
+                while (!fen.empty() && fen.front() == ' ') fen.remove_prefix(1);
+                std::size_t length{ std::min(fen.find(' '), fen.size()) };
+                std::string_view field{ fen.substr(0, length) };
+                fen.remove_prefix(length);
+                return field;
+            };
+
+            int square{ 56 };
+            for (char ch : next()) {
+                if (ch == '/') {
+                    square -= 16;
+                }
+                else if (ch >= '1' && ch <= '8') {
+                    square += ch - '0';
+                }
+                else {
+                    std::size_t piece{ std::string_view{ "PNBRQKpnbrqk" }.find(ch) };
+                    if (piece == std::string_view::npos || square < 0 || square > 63)
+                        throw std::invalid_argument("Ungueltige Stellung in FEN");
+                    putPiece(static_cast<int>(piece), square++);
+                }
+            }
+
+            std::string_view side{ next() };
+            if (side != "w" && side != "b")
+                throw std::invalid_argument("Ungueltige Farbe am Zug in FEN");
+            m_side = side == "w" ? White : Black;
+
+            for (char ch : next()) {
+                switch (ch) {
+                case 'K': m_castling |= WhiteKingSide; break;
+                case 'Q': m_castling |= WhiteQueenSide; break;
+                case 'k': m_castling |= BlackKingSide; break;
+                case 'q': m_castling |= BlackQueenSide; break;
+                case '-': break;
+                default: throw std::invalid_argument("Ungueltige Rochaderechte in FEN");
+                }
+            }
+
+            std::string_view enPassant{ next() };
+            if (enPassant.size() == 2) {
+                m_enPassant = (enPassant[1] - '1') * 8 + (enPassant[0] - 'a');
+            }
+
+            std::string_view halfmoves{ next() };
+            for (char ch : halfmoves) {
+                m_halfmoves = m_halfmoves * 10 + (ch - '0');
+            }
+        }
+
+        int sideToMove() const { return m_side; }
+
+        bool isInCheck() const {
+            return isAttacked(kingSquare(m_side), m_side ^ 1);
+        }
+
+        void makeMove(CompactMove move, UndoInfo& undo) {
+            int from{ move.from() };
+            int to{ move.to() };
+            int flags{ move.flags() };
+            int piece{ m_squares[from] };
+
+            undo.m_captured = NoPiece;
+            undo.m_castling = static_cast<std::uint8_t>(m_castling);
+            undo.m_enPassant = static_cast<std::int8_t>(m_enPassant);
+            undo.m_halfmoves = static_cast<std::uint16_t>(m_halfmoves);
+
+            if (flags == CompactMove::EnPassant) {
+                int square{ m_side == White ? to - 8 : to + 8 };
+                undo.m_captured = m_squares[square];
+                removePiece(square);
+            }
+            else if (move.isCapture()) {
+                undo.m_captured = m_squares[to];
+                removePiece(to);
+            }
+
+            m_halfmoves = (undo.m_captured != NoPiece || piece % 6 == Pawn) ? 0 : m_halfmoves + 1;
+
+            movePiece(from, to);
+
+            if (move.isPromotion()) {
+                removePiece(to);
+                putPiece(m_side * 6 + move.promotionType(), to);
+            }
+            else if (flags == CompactMove::KingCastle) {
+                movePiece(to + 1, to - 1);
+            }
+            else if (flags == CompactMove::QueenCastle) {
+                movePiece(to - 2, to + 1);
+            }
+
+            m_enPassant = (flags == CompactMove::DoublePawnPush) ? (from + to) / 2 : -1;
+            m_castling &= s_attacks.m_castlingMask[from] & s_attacks.m_castlingMask[to];
+            m_side ^= 1;
+        }
+
+        void unmakeMove(CompactMove move, const UndoInfo& undo) {
+            int from{ move.from() };
+            int to{ move.to() };
+            int flags{ move.flags() };
+
+            m_side ^= 1;
+
+            if (move.isPromotion()) {
+                removePiece(to);
+                putPiece(m_side * 6 + Pawn, to);
+            }
+            else if (flags == CompactMove::KingCastle) {
+                movePiece(to - 1, to + 1);
+            }
+            else if (flags == CompactMove::QueenCastle) {
+                movePiece(to + 1, to - 2);
+            }
+
+            movePiece(to, from);
+
+            if (undo.m_captured != NoPiece) {
+                int square{ to };
+                if (flags == CompactMove::EnPassant) {
+                    square = m_side == White ? to - 8 : to + 8;
+                }
+                putPiece(undo.m_captured, square);
+            }
+
+            m_castling = undo.m_castling;
+            m_enPassant = undo.m_enPassant;
+            m_halfmoves = undo.m_halfmoves;
+        }
+
+        // Legale Züge: pseudo-legale Züge, nach denen der eigene König nicht im Schach steht
+        void generateLegalMoves(MoveList& moves) {
+            MoveList candidates;
+            generatePseudoLegalMoves(candidates);
+
+            int us{ m_side };
+            for (CompactMove move : candidates) {
+                UndoInfo undo;
+                makeMove(move, undo);
+                if (!isAttacked(kingSquare(us), us ^ 1)) {
+                    moves.push_back(move);
+                }
+                unmakeMove(move, undo);
+            }
+        }
+
+        // Sucht einen legalen Zug in UCI-Notation
+        std::optional<CompactMove> parseMove(std::string_view text) {
+            MoveList moves;
+            generateLegalMoves(moves);
+
+            for (CompactMove move : moves) {
+                if (move.toString() == text) {
+                    return move;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        void print() const {
+            for (int rank{ 7 }; rank >= 0; --rank) {
+                std::string line;
+                for (int file{}; file < 8; ++file) {
+                    line += "PNBRQKpnbrqk."[m_squares[rank * 8 + file]];
+                    line += ' ';
+                }
+                std::println("{} {}", rank + 1, line);
+            }
+            std::println("  a b c d e f g h");
+        }
+
+    private:
+        Bitboard occupied() const { return m_colors[White] | m_colors[Black]; }
+
+        Bitboard pieces(int color, int type) const { return m_pieces[color * 6 + type]; }
+
+        int kingSquare(int color) const { return lsb(pieces(color, King)); }
+
+        void putPiece(int piece, int square) {
+            m_pieces[piece] |= bit(square);
+            m_colors[piece / 6] |= bit(square);
+            m_squares[square] = static_cast<std::uint8_t>(piece);
+        }
+
+        void removePiece(int square) {
+            int piece{ m_squares[square] };
+            m_pieces[piece] &= ~bit(square);
+            m_colors[piece / 6] &= ~bit(square);
+            m_squares[square] = NoPiece;
+        }
+
+        void movePiece(int from, int to) {
+            int piece{ m_squares[from] };
+            m_pieces[piece] ^= bit(from) | bit(to);
+            m_colors[piece / 6] ^= bit(from) | bit(to);
+            m_squares[from] = NoPiece;
+            m_squares[to] = static_cast<std::uint8_t>(piece);
+        }
+
+        bool isAttacked(int square, int by) const {
+            Bitboard all{ occupied() };
+            Bitboard queens{ pieces(by, Queen) };
+
+            return (s_attacks.m_pawn[by ^ 1][square] & pieces(by, Pawn)) != 0
+                || (s_attacks.m_knight[square] & pieces(by, Knight)) != 0
+                || (s_attacks.m_king[square] & pieces(by, King)) != 0
+                || (bishopAttacks(square, all) & (pieces(by, Bishop) | queens)) != 0
+                || (rookAttacks(square, all) & (pieces(by, Rook) | queens)) != 0;
+        }
+
+        static void addPromotions(MoveList& moves, int from, int to, int capture) {
+            for (int type : { Queen, Rook, Bishop, Knight }) {
+                moves.push_back(CompactMove{ from, to, CompactMove::Promotion | capture | (type - Knight) });
+            }
+        }
+
+        void generatePseudoLegalMoves(MoveList& moves) const {
+            int us{ m_side };
+            int them{ us ^ 1 };
+            Bitboard own{ m_colors[us] };
+            Bitboard enemy{ m_colors[them] };
+            Bitboard all{ own | enemy };
+
+            // Bauern
+            int up{ us == White ? 8 : -8 };
+            Bitboard startRank{ us == White ? 0x000000000000FF00ull : 0x00FF000000000000ull };
+            Bitboard lastRank{ us == White ? 0xFF00000000000000ull : 0x00000000000000FFull };
+
+            Bitboard pawns{ pieces(us, Pawn) };
+            while (pawns != 0) {
+                int from{ popLsb(pawns) };
+                int to{ from + up };
+
+                if ((all & bit(to)) == 0) {
+                    if ((bit(to) & lastRank) != 0) {
+                        addPromotions(moves, from, to, 0);
+                    }
+                    else {
+                        moves.push_back(CompactMove{ from, to, CompactMove::Quiet });
+                        if ((bit(from) & startRank) != 0 && (all & bit(to + up)) == 0) {
+                            moves.push_back(CompactMove{ from, to + up, CompactMove::DoublePawnPush });
+                        }
+                    }
+                }
+
+                Bitboard captures{ s_attacks.m_pawn[us][from] & enemy };
+                while (captures != 0) {
+                    int target{ popLsb(captures) };
+                    if ((bit(target) & lastRank) != 0) {
+                        addPromotions(moves, from, target, CompactMove::Capture);
+                    }
+                    else {
+                        moves.push_back(CompactMove{ from, target, CompactMove::Capture });
+                    }
+                }
+
+                if (m_enPassant >= 0 && (s_attacks.m_pawn[us][from] & bit(m_enPassant)) != 0) {
+                    moves.push_back(CompactMove{ from, m_enPassant, CompactMove::EnPassant });
+                }
+            }
+
+            // Springer, Läufer, Türme, Damen und König
+            for (int type{ Knight }; type <= King; ++type) {
+                Bitboard bits{ pieces(us, type) };
+                while (bits != 0) {
+                    int from{ popLsb(bits) };
+                    Bitboard targets{ attacks(type, from, all) & ~own };
+                    while (targets != 0) {
+                        int to{ popLsb(targets) };
+                        moves.push_back(CompactMove{ from, to, (enemy & bit(to)) != 0 ? CompactMove::Capture : CompactMove::Quiet });
+                    }
+                }
+            }
+
+            // Rochade: König und Felder dazwischen dürfen nicht angegriffen sein
+            int base{ us == White ? 0 : 56 };
+            int kingSide{ us == White ? WhiteKingSide : BlackKingSide };
+            int queenSide{ us == White ? WhiteQueenSide : BlackQueenSide };
+
+            if ((m_castling & kingSide) != 0 && (all & (Bitboard{ 0x60 } << base)) == 0 &&
+                !isAttacked(base + 4, them) && !isAttacked(base + 5, them) && !isAttacked(base + 6, them)) {
+                moves.push_back(CompactMove{ base + 4, base + 6, CompactMove::KingCastle });
+            }
+
+            if ((m_castling & queenSide) != 0 && (all & (Bitboard{ 0x0E } << base)) == 0 &&
+                !isAttacked(base + 4, them) && !isAttacked(base + 3, them) && !isAttacked(base + 2, them)) {
+                moves.push_back(CompactMove{ base + 4, base + 2, CompactMove::QueenCastle });
+            }
         }
 
-        void undo() { m_board.undo(); }
-        void play() { m_board.play(); }
+        static Bitboard attacks(int type, int square, Bitboard occupied) {
+            switch (type) {
+            case Knight: return s_attacks.m_knight[square];
+            case Bishop: return bishopAttacks(square, occupied);
+            case Rook:   return rookAttacks(square, occupied);
+            case Queen:  return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+            default:     return s_attacks.m_king[square];
+            }
+        }
+    };
+
+    // Das konkrete Command für die Bitboard-Darstellung
+    class BitboardMove final : public Move {
+    private:
+        BitboardPosition& m_position;
+        CompactMove       m_move;
+        UndoInfo          m_undo{};
+
+    public:
+        BitboardMove(BitboardPosition& position, CompactMove move)
+            : m_position{ position }, m_move{ move }
+        {}
+
+        CompactMove getMove() const { return m_move; }
+
+        void doMove() override { m_position.makeMove(m_move, m_undo); }
+        void undoMove() override { m_position.unmakeMove(m_move, m_undo); }
     };
 
+    // Anzahl der Blattknoten des Spielbaums bis zur Tiefe 'depth';
+    // die Commands liegen auf dem Stack, nicht auf der Halde
+    static std::uint64_t perft(BitboardPosition& position, int depth) {
+        MoveList moves;
+        position.generateLegalMoves(moves);
+
+        if (depth <= 1) {
+            return depth == 1 ? moves.size() : 1;
+        }
+
+        std::uint64_t nodes{};
+        for (CompactMove move : moves) {
+            BitboardMove command{ position, move };
+            command.doMove();
+            nodes += perft(position, depth - 1);
+            command.undoMove();
+        }
+
+        return nodes;
+    }
+
     static void clientCode() {
         ChessGame game;
 
@@ -213,6 +899,211 @@ namespace ChessExample_Modern {
 
         game.undo();
         game.undo();
+
+        game.redo();
+    }
+
+    // Ein ungültiger Zug mitten in play(): Verlauf und Warteschlange bleiben konsistent
+    static void clientCodeInvalidMove() {
+        Board board{ 4 };
+
+        auto tower = std::make_shared<Rook>(false, Position{ 1, 1 });
+
+        board.enqueue<SimpleMove>(tower, Position{ 4, 1 });
+        board.enqueue<SimpleMove>(tower, Position{ 6, 3 });     // diagonal: wirft
+        board.enqueue<SimpleMove>(tower, Position{ 4, 4 });
+
+        try {
+            board.play();
+        }
+        catch (const std::invalid_argument& ex) {
+            std::println("Ungueltiger Zug: {}", ex.what());
+        }
+
+        std::println("Undo: {}, Redo: {}, eingereiht: {}",
+            board.undoCount(), board.redoCount(), board.pendingCount());
+
+        board.discardPending();
+
+        board.enqueue<SimpleMove>(tower, Position{ 4, 8 });
+        board.play();
+
+        board.undo();
+        board.redo();
+        board.undo();
+        board.undo();
+
+        std::println("Undo: {}, Redo: {}, eingereiht: {}, Position: {}/{}",
+            board.undoCount(), board.redoCount(), board.pendingCount(),
+            tower->getCurrentPosition().getX(), tower->getCurrentPosition().getY());
+
+        // redo() wiederholt den ersten Zug, ein neuer Zug verwirft den zweiten
+        board.redo();
+        board.enqueue<SimpleMove>(tower, Position{ 1, 1 });
+        board.play();
+
+        std::println("Undo: {}, Redo: {}, eingereiht: {}, Position: {}/{}",
+            board.undoCount(), board.redoCount(), board.pendingCount(),
+            tower->getCurrentPosition().getX(), tower->getCurrentPosition().getY());
+    }
+
+    static void clientCodeBitboard() {
+        BitboardPosition position;
+        Board board;
+
+        for (std::string_view text : { "e2e4", "e7e5", "g1f3", "b8c6" }) {
+            std::optional<CompactMove> move{ position.parseMove(text) };
+            if (move.has_value()) {
+                board.enqueue<BitboardMove>(position, *move);
+                board.play();
+            }
+        }
+
+        position.print();
+
+        board.undo();
+        board.undo();
+
+        position.print();
+    }
+
+    static void perftBenchmark() {
+        struct PerftTest {
+            std::string_view m_fen;
+            int m_depth;
+            std::uint64_t m_expected;
+        };
+
+        constexpr PerftTest tests[]{
+            { BitboardPosition::StartPosition, 5, 4'865'609 },
+            { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4'085'603 },
+            { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674'624 },
+            { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422'333 }
+        };
+
+        for (const PerftTest& test : tests) {
+            BitboardPosition position{ test.m_fen };
+
+            const auto start{ std::chrono::steady_clock::now() };
+            std::uint64_t nodes{ perft(position, test.m_depth) };
+            const auto end{ std::chrono::steady_clock::now() };
+
+            double seconds{ std::chrono::duration<double>(end - start).count() };
+
+            std::println("perft({}) = {} (erwartet {}), {:.0f} ms, {:.0f} Knoten/s",
+                test.m_depth, nodes, test.m_expected, seconds * 1000.0,
+                seconds > 0.0 ? nodes / seconds : 0.0);
+        }
+    }
+
+    // Verlauf wie bisher: jedes Command eine eigene Heap-Allokation
+    class HeapBoard {
+    private:
+        std::queue<std::unique_ptr<Move>> m_moves;
+        std::stack<std::unique_ptr<Move>> m_undos;
+        std::stack<std::unique_ptr<Move>> m_redos;
+
+    public:
+        void enqueue(std::unique_ptr<Move> move) { m_moves.push(std::move(move)); }
+
+        void play() {
+            while (!m_moves.empty()) {
+                std::unique_ptr<Move> move = std::move(m_moves.front());
+                m_moves.pop();
+                move->doMove();
+                m_undos.push(std::move(move));
+            }
+            m_redos = {};
+        }
+
+        bool undo() {
+            if (m_undos.empty()) return false;
+            m_undos.top()->undoMove();
+            m_redos.push(std::move(m_undos.top()));
+            m_undos.pop();
+            return true;
+        }
+
+        bool redo() {
+            if (m_redos.empty()) return false;
+            m_redos.top()->doMove();
+            m_undos.push(std::move(m_redos.top()));
+            m_redos.pop();
+            return true;
+        }
+    };
+
+    static void historyBenchmark() {
+        // Zugfolge einer zufälligen Partie
+        BitboardPosition position;
+        std::vector<CompactMove> line;
+        std::uint32_t seed{ 4711 };
+
+        for (int ply{}; ply < 200; ++ply) {
+            MoveList moves;
+            position.generateLegalMoves(moves);
+            if (moves.size() == 0) break;
+
+            seed = seed * 1664525u + 1013904223u;
+            CompactMove move{ *(moves.begin() + (seed >> 8) % moves.size()) };
+            UndoInfo undo;
+            position.makeMove(move, undo);
+            line.push_back(move);
+        }
+
+        constexpr int Rounds{ 50'000 };
+
+        auto run = [&](auto& board, auto enqueue) {
+            BitboardPosition start;
+            std::uint64_t commands{};
+
+            const auto begin{ std::chrono::steady_clock::now() };
+
+            for (int round{}; round < Rounds; ++round) {
+                for (CompactMove move : line) {
+                    enqueue(board, start, move);
+                    board.play();
+                }
+                while (board.undo()) ++commands;
+                while (board.redo()) ++commands;
+                while (board.undo()) ++commands;
+                commands += line.size();
+            }
+
+            const auto end{ std::chrono::steady_clock::now() };
+            return std::pair{ commands, std::chrono::duration<double>(end - begin).count() };
+        };
+
+        HeapBoard heapBoard;
+        auto [heapCommands, heapSeconds] = run(heapBoard,
+            [](HeapBoard& board, BitboardPosition& position, CompactMove move) {
+                board.enqueue(std::make_unique<BitboardMove>(position, move));
+            }
+        );
+
+        // Tiefe ausreichend für die ganze Partie, sonst würde kompaktiert
+        Board ringBoard{ 256 };
+        auto [ringCommands, ringSeconds] = run(ringBoard,
+            [](Board& board, BitboardPosition& position, CompactMove move) {
+                board.enqueue<BitboardMove>(position, move);
+            }
+        );
+
+        std::println("Verlauf mit unique_ptr: {} Commands, {:.0f} ms, {:.0f} Commands/s",
+            heapCommands, heapSeconds * 1000.0, heapCommands / heapSeconds);
+        std::println("Verlauf im Ringpuffer:  {} Commands, {:.0f} ms, {:.0f} Commands/s",
+            ringCommands, ringSeconds * 1000.0, ringCommands / ringSeconds);
+
+        // Kompaktierung: eine lange Partie in einem Verlauf der Tiefe 16
+        BitboardPosition replay;
+        Board shortBoard{ 16 };
+        for (CompactMove move : line) {
+            shortBoard.enqueue<BitboardMove>(replay, move);
+            shortBoard.play();
+        }
+
+        std::println("Tiefe {}: {} Zuege ausgefuehrt, {} rueckgaengig machbar, {} kompaktiert",
+            shortBoard.depth(), line.size(), shortBoard.undoCount(), shortBoard.compactedCount());
     }
 }
 
@@ -221,6 +1112,22 @@ void test_chess_example_modern() {
     using namespace ChessExample_Modern;
 
     clientCode();
+    clientCodeInvalidMove();
+    clientCodeBitboard();
+}
+
+void benchmark_chess_perft() {
+
+    using namespace ChessExample_Modern;
+
+    perftBenchmark();
+}
+
+void benchmark_command_history() {
+
+    using namespace ChessExample_Modern;
+
+    historyBenchmark();
 }
 
 // ===========================================================================
@@ -8,6 +8,8 @@ extern void test_conceptual_example_02();
 
 extern void test_chess_example_classic();
 extern void test_chess_example_modern();
+extern void benchmark_chess_perft();
+extern void benchmark_command_history();
 
 int main()
 {
@@ -16,6 +18,8 @@ int main()
 
     test_chess_example_classic();
     test_chess_example_modern();
+    benchmark_chess_perft();
+    benchmark_command_history();
 
     return 0;
 }
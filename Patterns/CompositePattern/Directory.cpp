@@ -5,32 +5,56 @@
 #include "Directory.h"
 
 #include <memory>
+#include <memory_resource>
 #include <print>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // c'tor(s)
-Directory::Directory(std::string name) : m_name{ std::move(name) } {}
+Directory::Directory(std::string_view name, std::pmr::memory_resource* resource)
+    : m_name{ name, resource }, m_contents{ resource }, m_size{}, m_attached{}
+{}
 
 // getter
-const std::string& Directory::getName() const noexcept { return m_name; }
+const std::pmr::string& Directory::getName() const noexcept { return m_name; }
+
+std::size_t Directory::size() const noexcept { return m_size; }
+
+std::size_t Directory::count() const noexcept { return m_contents.size(); }
 
 // public interface
+void Directory::reserve(std::size_t count) {
+    m_contents.reserve(count);
+}
+
 void Directory::addFileComponent(std::unique_ptr<IFileComponent> component) {
+    addFileComponent(FileComponentPtr{ component.release() });
+}
+
+void Directory::addFileComponent(FileComponentPtr component) {
+    if (m_attached) {
+        throw std::logic_error{ "Directory already added to a parent: its aggregate size would be stale" };
+    }
+
+    component->attach();
+    m_size += component->size();
     m_contents.push_back(std::move(component));
 }
 
-void Directory::display(std::size_t depth) const /*override*/ {
+void Directory::attach() noexcept {
+    m_attached = true;
+}
 
-    //std::string s{ indent + indent };
-    //std::println("{}{}", s, m_name);
+void Directory::display(std::size_t depth) const /*override*/ {
 
     std::print("{:{}}", "", depth * 2);
-    std::println("{}", m_name);
+    std::println("{} - Size: {}", m_name, m_size);
 
-    //for (const auto& fileComponent : m_contents) {
-    //    fileComponent->display(fileComponent);
-    //}
+    for (const auto& fileComponent : m_contents) {
+        fileComponent->display(depth + 1);
+    }
 }
 
 // ===========================================================================
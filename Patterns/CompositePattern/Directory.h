@@ -7,27 +7,43 @@
 #include "FileComponent.h"
 
 #include <cstddef>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
 
+// The aggregate size of a directory is computed while components are added:
+// a subdirectory must be complete, when it is added to its parent.
+// Adding components to a directory, which already has a parent, throws.
 class Directory final : public IFileComponent
 {
 public:
-    // c'tor
-    Directory(std::string name);
+    // c'tor - name and contents are allocated from the given memory resource
+    Directory(std::string_view name, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     // getter
     [[nodiscard]]
-    const std::string& getName() const noexcept;
+    const std::pmr::string& getName() const noexcept;
+
+    [[nodiscard]]
+    std::size_t size() const noexcept override;
+
+    [[nodiscard]]
+    std::size_t count() const noexcept;
 
     // public interface
+    void reserve(std::size_t count);
     void addFileComponent(std::unique_ptr<IFileComponent> component);
+    void addFileComponent(FileComponentPtr component);
     void display(std::size_t depth/* = 0*/) const override;
+    void attach() noexcept override;
 
 private:
-    std::string m_name;
-    std::vector<std::unique_ptr<IFileComponent>> m_contents;
+    std::pmr::string m_name;
+    std::pmr::vector<FileComponentPtr> m_contents;
+    std::size_t m_size;     // aggregated when a component is added
+    bool m_attached;        // added to a parent directory, contents are final
 };
 
 // ===========================================================================
@@ -5,19 +5,21 @@
 #include "File.h"
 
 #include <cstddef>
+#include <memory_resource>
 #include <print>
 #include <string>
+#include <string_view>
 
 // c'tor(s)
 File::File() : m_size{} {}
 
-File::File(std::string name, std::size_t size)
-    : m_name{ std::move(name) }, m_size{ size }
+File::File(std::string_view name, std::size_t size, std::pmr::memory_resource* resource)
+    : m_name{ name, resource }, m_size{ size }
 {}
 
 // getter
 [[nodiscard]]
-const std::string& File::name() const noexcept { return m_name; }
+const std::pmr::string& File::name() const noexcept { return m_name; }
 
 [[nodiscard]]
 std::size_t File::size() const noexcept { return m_size; }
@@ -7,21 +7,23 @@
 #include "FileComponent.h"
 
 #include <cstddef>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 class File final : public IFileComponent {
 public:
     File();
-    File(std::string name, std::size_t size);
+    File(std::string_view name, std::size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     // getter
-    [[nodiscard]] const std::string& name() const noexcept;
-    [[nodiscard]] std::size_t size() const noexcept;
+    [[nodiscard]] const std::pmr::string& name() const noexcept;
+    [[nodiscard]] std::size_t size() const noexcept override;
 
     void display(std::size_t depth /*= 0*/) const override;
 
 private:
-    std::string m_name;
+    std::pmr::string m_name;
     std::size_t m_size;
 };
 
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 
 class IFileComponent
 {
@@ -12,8 +13,32 @@ public:
     virtual ~IFileComponent() = default;
 
     virtual void display(std::size_t depth /*= 0*/) const = 0;
+
+    // size of a file or aggregate size of a directory
+    [[nodiscard]] virtual std::size_t size() const noexcept = 0;
+
+    // called when the component is added to a directory
+    virtual void attach() noexcept {}
 };
 
+// deleter for components either created with new or placed into an arena:
+// arena memory is released as a whole, so only the destructor is called
+struct FileComponentDeleter
+{
+    bool m_inArena{ false };
+
+    void operator()(IFileComponent* component) const noexcept {
+        if (m_inArena) {
+            component->~IFileComponent();
+        }
+        else {
+            delete component;
+        }
+    }
+};
+
+using FileComponentPtr = std::unique_ptr<IFileComponent, FileComponentDeleter>;
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
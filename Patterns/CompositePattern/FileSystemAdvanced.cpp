@@ -6,11 +6,34 @@
 #include "File.h"
 #include "Directory.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <filesystem>
+#include <fstream>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <print>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 static void exploreDirectory(const std::filesystem::path& path, const std::unique_ptr<Directory>& dir) {
 
@@ -22,23 +45,24 @@ static void exploreDirectory(const std::filesystem::path& path, const std::uniqu
 
             if (std::filesystem::is_directory(entry.status())) {
 
-                /*const*/ std::unique_ptr<IFileComponent> subDir{
+                std::unique_ptr<Directory> subDir{
                     std::make_unique<Directory>(filename.string())
                 };
-                
-                dir->addFileComponent(std::move(subDir)); 
-  
-              //  exploreDirectory(entry, std::dynamic_pointer_cast<Directory> (subDir));
+
+                exploreDirectory(entry.path(), subDir);
+
+                // add the complete subdirectory, so that its size is aggregated
+                dir->addFileComponent(std::move(subDir));
             }
             else if (std::filesystem::is_regular_file(entry.status())) {
 
                 std::error_code err{ std::error_code{} };
 
                 std::uintmax_t filesize = std::filesystem::file_size(entry, err);
-                
+
                 std::unique_ptr<IFileComponent> file =
                     std::make_unique<File>(filename.string(), static_cast<std::size_t>(filesize));
-                
+
                 dir->addFileComponent(std::move(file));
             }
         }
@@ -47,8 +71,447 @@ static void exploreDirectory(const std::filesystem::path& path, const std::uniqu
 
 // ===========================================================================
 
+namespace FileSystemTreeBuilding {
+
+    /**
+     * Sources of directory entries for the tree builder. A source defines a Location
+     * type and a scan method, which invokes
+     *
+     *     onEntry(std::string_view name, bool isDirectory, std::size_t size, const Location& location)
+     *
+     * for every entry of the directory at the given location.
+     */
+    class FileSystemSource
+    {
+    public:
+        using Location = std::filesystem::path;
+
+        template <typename TCallback>
+        void scan(const Location& path, TCallback&& onEntry) const
+        {
+            std::error_code err{};
+
+            for (std::filesystem::directory_iterator it{ path, err }, end{}; !err && it != end; it.increment(err)) {
+
+                const std::filesystem::directory_entry& entry{ *it };
+                const std::string filename{ entry.path().filename().string() };
+
+                if (entry.is_directory(err)) {
+                    onEntry(filename, true, 0, entry.path());
+                }
+                else if (entry.is_regular_file(err)) {
+                    std::uintmax_t filesize{ entry.file_size(err) };
+                    onEntry(filename, false, err ? 0 : static_cast<std::size_t>(filesize), entry.path());
+                }
+            }
+        }
+    };
+
+    // generates a regular tree of directories and files in memory, used for large benchmarks
+    class SyntheticSource
+    {
+    private:
+        std::size_t m_depth;
+        std::size_t m_subdirectories;
+        std::size_t m_files;
+
+    public:
+        struct Location
+        {
+            std::size_t   m_level;
+            std::uint64_t m_id;
+        };
+
+        SyntheticSource(std::size_t depth, std::size_t subdirectories, std::size_t files)
+            : m_depth{ depth }, m_subdirectories{ subdirectories }, m_files{ files }
+        {}
+
+        std::size_t entryCount() const noexcept
+        {
+            std::size_t directories{ 1 };
+            std::size_t count{};
+            for (std::size_t level{}; level <= m_depth; ++level) {
+                count += directories * m_files;
+                if (level < m_depth) {
+                    directories *= m_subdirectories;
+                    count += directories;
+                }
+            }
+            return count;
+        }
+
+        template <typename TCallback>
+        void scan(const Location& location, TCallback&& onEntry) const
+        {
+            char name[32]{};
+
+            for (std::size_t i{}; i != m_files; ++i) {
+                auto length{ std::snprintf(name, sizeof(name), "file_%zu.dat", i) };
+                std::size_t size{ static_cast<std::size_t>((location.m_id * 31 + i * 17) % 100'000) };
+                onEntry(std::string_view{ name, static_cast<std::size_t>(length) }, false, size, location);
+            }
+
+            if (location.m_level < m_depth) {
+                for (std::size_t i{}; i != m_subdirectories; ++i) {
+                    auto length{ std::snprintf(name, sizeof(name), "directory_%zu", i) };
+                    Location child{ location.m_level + 1, location.m_id * m_subdirectories + i };
+                    onEntry(std::string_view{ name, static_cast<std::size_t>(length) }, true, 0, child);
+                }
+            }
+        }
+    };
+
+    /**
+     * A composite tree whose nodes live in monotonic arenas: one arena per worker thread,
+     * so no arena is shared between threads. The arenas are released as a whole,
+     * after the nodes have been destroyed.
+     */
+    class FileSystemTree
+    {
+    private:
+        std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> m_arenas;
+        FileComponentPtr m_root;
+
+        template <typename TSource>
+        friend class FileSystemTreeBuilder;
+
+    public:
+        FileSystemTree() = default;
+
+        ~FileSystemTree()
+        {
+            m_root.reset();     // nodes first, arenas afterwards
+        }
+
+        FileSystemTree(FileSystemTree&&) noexcept = default;
+        FileSystemTree& operator=(FileSystemTree&&) noexcept = delete;
+
+        const Directory& root() const noexcept { return static_cast<const Directory&>(*m_root); }
+
+        std::size_t arenaCount() const noexcept { return m_arenas.size(); }
+    };
+
+    /**
+     * Builds the complete composite tree of a source in three steps:
+     *   1. The directories above parallelDepth are scanned on the calling thread,
+     *      the subtrees at parallelDepth are collected as tasks.
+     *   2. A fixed number of worker threads (hardware_concurrency by default) take
+     *      the tasks one after another and build each subtree recursively,
+     *      every worker allocates from an arena of its own.
+     *   3. The calling thread adds the completed subtrees to their parents, bottom-up.
+     * Aggregate sizes are computed in the same pass: a subdirectory is added to its
+     * parent only when it is complete.
+     */
+    template <typename TSource>
+    class FileSystemTreeBuilder
+    {
+    private:
+        using Location = typename TSource::Location;
+
+        struct Entry
+        {
+            std::string m_name;
+            Location    m_location;
+        };
+
+        struct FileEntry
+        {
+            std::size_t m_offset;
+            std::size_t m_length;
+            std::size_t m_size;
+        };
+
+        // directory of the upper levels, its subdirectories are added in step 3
+        struct Node
+        {
+            FileComponentPtr         m_component;
+            std::vector<std::size_t> m_children;
+        };
+
+        // subtree to be built by a worker, the result is stored in m_nodes[m_node]
+        struct Task
+        {
+            Entry       m_entry;
+            std::size_t m_node;
+        };
+
+        const TSource& m_source;
+        std::size_t    m_parallelDepth;
+        std::size_t    m_workers;
+        std::size_t    m_initialArenaSize;
+        std::vector<Node> m_nodes;
+        std::vector<Task> m_tasks;
+        FileSystemTree* m_tree;
+
+    public:
+        FileSystemTreeBuilder(
+            const TSource& source,
+            std::size_t parallelDepth = 2,
+            std::size_t workers = std::thread::hardware_concurrency(),
+            std::size_t initialArenaSize = 64 * 1024)
+            : m_source{ source }, m_parallelDepth{ parallelDepth }, m_workers{ workers == 0 ? 1 : workers },
+              m_initialArenaSize{ initialArenaSize }, m_tree{}
+        {}
+
+        FileSystemTree build(std::string_view name, const Location& location)
+        {
+            FileSystemTree tree{};
+            m_tree = &tree;
+            m_nodes.clear();
+            m_tasks.clear();
+
+            std::size_t root{ expand(name, location, 0, newArena()) };
+            runTasks();
+            tree.m_root = assemble(root);
+
+            m_nodes.clear();
+            m_tasks.clear();
+            m_tree = nullptr;
+            return tree;
+        }
+
+    private:
+        std::pmr::memory_resource* newArena()
+        {
+            m_tree->m_arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(m_initialArenaSize));
+            return m_tree->m_arenas.back().get();
+        }
+
+        template <typename TComponent, typename... TArgs>
+        static FileComponentPtr makeInArena(std::pmr::memory_resource* arena, TArgs&&... args)
+        {
+            void* memory{ arena->allocate(sizeof(TComponent), alignof(TComponent)) };
+            TComponent* component{ ::new (memory) TComponent{ std::forward<TArgs>(args)..., arena } };
+            return FileComponentPtr{ component, FileComponentDeleter{ true } };
+        }
+
+        // step 1: returns the index of the node of the given directory
+        std::size_t expand(std::string_view name, const Location& location, std::size_t depth, std::pmr::memory_resource* arena)
+        {
+            const std::size_t index{ m_nodes.size() };
+            m_nodes.emplace_back();
+
+            if (depth >= m_parallelDepth) {
+                m_tasks.push_back(Task{ Entry{ std::string{ name }, location }, index });
+                return index;
+            }
+
+            std::vector<Entry> subdirectories{};
+            FileComponentPtr component{ scanDirectory(name, location, arena, subdirectories) };
+
+            std::vector<std::size_t> children{};
+            children.reserve(subdirectories.size());
+            for (const Entry& entry : subdirectories) {
+                children.push_back(expand(entry.m_name, entry.m_location, depth + 1, arena));
+            }
+
+            // m_nodes may have grown meanwhile
+            m_nodes[index].m_component = std::move(component);
+            m_nodes[index].m_children = std::move(children);
+            return index;
+        }
+
+        // step 2: a bounded number of threads, the calling thread is one of them
+        void runTasks()
+        {
+            const std::size_t workers{ std::min(m_workers, m_tasks.size()) };
+
+            std::vector<std::pmr::memory_resource*> arenas{};
+            for (std::size_t i{}; i != workers; ++i) {
+                arenas.push_back(newArena());
+            }
+
+            std::atomic<std::size_t> next{};
+            std::mutex mutex{};
+            std::exception_ptr exception{};
+
+            auto work = [&](std::pmr::memory_resource* arena) {
+                try {
+                    for (std::size_t i{ next++ }; i < m_tasks.size(); i = next++) {
+                        const Task& task{ m_tasks[i] };
+                        m_nodes[task.m_node].m_component = buildDirectory(task.m_entry.m_name, task.m_entry.m_location, arena);
+                    }
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> guard{ mutex };
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                    next = m_tasks.size();
+                }
+            };
+
+            std::vector<std::thread> threads{};
+            for (std::size_t i{ 1 }; i < workers; ++i) {
+                threads.emplace_back(work, arenas[i]);
+            }
+
+            if (workers != 0) {
+                work(arenas[0]);
+            }
+
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        // step 3: subdirectories are complete before they are added
+        FileComponentPtr assemble(std::size_t index)
+        {
+            Node& node{ m_nodes[index] };
+            if (!node.m_children.empty()) {
+                Directory& dir{ static_cast<Directory&>(*node.m_component) };
+                for (std::size_t child : node.m_children) {
+                    dir.addFileComponent(assemble(child));
+                }
+            }
+
+            return std::move(node.m_component);
+        }
+
+        // creates the directory with all of its files, the subdirectories are returned
+        FileComponentPtr scanDirectory(std::string_view name, const Location& location, std::pmr::memory_resource* arena, std::vector<Entry>& subdirectories)
+        {
+            FileComponentPtr component{ makeInArena<Directory>(arena, name) };
+            Directory& dir{ static_cast<Directory&>(*component) };
+
+            // collect the entries first, so that the contents of the directory are
+            // allocated from the arena exactly once
+            std::string fileNames{};
+            std::vector<FileEntry> files{};
+
+            m_source.scan(location, [&](std::string_view entryName, bool isDirectory, std::size_t size, const Location& entryLocation) {
+                if (isDirectory) {
+                    subdirectories.push_back(Entry{ std::string{ entryName }, entryLocation });
+                }
+                else {
+                    files.push_back(FileEntry{ fileNames.size(), entryName.size(), size });
+                    fileNames += entryName;
+                }
+            });
+
+            dir.reserve(files.size() + subdirectories.size());
+
+            for (const FileEntry& file : files) {
+                std::string_view fileName{ fileNames.data() + file.m_offset, file.m_length };
+                dir.addFileComponent(makeInArena<File>(arena, fileName, file.m_size));
+            }
+
+            return component;
+        }
+
+        // complete subtree, built by a single worker
+        FileComponentPtr buildDirectory(std::string_view name, const Location& location, std::pmr::memory_resource* arena)
+        {
+            std::vector<Entry> subdirectories{};
+            FileComponentPtr component{ scanDirectory(name, location, arena, subdirectories) };
+            Directory& dir{ static_cast<Directory&>(*component) };
+
+            for (const Entry& entry : subdirectories) {
+                dir.addFileComponent(buildDirectory(entry.m_name, entry.m_location, arena));
+            }
+
+            return component;
+        }
+    };
+
+    // baseline: one std::make_unique per node, single thread
+    template <typename TSource>
+    void exploreTree(const TSource& source, const typename TSource::Location& location, Directory& dir)
+    {
+        source.scan(location, [&](std::string_view name, bool isDirectory, std::size_t size, const typename TSource::Location& entryLocation) {
+            if (isDirectory) {
+                std::unique_ptr<Directory> subDir{ std::make_unique<Directory>(name) };
+                exploreTree(source, entryLocation, *subDir);
+                dir.addFileComponent(std::move(subDir));
+            }
+            else {
+                dir.addFileComponent(std::make_unique<File>(name, size));
+            }
+        });
+    }
+
+    // resident set size of the process: current and peak value in bytes
+    static std::pair<std::size_t, std::size_t> residentSetSize()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters))) {
+            return { counters.WorkingSetSize, counters.PeakWorkingSetSize };
+        }
+        return { 0, 0 };
+#elif defined(__linux__)
+        std::size_t current{};
+        std::ifstream statm{ "/proc/self/statm" };
+        std::size_t pages{};
+        if (statm >> pages >> current) {
+            current *= static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        }
+
+        struct rusage usage {};
+        ::getrusage(RUSAGE_SELF, &usage);
+        return { current, static_cast<std::size_t>(usage.ru_maxrss) * 1024 };
+#else
+        return { 0, 0 };
+#endif
+    }
+
+    static void benchmark()
+    {
+        // 10 subdirectories per directory, 5 levels, 44 files per directory: ~ 5 million entries
+        SyntheticSource source{ 5, 10, 44 };
+        SyntheticSource::Location root{ 0, 0 };
+
+        std::println("Composite tree with {} entries:", source.entryCount());
+
+        std::size_t arenaSize{};
+        {
+            auto [before, _] { residentSetSize() };
+            const auto start{ std::chrono::high_resolution_clock::now() };
+
+            FileSystemTreeBuilder<SyntheticSource> builder{ source };
+            FileSystemTree tree{ builder.build("root", root) };
+
+            const auto end{ std::chrono::high_resolution_clock::now() };
+            auto [after, peak] { residentSetSize() };
+
+            arenaSize = tree.root().size();
+
+            std::println("  Arenas, parallel:       {} msecs, RSS +{} MB, peak RSS {} MB ({} arenas)",
+                std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(),
+                (after - before) / (1024 * 1024), peak / (1024 * 1024), tree.arenaCount());
+        }
+
+        std::size_t uniqueSize{};
+        {
+            auto [before, _] { residentSetSize() };
+            const auto start{ std::chrono::high_resolution_clock::now() };
+
+            std::unique_ptr<Directory> dir{ std::make_unique<Directory>("root") };
+            exploreTree(source, root, *dir);
+
+            const auto end{ std::chrono::high_resolution_clock::now() };
+            auto [after, peak] { residentSetSize() };
+
+            uniqueSize = dir->size();
+
+            std::println("  unique_ptr per node:    {} msecs, RSS +{} MB, peak RSS {} MB",
+                std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(),
+                (after - before) / (1024 * 1024), peak / (1024 * 1024));
+        }
+
+        std::println("  Aggregate sizes {} ({} bytes)", arenaSize == uniqueSize ? "match" : "DIFFER", arenaSize);
+    }
+}
+
+// ===========================================================================
+
 // directory with less files, no subdirectories
-// 
+//
 // Absolute path:
 // constexpr const char* path1 =
 //    R"(C:\Development\GitHub_Cpp_Repositories\Cpp_Design_Patterns\Patterns\CompositePattern\Resources)";
@@ -78,6 +541,29 @@ void test_filesystem_02_advanced() {
     }
 }
 
+void test_filesystem_03_parallel() {
+
+    using namespace FileSystemTreeBuilding;
+
+    std::string s{ path2 };
+    std::filesystem::path path{ s };
+
+    if (!std::filesystem::exists(path)) {
+        std::println("Given path does not exist: {}", s);
+    }
+    else {
+        FileSystemSource source{};
+        FileSystemTreeBuilder<FileSystemSource> builder{ source };
+        FileSystemTree tree{ builder.build(s, path) };
+        tree.root().display(0);
+    }
+}
+
+void benchmark_filesystem_tree()
+{
+    FileSystemTreeBuilding::benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -56,8 +56,8 @@ void test_filesystem_01_beginners() {
     dir2->addFileComponent(std::move(file3));
     dir3->addFileComponent(std::move(file4));
     dir3->addFileComponent(std::move(file5));
-    dir1->addFileComponent(std::move(dir2));
     dir2->addFileComponent(std::move(dir3));
+    dir1->addFileComponent(std::move(dir2));
 
     dir1->display(0);
 }
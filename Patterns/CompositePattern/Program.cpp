@@ -21,6 +21,8 @@ extern void test_shapes();
 
 extern void test_filesystem_01_beginners();
 extern void test_filesystem_02_advanced();
+extern void test_filesystem_03_parallel();
+extern void benchmark_filesystem_tree();
 
 int main()
 {
@@ -33,6 +35,8 @@ int main()
 
     //test_filesystem_01_beginners();
     test_filesystem_02_advanced();
+    test_filesystem_03_parallel();
+    //benchmark_filesystem_tree();
 
     return 0;
 }
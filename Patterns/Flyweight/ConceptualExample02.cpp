@@ -2,12 +2,18 @@
 // ConceptualExample02.cpp - Flyweight Pattern
 // ===========================================================================
 
+#include "FlyweightPool.h"
+
+#include <chrono>
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <print>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 // Another example of the flyweight pattern
 namespace ConceptualExample02 {
@@ -32,6 +38,22 @@ namespace ConceptualExample02 {
         {}
     };
 
+    // non-owning view of an intrinsic state, used for lookups without temporary strings
+    struct SharedStateView
+    {
+        std::string_view m_brand;
+        std::string_view m_model;
+        std::string_view m_color;
+
+        SharedStateView(std::string_view brand, std::string_view model, std::string_view color)
+            : m_brand{ brand }, m_model{ model }, m_color{ color }
+        {}
+
+        SharedStateView(const SharedState& state)
+            : m_brand{ state.m_brand }, m_model{ state.m_model }, m_color{ state.m_color }
+        {}
+    };
+
     class UniqueState
     {
     public:
@@ -107,61 +129,83 @@ namespace ConceptualExample02 {
 
 namespace ConceptualExample02 {
 
+    /**
+     * Describes the intrinsic state of a Flyweight for the flyweight pool:
+     * the hash is computed directly from the string views, no key is concatenated.
+     */
+    struct FlyweightTraits
+    {
+        static std::size_t hash(const SharedStateView& view) noexcept {
+            return FlyweightPool::hashStrings({ view.m_brand, view.m_model, view.m_color });
+        }
+
+        static bool equal(const Flyweight& flyweight, const SharedStateView& view) noexcept {
+            const SharedState& ss{ flyweight.getSharedState() };
+            return ss.m_brand == view.m_brand && ss.m_model == view.m_model && ss.m_color == view.m_color;
+        }
+
+        static Flyweight make(const SharedStateView& view) {
+            return Flyweight{ SharedState{ std::string{ view.m_brand }, std::string{ view.m_model }, std::string{ view.m_color } } };
+        }
+    };
+
+    using FlyweightHandle = FlyweightPool::Handle;
+
     /**
      * The Flyweight Factory creates and manages the Flyweight objects. It ensures
      * that flyweights are shared correctly. When the client requests a flyweight,
      * the factory either returns an existing instance or creates a new one, if it
      * doesn't exist yet.
+     *
+     * The flyweights are kept in a sharded pool, clients receive a 32-bit handle
+     * which stays valid as long as the factory lives. getFlyweight may be called
+     * concurrently from several threads.
      */
     class FlyweightFactory
     {
     private:
-        std::unordered_map<std::string, Flyweight> m_flyweights;
-
-        // generates the key as a string for comparisons
-        static std::string getKey(const SharedState& ss) {
-            return ss.m_brand + "_" + ss.m_model + "_" + ss.m_color;
-        }
+        FlyweightPool::ShardedFlyweightPool<Flyweight, FlyweightTraits> m_flyweights;
+        bool m_verbose;
 
     public:
-        FlyweightFactory(std::initializer_list<SharedState> share_states) {
+        FlyweightFactory(std::initializer_list<SharedState> share_states, bool verbose = true)
+            : m_verbose{ verbose }
+        {
             for (const auto& state : share_states) {
-                auto key = getKey(state);
-                m_flyweights.try_emplace(std::move(key), state);
+                m_flyweights.acquire(SharedStateView{ state });
             }
         }
 
         /**
-         * Returns an existing Flyweight with a given state or creates a new one (using a const reference)
+         * Returns the handle of an existing Flyweight with a given state or creates a new one
          */
 
-        const Flyweight& getFlyweight(const SharedState& sharedState) {
+        FlyweightHandle getFlyweight(const SharedStateView& sharedState) {
 
-            auto key = getKey(sharedState);
+            bool inserted{};
+            FlyweightHandle handle{ m_flyweights.acquire(sharedState, inserted) };
 
-            auto [it, inserted] = m_flyweights.try_emplace(key, sharedState);
-
-            if (inserted) {
+            if (m_verbose) {
                 std::println(
-                    "FlyweightFactory: creating new flyweight ({}).",
-                    sharedState);
-            }
-            else {
-                std::println(
-                    "FlyweightFactory: reusing existing flyweight ({}).",
-                    sharedState);
+                    "FlyweightFactory: {} flyweight ({}-{}-{}).",
+                    inserted ? "creating new" : "reusing existing",
+                    sharedState.m_brand, sharedState.m_model, sharedState.m_color);
             }
 
-            return it->second;
+            return handle;
         }
 
-        std::size_t flyweightCount() const noexcept { return m_flyweights.size(); }
+        const Flyweight& operator[](FlyweightHandle handle) const noexcept {
+            return m_flyweights.get(handle);
+        }
+
+        std::size_t flyweightCount() const { return m_flyweights.size(); }
 
         void listFlyweights() const {
             std::println("FlyweightFactory: {} flyweights:", m_flyweights.size());
-            for (const auto& [key, _] : m_flyweights) { // C++ 17 Structured Binding
-                std::println("{}", key);
-            }
+            m_flyweights.forEach([](FlyweightHandle handle, const Flyweight& flyweight) {
+                std::println("{:08X}: {}", handle.id(), flyweight.getSharedState());
+            });
         }
     };
 
@@ -176,9 +220,9 @@ namespace ConceptualExample02 {
         std::println();
         std::println("Client: Adding a car to database.");
 
-        SharedState sharedState{ brand, model, color };
+        SharedStateView sharedState{ brand, model, color };
 
-        const Flyweight& flyweight = factory.getFlyweight(sharedState);
+        const Flyweight& flyweight = factory[factory.getFlyweight(sharedState)];
 
         // client code passes unique state to the Flyweight's methods
 
@@ -195,13 +239,102 @@ namespace ConceptualExample02 {
         std::println();
         std::println("Client: Adding a car to database.");
 
-        const Flyweight& flyweight = factory.getFlyweight(sharedState);
+        const Flyweight& flyweight = factory[factory.getFlyweight(sharedState)];
 
         // client code passes unique state to the Flyweight's methods
         flyweight.operation(uniqueState);
     }
 }
 
+namespace ConceptualExample02 {
+
+    // baseline: string keys concatenated on every lookup, a single lock for the whole map
+    class StringKeyFlyweightFactory
+    {
+    private:
+        std::unordered_map<std::string, Flyweight> m_flyweights;
+        std::mutex m_mutex;
+
+        static std::string getKey(const SharedState& ss) {
+            return ss.m_brand + "_" + ss.m_model + "_" + ss.m_color;
+        }
+
+    public:
+        const Flyweight& getFlyweight(const SharedState& sharedState) {
+            auto key = getKey(sharedState);
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            auto [it, inserted] = m_flyweights.try_emplace(std::move(key), sharedState);
+            return it->second;
+        }
+
+        std::size_t flyweightCount() const noexcept { return m_flyweights.size(); }
+    };
+
+    static void benchmark()
+    {
+        constexpr std::size_t Lookups{ 2'000'000 };
+        constexpr std::size_t Threads{ 4 };
+
+        const std::vector<std::string> brands{ "Chevrolet", "Mercedes Benz", "BMW", "Volkswagen", "Toyota", "Renault", "Peugeot", "Fiat" };
+        const std::vector<std::string> models{ "Camaro2018", "C300", "C500", "M5", "X6", "X1", "Golf", "Passat" };
+        const std::vector<std::string> colors{ "pink", "black", "red", "white", "blue", "green", "silver", "yellow" };
+
+        std::vector<SharedState> states;
+        for (const auto& brand : brands) {
+            for (const auto& model : models) {
+                for (const auto& color : colors) {
+                    states.emplace_back(brand, model, color);
+                }
+            }
+        }
+
+        auto measure = [&](auto lookup) {
+            std::vector<std::thread> threads;
+            std::vector<std::size_t> checksums(Threads);
+
+            const auto start{ std::chrono::high_resolution_clock::now() };
+
+            for (std::size_t t{}; t != Threads; ++t) {
+                threads.emplace_back([&, t]() {
+                    std::size_t checksum{};
+                    for (std::size_t i{ t }; i < Lookups; i += Threads) {
+                        checksum += lookup(states[(i * 7919) % states.size()]).getSharedState().m_color.size();
+                    }
+                    checksums[t] = checksum;
+                });
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            const auto end{ std::chrono::high_resolution_clock::now() };
+
+            std::size_t checksum{};
+            for (std::size_t value : checksums) {
+                checksum += value;
+            }
+
+            return std::pair{ std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), checksum };
+        };
+
+        StringKeyFlyweightFactory stringKeyFactory;
+        auto [stringKeyMsecs, stringKeyChecksum] = measure([&](const SharedState& state) -> const Flyweight& {
+            return stringKeyFactory.getFlyweight(state);
+        });
+
+        FlyweightFactory pooledFactory{ {}, false };
+        auto [pooledMsecs, pooledChecksum] = measure([&](const SharedState& state) -> const Flyweight& {
+            return pooledFactory[pooledFactory.getFlyweight(state)];
+        });
+
+        std::println("{} lookups of {} flyweights, {} threads:", Lookups, states.size(), Threads);
+        std::println("  String keys, single lock:   {} msecs ({} flyweights)", stringKeyMsecs, stringKeyFactory.flyweightCount());
+        std::println("  Sharded pool, hashed views: {} msecs ({} flyweights)", pooledMsecs, pooledFactory.flyweightCount());
+        std::println("  Checksums {}", stringKeyChecksum == pooledChecksum ? "match" : "DIFFER");
+    }
+}
+
 static void test_conceptual_example_02_a() {
 
     using namespace ConceptualExample02;
@@ -296,6 +429,11 @@ void test_conceptual_example_02()
     test_conceptual_example_02_b();
 }
 
+void benchmark_conceptual_example_02()
+{
+    ConceptualExample02::benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
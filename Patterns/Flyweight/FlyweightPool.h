@@ -0,0 +1,305 @@
+// ===========================================================================
+// FlyweightPool.h - Flyweight Pattern
+// ===========================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace FlyweightPool {
+
+    /**
+     * Stable 32-bit identifier of a flyweight inside a ShardedFlyweightPool.
+     * The upper bits select the shard, the lower bits the slot within the shard.
+     * A handle stays valid for the whole lifetime of the pool.
+     */
+    class Handle
+    {
+    private:
+        std::uint32_t m_id;
+
+    public:
+        static constexpr std::uint32_t Invalid = 0xFFFFFFFFu;
+
+        constexpr Handle() noexcept : m_id{ Invalid } {}
+        constexpr explicit Handle(std::uint32_t id) noexcept : m_id{ id } {}
+
+        constexpr std::uint32_t id() const noexcept { return m_id; }
+        constexpr bool valid() const noexcept { return m_id != Invalid; }
+
+        friend constexpr bool operator==(Handle lhs, Handle rhs) noexcept { return lhs.m_id == rhs.m_id; }
+        friend constexpr bool operator!=(Handle lhs, Handle rhs) noexcept { return lhs.m_id != rhs.m_id; }
+    };
+
+    // combines the hash values of the parts of an intrinsic state (boost::hash_combine)
+    inline std::size_t hashCombine(std::size_t seed, std::size_t value) noexcept
+    {
+        return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+    }
+
+    inline std::size_t hashStrings(std::initializer_list<std::string_view> parts) noexcept
+    {
+        std::size_t seed{};
+        for (std::string_view part : parts) {
+            seed = hashCombine(seed, std::hash<std::string_view>{}(part));
+        }
+        return seed;
+    }
+
+    /**
+     * Pool of immutable flyweights, keyed by a precomputed hash of their intrinsic state.
+     *
+     * TTraits describes the intrinsic state, for every query type TQuery accepted by acquire:
+     *
+     *     static std::size_t hash(const TQuery&);                 // hash of the intrinsic state
+     *     static bool equal(const TValue&, const TQuery&);        // does the flyweight match?
+     *     static TValue make(const TQuery&);                      // creates a new flyweight
+     *
+     * A query is typically a view (e.g. a struct of std::string_views), so a lookup never
+     * builds a temporary key. The same hash must be produced for a stored value and for a
+     * matching query.
+     *
+     * The pool is split into 2^ShardBits shards, each guarded by its own reader/writer lock
+     * (lock striping). Flyweights are never moved once created: every shard stores them in
+     * chunks of geometrically growing size, so resolving a handle needs no lock at all.
+     */
+    template <typename TValue, typename TTraits, std::size_t ShardBits = 4>
+    class ShardedFlyweightPool
+    {
+    private:
+        static constexpr std::size_t ShardCount = std::size_t{ 1 } << ShardBits;
+        static constexpr std::size_t IndexBits = 32 - ShardBits;
+        static constexpr std::uint32_t IndexMask = (std::uint32_t{ 1 } << IndexBits) - 1;
+        static constexpr std::size_t FirstChunkBits = 6;        // first chunk holds 64 flyweights
+        static constexpr std::size_t ChunkCount = IndexBits - FirstChunkBits + 1;
+
+        struct Entry
+        {
+            TValue        m_value;
+            std::size_t   m_hash;
+            std::uint32_t m_next;       // next slot with the same hash (collision chain)
+        };
+
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex m_mutex;
+            std::unordered_map<std::size_t, std::uint32_t> m_index;     // hash => first slot
+            std::array<std::atomic<Entry*>, ChunkCount> m_chunks{};
+            std::uint32_t m_size{};
+        };
+
+        std::unique_ptr<Shard[]> m_shards;
+
+    public:
+        ShardedFlyweightPool() : m_shards{ std::make_unique<Shard[]>(ShardCount) } {}
+
+        ~ShardedFlyweightPool()
+        {
+            for (std::size_t shard{}; shard != ShardCount; ++shard) {
+
+                Shard& s{ m_shards[shard] };
+                for (std::uint32_t slot{}; slot != s.m_size; ++slot) {
+                    entryAt(s, slot).~Entry();
+                }
+
+                for (std::size_t chunk{}; chunk != ChunkCount; ++chunk) {
+                    ::operator delete(s.m_chunks[chunk].load(std::memory_order_relaxed));
+                }
+            }
+        }
+
+        ShardedFlyweightPool(const ShardedFlyweightPool&) = delete;
+        ShardedFlyweightPool& operator=(const ShardedFlyweightPool&) = delete;
+
+        // returns the handle of an existing flyweight or creates a new one
+        template <typename TQuery>
+        Handle acquire(const TQuery& query)
+        {
+            bool inserted{};
+            return acquire(query, TTraits::hash(query), inserted);
+        }
+
+        template <typename TQuery>
+        Handle acquire(const TQuery& query, bool& inserted)
+        {
+            return acquire(query, TTraits::hash(query), inserted);
+        }
+
+        // overload for callers who computed the hash of the intrinsic state already
+        template <typename TQuery>
+        Handle acquire(const TQuery& query, std::size_t hash, bool& inserted)
+        {
+            const std::uint32_t shard{ shardOf(hash) };
+            Shard& s{ m_shards[shard] };
+
+            inserted = false;
+
+            {
+                std::shared_lock<std::shared_mutex> guard{ s.m_mutex };
+                std::uint32_t slot{ findSlot(s, query, hash) };
+                if (slot != Handle::Invalid) {
+                    return makeHandle(shard, slot);
+                }
+            }
+
+            std::unique_lock<std::shared_mutex> guard{ s.m_mutex };
+
+            // another thread may have created the flyweight in the meantime
+            std::uint32_t slot{ findSlot(s, query, hash) };
+            if (slot != Handle::Invalid) {
+                return makeHandle(shard, slot);
+            }
+
+            slot = s.m_size;
+            if (slot > IndexMask) {
+                throw std::length_error("ShardedFlyweightPool: shard is full");
+            }
+
+            Entry* entry{ allocateSlot(s, slot) };
+            ::new (static_cast<void*>(entry)) Entry{ TTraits::make(query), hash, Handle::Invalid };
+
+            try {
+                auto [pos, first] { s.m_index.try_emplace(hash, slot) };
+                if (!first) {
+                    entry->m_next = pos->second;        // prepend to collision chain
+                    pos->second = slot;
+                }
+            }
+            catch (...) {
+                entry->~Entry();
+                throw;
+            }
+
+            ++s.m_size;
+            inserted = true;
+            return makeHandle(shard, slot);
+        }
+
+        // looks up a flyweight without creating it
+        template <typename TQuery>
+        Handle find(const TQuery& query) const
+        {
+            const std::size_t hash{ TTraits::hash(query) };
+            const std::uint32_t shard{ shardOf(hash) };
+            const Shard& s{ m_shards[shard] };
+
+            std::shared_lock<std::shared_mutex> guard{ s.m_mutex };
+            std::uint32_t slot{ findSlot(s, query, hash) };
+            return slot == Handle::Invalid ? Handle{} : makeHandle(shard, slot);
+        }
+
+        // resolves a handle, lock-free: flyweights never move once created
+        const TValue& get(Handle handle) const noexcept
+        {
+            const Shard& s{ m_shards[handle.id() >> IndexBits] };
+            return entryAt(s, handle.id() & IndexMask).m_value;
+        }
+
+        const TValue& operator[](Handle handle) const noexcept { return get(handle); }
+
+        std::size_t size() const
+        {
+            std::size_t count{};
+            for (std::size_t shard{}; shard != ShardCount; ++shard) {
+                std::shared_lock<std::shared_mutex> guard{ m_shards[shard].m_mutex };
+                count += m_shards[shard].m_size;
+            }
+            return count;
+        }
+
+        template <typename TVisitor>
+        void forEach(TVisitor&& visitor) const
+        {
+            for (std::size_t shard{}; shard != ShardCount; ++shard) {
+
+                const Shard& s{ m_shards[shard] };
+                std::shared_lock<std::shared_mutex> guard{ s.m_mutex };
+                for (std::uint32_t slot{}; slot != s.m_size; ++slot) {
+                    visitor(makeHandle(static_cast<std::uint32_t>(shard), slot), entryAt(s, slot).m_value);
+                }
+            }
+        }
+
+    private:
+        static std::uint32_t shardOf(std::size_t hash) noexcept
+        {
+            // upper bits of the hash select the shard, lower bits feed the index
+            return static_cast<std::uint32_t>((hash >> (sizeof(std::size_t) * 8 - ShardBits)) & (ShardCount - 1));
+        }
+
+        static Handle makeHandle(std::uint32_t shard, std::uint32_t slot) noexcept
+        {
+            return Handle{ (shard << IndexBits) | slot };
+        }
+
+        // chunk k holds 2^(FirstChunkBits + k) slots
+        static std::size_t chunkOf(std::uint32_t slot, std::size_t& offset) noexcept
+        {
+            std::size_t biased{ static_cast<std::size_t>(slot) + (std::size_t{ 1 } << FirstChunkBits) };
+            std::size_t bits{};
+            while ((biased >> (bits + 1)) != 0) {
+                ++bits;
+            }
+            offset = biased - (std::size_t{ 1 } << bits);
+            return bits - FirstChunkBits;
+        }
+
+        static Entry& entryAt(const Shard& s, std::uint32_t slot) noexcept
+        {
+            std::size_t offset{};
+            std::size_t chunk{ chunkOf(slot, offset) };
+            return s.m_chunks[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        static Entry* allocateSlot(Shard& s, std::uint32_t slot)
+        {
+            std::size_t offset{};
+            std::size_t chunk{ chunkOf(slot, offset) };
+
+            Entry* entries{ s.m_chunks[chunk].load(std::memory_order_relaxed) };
+            if (entries == nullptr) {
+                std::size_t length{ std::size_t{ 1 } << (FirstChunkBits + chunk) };
+                entries = static_cast<Entry*>(::operator new(length * sizeof(Entry)));
+                s.m_chunks[chunk].store(entries, std::memory_order_release);
+            }
+
+            return entries + offset;
+        }
+
+        template <typename TQuery>
+        static std::uint32_t findSlot(const Shard& s, const TQuery& query, std::size_t hash)
+        {
+            auto pos{ s.m_index.find(hash) };
+            if (pos == s.m_index.end()) {
+                return Handle::Invalid;
+            }
+
+            for (std::uint32_t slot{ pos->second }; slot != Handle::Invalid; ) {
+                const Entry& entry{ entryAt(s, slot) };
+                if (TTraits::equal(entry.m_value, query)) {
+                    return slot;
+                }
+                slot = entry.m_next;
+            }
+
+            return Handle::Invalid;
+        }
+    };
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -2,20 +2,23 @@
 // PaintBrush.cpp // Flyweight Pattern
 // ===========================================================================
 
+#include "FlyweightPool.h"
+
 #include <iostream>
-#include <unordered_map>
 #include <memory>
+#include <string>
+#include <string_view>
 
 namespace PaintBrushFlyweight {
 
     class Pen
     {
     public:
-        ~Pen() {}
+        virtual ~Pen() {}
 
         virtual void setColor(const std::string& color) = 0;
-        virtual void draw(const std::string& content) = 0;
-        virtual void print() = 0;
+        virtual void draw(const std::string& content) const = 0;
+        virtual void print() const = 0;
     };
 
     enum class BrushSize { Thin, Medium, Thick };
@@ -33,13 +36,13 @@ namespace PaintBrushFlyweight {
             m_color = color;
         }
 
-        void draw(const std::string& content) override {
+        void draw(const std::string& content) const override {
             std::cout 
                 << "Drawing THICK content in color : " << m_color 
                 << " - " << content << std::endl;
         }
 
-        void print() override {
+        void print() const override {
             std::cout << this << std::endl;
         }
     };
@@ -57,80 +60,110 @@ namespace PaintBrushFlyweight {
             m_color = color;
         }
 
-        void draw(const std::string& content) override {
+        void draw(const std::string& content) const override {
             std::cout 
                 << "Drawing THIN content in color : " << m_color 
                 << " - " << content << std::endl;
         }
 
-        void print() override {
+        void print() const override {
             std::cout << this << std::endl;
         }
     };
 
-    class PenFactory
+    // flyweight entry of the pen pool: the key (color and size) and the shared pen
+    struct PenEntry
     {
-    private:
-        static std::unordered_map<std::string, std::shared_ptr<Pen>> pensMap;
+        std::string          m_color;
+        BrushSize            m_size;
+        std::unique_ptr<Pen> m_pen;
+    };
 
-    public:
-        static std::shared_ptr<Pen> getThickPen(const std::string& color)
-        {
-            std::string key{ color + "-THICK" };
+    struct PenKey
+    {
+        std::string_view m_color;
+        BrushSize        m_size;
+    };
 
-            std::shared_ptr<Pen> pen{ pensMap[key] };
+    struct PenTraits
+    {
+        static std::size_t hash(const PenKey& key) noexcept {
+            return FlyweightPool::hashCombine(
+                std::hash<std::string_view>{}(key.m_color),
+                static_cast<std::size_t>(key.m_size)
+            );
+        }
+
+        static bool equal(const PenEntry& entry, const PenKey& key) noexcept {
+            return entry.m_size == key.m_size && entry.m_color == key.m_color;
+        }
 
-            if (pen != nullptr) {
-                return pen;
+        static PenEntry make(const PenKey& key) {
+
+            std::unique_ptr<Pen> pen{};
+            if (key.m_size == BrushSize::Thick) {
+                pen = std::make_unique<ThickPen>();
             }
             else {
-                pen = std::make_shared<ThickPen>();
-                pen->setColor(color);
-                pensMap[key] = pen;
+                pen = std::make_unique<ThinPen>();
             }
 
-            return pen;
+            pen->setColor(std::string{ key.m_color });
+            return PenEntry{ std::string{ key.m_color }, key.m_size, std::move(pen) };
         }
+    };
 
-        static std::shared_ptr<Pen> getThinPen(const std::string& color)
-        {
-            std::string key{ color + "-THIN" };
+    using PenHandle = FlyweightPool::Handle;
+
+    class PenFactory
+    {
+    private:
+        using PenPool = FlyweightPool::ShardedFlyweightPool<PenEntry, PenTraits, 2>;
 
-            std::shared_ptr<Pen> pen{ pensMap[key] };
+        static PenPool& pens() {
+            static PenPool pool{};
+            return pool;
+        }
 
-            if (pen != nullptr) {
-                return pen;
-            }
-            else {
-                pen = std::make_shared<ThickPen>();
-                pen->setColor(color);
-                pensMap[key] = pen;
-            }
+    public:
+        static PenHandle getThickPen(std::string_view color)
+        {
+            return pens().acquire(PenKey{ color, BrushSize::Thick });
+        }
 
-            return pen;
+        static PenHandle getThinPen(std::string_view color)
+        {
+            return pens().acquire(PenKey{ color, BrushSize::Thin });
         }
-    };
 
-    // out-of-class definition of static class member
-    std::unordered_map<std::string, std::shared_ptr<Pen>> PenFactory::pensMap;
+        // pooled pens are shared between threads, hence immutable
+        static const Pen& getPen(PenHandle handle)
+        {
+            return *pens().get(handle).m_pen;
+        }
+    };
 }
 
 void test_paint_brush()
 {
     using namespace PaintBrushFlyweight;
 
-    std::shared_ptr<Pen> yellowThinPen1{ PenFactory::getThickPen("YELLOW") };  // creating new pen
-    yellowThinPen1->draw("Hello World !!");
+    PenHandle yellowThickPen1{ PenFactory::getThickPen("YELLOW") };  // creating new pen
+    PenFactory::getPen(yellowThickPen1).draw("Hello World !!");
+
+    PenHandle yellowThickPen2{ PenFactory::getThickPen("YELLOW") };  // pen is shared
+    PenFactory::getPen(yellowThickPen2).draw("Hello World !!");
 
-    std::shared_ptr<Pen> yellowThinPen2{ PenFactory::getThickPen("YELLOW") };  // pen is shared
-    yellowThinPen2->draw("Hello World !!");
+    PenHandle blueThickPen{ PenFactory::getThickPen("BLUE") };       // creating new pen
+    PenFactory::getPen(blueThickPen).draw("Hello World !!");
 
-    std::shared_ptr<Pen> blueThinPen{ PenFactory::getThickPen("BLUE") };       // creating new pen
-    blueThinPen->draw("Hello World !!");
+    PenHandle blueThinPen{ PenFactory::getThinPen("BLUE") };         // creating new pen
+    PenFactory::getPen(blueThinPen).draw("Hello World !!");
 
-    yellowThinPen1->print();
-    yellowThinPen2->print();
-    blueThinPen->print();
+    PenFactory::getPen(yellowThickPen1).print();
+    PenFactory::getPen(yellowThickPen2).print();
+    PenFactory::getPen(blueThickPen).print();
+    PenFactory::getPen(blueThinPen).print();
 }
 
 // ===========================================================================
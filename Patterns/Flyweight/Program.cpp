@@ -5,7 +5,11 @@
 // function prototypes
 extern void test_conceptual_example_01();
 extern void test_conceptual_example_02();
+extern void benchmark_conceptual_example_02();
+extern void benchmark_trees_game_data_oriented();
 extern void test_trees_game();
+extern void test_trees_game_data_oriented();
+extern void test_trees_factory_cache();
 extern void test_paint_brush();
 
 int main()
@@ -13,7 +17,11 @@ int main()
     test_conceptual_example_01();
     test_conceptual_example_02();
     test_trees_game();
+    test_trees_game_data_oriented();
+    test_trees_factory_cache();
     test_paint_brush();
+    benchmark_conceptual_example_02();
+    benchmark_trees_game_data_oriented();
     return 0;
 }
 
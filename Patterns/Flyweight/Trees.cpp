@@ -4,7 +4,15 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <memory>
@@ -44,50 +52,357 @@ namespace TreesFlyweight {
         void setY(int y) { m_y = y; }
     };
 
+    /**
+     * Configuration of a FlyweightCache
+     */
+    struct CacheOptions
+    {
+        std::size_t m_capacity{};               // 0: unbounded, otherwise LRU eviction above this size
+        std::size_t m_sweepInterval{ 64 };      // sweep expired entries every n misses, 0: never
+    };
+
+    struct CacheStatistics
+    {
+        std::size_t m_hits{};
+        std::size_t m_misses{};
+        std::size_t m_expiredEvictions{};       // entries dropped because their flyweight died: memory reclaimed
+        std::size_t m_liveEvictions{};          // live entries dropped by the LRU policy: nothing reclaimed
+        std::size_t m_size{};
+
+        CacheStatistics& operator+=(const CacheStatistics& other) noexcept
+        {
+            m_hits += other.m_hits;
+            m_misses += other.m_misses;
+            m_expiredEvictions += other.m_expiredEvictions;
+            m_liveEvictions += other.m_liveEvictions;
+            m_size += other.m_size;
+            return *this;
+        }
+    };
+
+    /**
+     * Cache of flyweights keyed by a string.
+     *
+     * The cache holds weak references only: a flyweight lives as long as clients use it.
+     * Entries of dead flyweights are removed by a periodic sweep, an optional capacity
+     * bound evicts entries of dead flyweights first, then the least recently used live
+     * ones. Evicting a live entry doesn't free the flyweight, a later request for the same
+     * key creates a second instance. Pinned entries hold a strong reference and are
+     * never evicted.
+     */
+    template <typename TValue>
+    class FlyweightCache
+    {
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view sv) const noexcept {
+                return std::hash<std::string_view>{}(sv);
+            }
+        };
+
+        using LruList = std::list<const std::string*>;      // most recently used first
+
+        struct Entry
+        {
+            std::weak_ptr<TValue>   m_value;
+            std::shared_ptr<TValue> m_pinned;
+            LruList::iterator       m_lru;
+        };
+
+        std::unordered_map<std::string, Entry, StringHash, std::equal_to<>> m_entries;
+        LruList         m_lru;
+        CacheOptions    m_options;
+        CacheStatistics m_statistics;
+        std::size_t     m_missesSinceSweep;
+
+    public:
+        explicit FlyweightCache(CacheOptions options = {})
+            : m_options{ options }, m_statistics{}, m_missesSinceSweep{}
+        {}
+
+        // the LRU list refers to the keys of m_entries: moving keeps them valid, copying doesn't
+        FlyweightCache(const FlyweightCache&) = delete;
+        FlyweightCache& operator=(const FlyweightCache&) = delete;
+        FlyweightCache(FlyweightCache&&) = default;
+        FlyweightCache& operator=(FlyweightCache&&) = default;
+
+        // returns the cached flyweight or creates a new one with make()
+        template <typename TFactory>
+        std::shared_ptr<TValue> getOrCreate(std::string_view key, TFactory&& make)
+        {
+            if (auto pos{ m_entries.find(key) }; pos != m_entries.end()) {
+
+                Entry& entry{ pos->second };
+                touch(entry);
+
+                if (std::shared_ptr<TValue> value{ entry.m_value.lock() }; value != nullptr) {
+                    ++m_statistics.m_hits;
+                    return value;
+                }
+
+                // the flyweight died in the meantime: recreate it in place
+                ++m_statistics.m_misses;
+                ++m_statistics.m_expiredEvictions;
+
+                std::shared_ptr<TValue> value{ make() };
+                entry.m_value = value;
+                return value;
+            }
+
+            ++m_statistics.m_misses;
+
+            if (m_options.m_sweepInterval != 0 && ++m_missesSinceSweep >= m_options.m_sweepInterval) {
+                sweep();
+            }
+
+            std::shared_ptr<TValue> value{ make() };
+
+            auto [pos, inserted] { m_entries.try_emplace(std::string{ key }) };
+            m_lru.push_front(&pos->first);
+            pos->second.m_value = value;
+            pos->second.m_lru = m_lru.begin();
+
+            if (m_options.m_capacity != 0 && m_entries.size() > m_options.m_capacity) {
+                evictLeastRecentlyUsed();
+            }
+
+            return value;
+        }
+
+        // keeps a flyweight alive and in the cache until unpin is called
+        template <typename TFactory>
+        std::shared_ptr<TValue> pin(std::string_view key, TFactory&& make)
+        {
+            std::shared_ptr<TValue> value{ getOrCreate(key, std::forward<TFactory>(make)) };
+            m_entries.find(key)->second.m_pinned = value;
+            return value;
+        }
+
+        bool unpin(std::string_view key)
+        {
+            auto pos{ m_entries.find(key) };
+            if (pos == m_entries.end() || pos->second.m_pinned == nullptr) {
+                return false;
+            }
+
+            pos->second.m_pinned.reset();
+            return true;
+        }
+
+        // removes all entries whose flyweight has died, returns the number of removed entries
+        std::size_t sweep()
+        {
+            m_missesSinceSweep = 0;
+
+            std::size_t count{};
+            for (auto pos{ m_entries.begin() }; pos != m_entries.end(); ) {
+                if (pos->second.m_value.expired()) {
+                    m_lru.erase(pos->second.m_lru);
+                    pos = m_entries.erase(pos);
+                    ++count;
+                }
+                else {
+                    ++pos;
+                }
+            }
+
+            m_statistics.m_expiredEvictions += count;
+            return count;
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_lru.clear();
+        }
+
+        std::size_t size() const noexcept { return m_entries.size(); }
+
+        CacheStatistics statistics() const noexcept
+        {
+            CacheStatistics statistics{ m_statistics };
+            statistics.m_size = m_entries.size();
+            return statistics;
+        }
+
+    private:
+        void touch(Entry& entry)
+        {
+            m_lru.splice(m_lru.begin(), m_lru, entry.m_lru);
+        }
+
+        // O(capacity): walks the LRU list from the least recently used end
+        void evictLeastRecentlyUsed()
+        {
+            // entries of dead flyweights first: evicting them reclaims memory
+            auto lru{ m_lru.end() };
+            while (m_entries.size() > m_options.m_capacity && lru != m_lru.begin()) {
+
+                --lru;
+                auto pos{ m_entries.find(**lru) };
+                if (pos->second.m_value.expired()) {
+                    ++m_statistics.m_expiredEvictions;
+                    lru = m_lru.erase(lru);
+                    m_entries.erase(pos);
+                }
+            }
+
+            // still above the capacity: drop live entries, never the entry just added
+            lru = m_lru.end();
+            while (m_entries.size() > m_options.m_capacity && lru != std::next(m_lru.begin())) {
+
+                --lru;
+                auto pos{ m_entries.find(**lru) };
+                if (pos->second.m_pinned != nullptr) {
+                    continue;
+                }
+
+                ++m_statistics.m_liveEvictions;
+                lru = m_lru.erase(lru);
+                m_entries.erase(pos);
+            }
+        }
+    };
+
+    /**
+     * Thread-safe FlyweightCache: keys are distributed over independently locked shards,
+     * each shard bounded by its share of the total capacity.
+     */
+    template <typename TValue, std::size_t Shards = 8>
+    class ConcurrentFlyweightCache
+    {
+    private:
+        struct alignas(64) Shard
+        {
+            mutable std::mutex m_mutex;
+            FlyweightCache<TValue> m_cache;
+        };
+
+        std::array<Shard, Shards> m_shards;
+
+    public:
+        explicit ConcurrentFlyweightCache(CacheOptions options = {})
+        {
+            CacheOptions shardOptions{ options };
+            shardOptions.m_capacity = (options.m_capacity + Shards - 1) / Shards;
+
+            for (Shard& shard : m_shards) {
+                shard.m_cache = FlyweightCache<TValue>{ shardOptions };
+            }
+        }
+
+        template <typename TFactory>
+        std::shared_ptr<TValue> getOrCreate(std::string_view key, TFactory&& make)
+        {
+            Shard& shard{ shardOf(key) };
+            std::lock_guard<std::mutex> guard{ shard.m_mutex };
+            return shard.m_cache.getOrCreate(key, std::forward<TFactory>(make));
+        }
+
+        template <typename TFactory>
+        std::shared_ptr<TValue> pin(std::string_view key, TFactory&& make)
+        {
+            Shard& shard{ shardOf(key) };
+            std::lock_guard<std::mutex> guard{ shard.m_mutex };
+            return shard.m_cache.pin(key, std::forward<TFactory>(make));
+        }
+
+        bool unpin(std::string_view key)
+        {
+            Shard& shard{ shardOf(key) };
+            std::lock_guard<std::mutex> guard{ shard.m_mutex };
+            return shard.m_cache.unpin(key);
+        }
+
+        std::size_t sweep()
+        {
+            std::size_t count{};
+            for (Shard& shard : m_shards) {
+                std::lock_guard<std::mutex> guard{ shard.m_mutex };
+                count += shard.m_cache.sweep();
+            }
+            return count;
+        }
+
+        CacheStatistics statistics() const
+        {
+            CacheStatistics statistics{};
+            for (const Shard& shard : m_shards) {
+                std::lock_guard<std::mutex> guard{ shard.m_mutex };
+                statistics += shard.m_cache.statistics();
+            }
+            return statistics;
+        }
+
+    private:
+        // upper bits of the hash select the shard: the unordered_map of a shard uses the
+        // lower bits for its buckets, with 'hash % Shards' each shard would fill only some of them
+        Shard& shardOf(std::string_view key)
+        {
+            constexpr int HalfBits{ std::numeric_limits<std::size_t>::digits / 2 };
+            const std::size_t high{ std::hash<std::string_view>{}(key) >> HalfBits };
+            return m_shards[(high * Shards) >> HalfBits];
+        }
+    };
+
     class TreeFactory
     {
     private:
-        std::unordered_map<std::string, std::weak_ptr<Tree>> m_treeMap;
+        FlyweightCache<Tree> m_treeCache;
 
     public:
-        TreeFactory() {};
+        explicit TreeFactory(CacheOptions options = {}) : m_treeCache{ options } {};
 
-        std::shared_ptr<Tree> getTree(const std::string style)
+        std::shared_ptr<Tree> getTree(std::string_view style)
         {
             // palm, cypress, garden
-            if (!(style.compare("palm") == 0 || style.compare("cypress") == 0 || style.compare("garden") == 0))
+            if (!(style == "palm" || style == "cypress" || style == "garden"))
             {
                 return nullptr;
             }
 
-            if (m_treeMap.find(style) != m_treeMap.end())
-            {
-                std::cout << "     --> Tree with style " << style << " already in Factory Cache!" << std::endl;
+            bool created{};
 
-                std::shared_ptr<Tree> tp = m_treeMap[style].lock();
+            std::shared_ptr<Tree> tree{ 
+                m_treeCache.getOrCreate(style, [&]() {
+                    created = true;
+                    return std::make_shared<Tree>(std::string{ style });
+                })
+            };
 
-                return tp;
+            if (created) {
+                std::cout << "     ==> Creating new tree with style " << style << std::endl;
+            }
+            else {
+                std::cout << "     --> Tree with style " << style << " already in Factory Cache!" << std::endl;
             }
 
-            std::cout << "     ==> Creating new tree with style " << style << std::endl;
-
-            std::shared_ptr<Tree> tree{ std::make_shared<Tree>(style) };
-
-            m_treeMap[style] = tree;
-            
             return tree;
         }
+
+        std::shared_ptr<Tree> pinTree(std::string_view style)
+        {
+            return m_treeCache.pin(style, [&]() { return std::make_shared<Tree>(std::string{ style }); });
+        }
+
+        bool unpinTree(std::string_view style) { return m_treeCache.unpin(style); }
+
+        CacheStatistics statistics() const noexcept { return m_treeCache.statistics(); }
     };
 
     class Game
     {
     private:
         TreeFactory m_treeFactory;
+        std::vector<std::shared_ptr<Tree>> m_trees;     // keeps the shared trees alive
 
     public:
         Game() {};
 
-        void addTree(int x, int y, const std::string style)
+        void addTree(int x, int y, std::string_view style)
         {
             std::shared_ptr<Tree> tree{ m_treeFactory.getTree(style) };
 
@@ -99,6 +414,8 @@ namespace TreesFlyweight {
                 std::make_shared<TreePosition>(x, y) 
             };
 
+            m_trees.push_back(tree);
+
             renderTree(tree, position);
         }
 
@@ -130,6 +447,63 @@ void test_trees_game()
     game.addTree(5, 3, "garden");
 }
 
+static void printStatistics(const TreesFlyweight::CacheStatistics& statistics)
+{
+    std::cout
+        << "Hits: " << statistics.m_hits
+        << ", Misses: " << statistics.m_misses
+        << ", Expired Evictions: " << statistics.m_expiredEvictions
+        << ", Live Evictions: " << statistics.m_liveEvictions
+        << ", Size: " << statistics.m_size << std::endl;
+}
+
+void test_trees_factory_cache()
+{
+    using namespace TreesFlyweight;
+
+    // LRU with capacity bound: keep at most 2 styles, pin "palm"
+    FlyweightCache<Tree> cache{ CacheOptions{ 2, 0 } };
+
+    auto make = [](std::string_view style) {
+        return [=]() { return std::make_shared<Tree>(std::string{ style }); };
+    };
+
+    std::shared_ptr<Tree> palm{ cache.pin("palm", make("palm")) };
+    std::shared_ptr<Tree> cypress{ cache.getOrCreate("cypress", make("cypress")) };
+    std::shared_ptr<Tree> garden{ cache.getOrCreate("garden", make("garden")) };    // evicts "cypress"
+    std::shared_ptr<Tree> palm2{ cache.getOrCreate("palm", make("palm")) };         // hit, pinned
+    printStatistics(cache.statistics());
+
+    // expired entries: flyweights die when their last client releases them
+    garden.reset();
+    cypress.reset();
+    std::shared_ptr<Tree> garden2{ cache.getOrCreate("garden", make("garden")) };   // expired, recreated
+    std::cout << "Swept: " << cache.sweep() << std::endl;
+    printStatistics(cache.statistics());
+
+    // concurrent variant: a churning set of styles from several threads
+    ConcurrentFlyweightCache<Tree> concurrentCache{ CacheOptions{ 64, 32 } };
+
+    std::vector<std::thread> threads;
+    for (int t{}; t != 4; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<std::shared_ptr<Tree>> alive;
+            for (int i{}; i != 10'000; ++i) {
+                std::string style{ "style_" + std::to_string((i * 31 + t) % 200) };
+                alive.push_back(concurrentCache.getOrCreate(style, make(style)));
+                if (alive.size() > 16) {
+                    alive.erase(alive.begin());
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    printStatistics(concurrentCache.statistics());
+}
 
 // ===========================================================================
 // End-of-File
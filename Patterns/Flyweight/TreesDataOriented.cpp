@@ -0,0 +1,371 @@
+// ===========================================================================
+// TreesDataOriented.cpp // Flyweight Pattern
+// ===========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace TreesFlyweightDataOriented {
+
+    /**
+     * Intrinsic state of a tree, shared by all trees of the same style
+     */
+    struct TreeType
+    {
+        std::string m_style;
+        int         m_height;
+    };
+
+    using TreeTypeId = std::uint16_t;
+
+    /**
+     * Small deduplicated table of intrinsic states.
+     * A style is stored once, trees refer to it by a 16-bit id.
+     */
+    class TreeTypeTable
+    {
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view sv) const noexcept {
+                return std::hash<std::string_view>{}(sv);
+            }
+        };
+
+        std::vector<TreeType> m_types;
+        std::unordered_map<std::string, TreeTypeId, StringHash, std::equal_to<>> m_ids;
+
+    public:
+        // returns the id of an existing tree type or registers a new one
+        TreeTypeId intern(std::string_view style, int height = 6)
+        {
+            if (auto pos{ m_ids.find(style) }; pos != m_ids.end()) {
+                return pos->second;
+            }
+
+            if (m_types.size() > std::numeric_limits<TreeTypeId>::max()) {
+                throw std::length_error("TreeTypeTable: too many tree types");
+            }
+
+            TreeTypeId id{ static_cast<TreeTypeId>(m_types.size()) };
+            m_types.push_back(TreeType{ std::string{ style }, height });
+            m_ids.emplace(std::string{ style }, id);
+            return id;
+        }
+
+        const TreeType& operator[](TreeTypeId id) const noexcept { return m_types[id]; }
+
+        std::size_t size() const noexcept { return m_types.size(); }
+
+        std::size_t footprint() const noexcept
+        {
+            std::size_t bytes{ m_types.capacity() * sizeof(TreeType) };
+            for (const TreeType& type : m_types) {
+                bytes += 2 * type.m_style.capacity();           // table entry and map key
+            }
+            return bytes + m_ids.size() * (sizeof(std::string) + sizeof(TreeTypeId) + 2 * sizeof(void*));
+        }
+    };
+
+    /**
+     * A contiguous slice of the forest, handed to batch operations.
+     * All spans have the same length.
+     */
+    struct TreeBatch
+    {
+        std::span<const std::int32_t> m_x;
+        std::span<const std::int32_t> m_y;
+        std::span<const TreeTypeId>   m_type;
+
+        std::size_t size() const noexcept { return m_type.size(); }
+    };
+
+    /**
+     * Data-oriented flyweight container: the extrinsic state of each tree lives in
+     * struct-of-arrays columns (x, y, tree type id), the intrinsic state in a
+     * TreeTypeTable. A tree costs 10 bytes, independent of its style.
+     */
+    class Forest
+    {
+    private:
+        std::vector<std::int32_t> m_x;
+        std::vector<std::int32_t> m_y;
+        std::vector<TreeTypeId>   m_type;
+        TreeTypeTable             m_types;
+
+    public:
+        Forest() = default;
+
+        void reserve(std::size_t count)
+        {
+            m_x.reserve(count);
+            m_y.reserve(count);
+            m_type.reserve(count);
+        }
+
+        TreeTypeId addType(std::string_view style, int height = 6)
+        {
+            return m_types.intern(style, height);
+        }
+
+        // returns the index of the new tree
+        std::size_t addTree(int x, int y, TreeTypeId type)
+        {
+            m_x.push_back(x);
+            m_y.push_back(y);
+            m_type.push_back(type);
+            return m_type.size() - 1;
+        }
+
+        std::size_t addTree(int x, int y, std::string_view style)
+        {
+            return addTree(x, y, m_types.intern(style));
+        }
+
+        std::size_t size() const noexcept { return m_type.size(); }
+
+        const TreeTypeTable& types() const noexcept { return m_types; }
+
+        // invokes visitor(x, y, treeType) for every tree
+        template <typename TVisitor>
+        void forEach(TVisitor&& visitor) const
+        {
+            const std::size_t count{ m_type.size() };
+            for (std::size_t i{}; i != count; ++i) {
+                visitor(m_x[i], m_y[i], m_types[m_type[i]]);
+            }
+        }
+
+        // invokes visitor(const TreeBatch&) for consecutive slices of at most batchSize trees
+        template <typename TVisitor>
+        void forEachBatch(TVisitor&& visitor, std::size_t batchSize = 4096) const
+        {
+            const std::size_t count{ m_type.size() };
+            for (std::size_t first{}; first < count; first += batchSize) {
+
+                const std::size_t length{ std::min(batchSize, count - first) };
+
+                TreeBatch batch{
+                    std::span<const std::int32_t>{ m_x.data() + first, length },
+                    std::span<const std::int32_t>{ m_y.data() + first, length },
+                    std::span<const TreeTypeId>{ m_type.data() + first, length }
+                };
+
+                visitor(batch);
+            }
+        }
+
+        // renders the trees batch by batch, one write to the stream per batch
+        void render(std::ostream& os, std::size_t batchSize = 4096) const
+        {
+            std::string buffer;
+
+            forEachBatch([&](const TreeBatch& batch) {
+
+                buffer.clear();
+                for (std::size_t i{}; i != batch.size(); ++i) {
+                    buffer += "Tree with ";
+                    buffer += m_types[batch.m_type[i]].m_style;
+                    buffer += " style rendered at ";
+                    buffer += std::to_string(batch.m_x[i]);
+                    buffer += ", ";
+                    buffer += std::to_string(batch.m_y[i]);
+                    buffer += '\n';
+                }
+
+                os << buffer;
+            }, batchSize);
+        }
+
+        std::size_t footprint() const noexcept
+        {
+            return m_x.capacity() * sizeof(std::int32_t)
+                + m_y.capacity() * sizeof(std::int32_t)
+                + m_type.capacity() * sizeof(TreeTypeId)
+                + m_types.footprint();
+        }
+    };
+}
+
+namespace TreesFlyweightDataOriented {
+
+    // ---------------------------------------------------------------------------
+    // benchmark: object-per-tree design (shared_ptr<Tree> + shared_ptr<TreePosition>)
+
+    // allocator counting the bytes requested from the heap
+    template <typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        std::size_t* m_bytes;
+
+        explicit CountingAllocator(std::size_t* bytes) noexcept : m_bytes{ bytes } {}
+
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U>& other) noexcept : m_bytes{ other.m_bytes } {}
+
+        T* allocate(std::size_t n)
+        {
+            *m_bytes += n * sizeof(T);
+            return std::allocator<T>{}.allocate(n);
+        }
+
+        void deallocate(T* p, std::size_t n) noexcept
+        {
+            *m_bytes -= n * sizeof(T);
+            std::allocator<T>{}.deallocate(p, n);
+        }
+
+        template <typename U>
+        bool operator==(const CountingAllocator<U>& other) const noexcept { return m_bytes == other.m_bytes; }
+    };
+
+    struct ObjectTree
+    {
+        std::string m_style;
+        int         m_height;
+    };
+
+    struct ObjectTreePosition
+    {
+        int m_x;
+        int m_y;
+    };
+
+    struct ObjectTreeInstance
+    {
+        std::shared_ptr<ObjectTree>         m_tree;
+        std::shared_ptr<ObjectTreePosition> m_position;
+    };
+
+    static constexpr std::string_view Styles[]{ "palm", "cypress", "garden", "oak", "birch", "pine" };
+
+    static void benchmark()
+    {
+        constexpr std::size_t Count{ 5'000'000 };
+        constexpr std::size_t StyleCount{ std::size(Styles) };
+
+        // object-per-tree design
+        std::size_t objectBytes{};
+        CountingAllocator<ObjectTreeInstance> allocator{ &objectBytes };
+
+        auto start{ std::chrono::high_resolution_clock::now() };
+
+        std::vector<std::shared_ptr<ObjectTree>> trees;
+        for (std::string_view style : Styles) {
+            trees.push_back(std::allocate_shared<ObjectTree>(allocator, ObjectTree{ std::string{ style }, 6 }));
+        }
+
+        std::vector<ObjectTreeInstance, CountingAllocator<ObjectTreeInstance>> objects{ allocator };
+        objects.reserve(Count);
+        for (std::size_t i{}; i != Count; ++i) {
+            objects.push_back(ObjectTreeInstance{
+                trees[i % StyleCount],
+                std::allocate_shared<ObjectTreePosition>(allocator, ObjectTreePosition{ static_cast<int>(i % 1000), static_cast<int>(i / 1000) })
+            });
+        }
+
+        auto end{ std::chrono::high_resolution_clock::now() };
+        auto objectBuildMsecs{ std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() };
+
+        start = std::chrono::high_resolution_clock::now();
+
+        long long objectChecksum{};
+        for (const ObjectTreeInstance& object : objects) {
+            objectChecksum += object.m_position->m_x + object.m_position->m_y + object.m_tree->m_height;
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+        auto objectIterateMsecs{ std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() };
+
+        // data-oriented design
+        start = std::chrono::high_resolution_clock::now();
+
+        Forest forest;
+        forest.reserve(Count);
+
+        TreeTypeId ids[StyleCount]{};
+        for (std::size_t i{}; i != StyleCount; ++i) {
+            ids[i] = forest.addType(Styles[i]);
+        }
+
+        for (std::size_t i{}; i != Count; ++i) {
+            forest.addTree(static_cast<int>(i % 1000), static_cast<int>(i / 1000), ids[i % StyleCount]);
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+        auto forestBuildMsecs{ std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() };
+
+        start = std::chrono::high_resolution_clock::now();
+
+        // the intrinsic state table is tiny, copy the needed column once
+        int heights[StyleCount]{};
+        for (std::size_t i{}; i != forest.types().size(); ++i) {
+            heights[i] = forest.types()[static_cast<TreeTypeId>(i)].m_height;
+        }
+
+        long long forestChecksum{};
+        forest.forEachBatch([&](const TreeBatch& batch) {
+
+            long long sum{};
+            for (std::size_t i{}; i != batch.size(); ++i) {
+                sum += batch.m_x[i] + batch.m_y[i] + heights[batch.m_type[i]];
+            }
+            forestChecksum += sum;
+        });
+
+        end = std::chrono::high_resolution_clock::now();
+        auto forestIterateMsecs{ std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() };
+
+        std::println("{} trees, {} styles:", Count, StyleCount);
+        std::println("  shared_ptr per tree: {} MB, build {} msecs, iterate {} msecs",
+            objectBytes / (1024 * 1024), objectBuildMsecs, objectIterateMsecs);
+        std::println("  SoA forest:          {} MB, build {} msecs, iterate {} msecs",
+            forest.footprint() / (1024 * 1024), forestBuildMsecs, forestIterateMsecs);
+        std::println("  bytes per tree:      {} vs {}",
+            objectBytes / Count, forest.footprint() / Count);
+        std::println("  Checksums {}", objectChecksum == forestChecksum ? "match" : "DIFFER");
+    }
+}
+
+void test_trees_game_data_oriented()
+{
+    using namespace TreesFlyweightDataOriented;
+
+    // using palm, cypress and garden styles
+    Forest forest{};
+    forest.addTree(1, 3, "palm");
+    forest.addTree(2, 5, "cypress");
+    forest.addTree(4, 8, "palm");
+    forest.addTree(4, 9, "cypress");
+    forest.addTree(5, 3, "garden");
+
+    forest.render(std::cout);
+
+    std::println("{} trees share {} tree types", forest.size(), forest.types().size());
+}
+
+void benchmark_trees_game_data_oriented()
+{
+    TreesFlyweightDataOriented::benchmark();
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
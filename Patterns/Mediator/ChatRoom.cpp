@@ -8,11 +8,26 @@
 #include <memory>
 #include <algorithm>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <print>
+#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
 namespace ChatRoomMediatorPattern
 {
     class ChatRoomBase                        // MediatorBase
     {
     public:
+        virtual ~ChatRoomBase() = default;
+
         virtual void broadcast(const std::string& from, const std::string& msg) = 0;                        // notify
         virtual void message(const std::string& from, const std::string& to, const std::string& msg) = 0;   // reactOn
     };
@@ -168,6 +183,604 @@ void test_chatroom_example()
     jane->postMessage("Simon", "Glad you found us, simon!");
 }
 
+namespace ChatRoomMediatorPattern
+{
+    // =======================================================================
+    // chat room for a large number of members
+
+    using MemberId = std::uint32_t;
+
+    constexpr MemberId NoMember{ 0xFFFFFFFFu };     // unknown member, broadcast target
+    constexpr MemberId RoomId{ 0xFFFFFFFEu };       // sender of messages by the room itself
+
+    /**
+     * Message as seen by a receiver. The text is owned by the chat room
+     * and only valid during the call of the message handler.
+     */
+    struct Delivery
+    {
+        MemberId                              m_from;
+        std::string_view                      m_text;
+        bool                                  m_private;
+        std::chrono::steady_clock::time_point m_sent;
+    };
+
+    // invoked on the thread of a shard with all messages delivered to a member in one go
+    using MessageHandler = std::function<void(MemberId, std::span<const Delivery>)>;
+
+    /**
+     * Multi-producer, single-consumer queue of batches.
+     * Producers push a whole batch with a single CAS onto a lock-free stack,
+     * the consumer takes all batches at once and restores their order.
+     */
+    template <typename T>
+    class BatchQueue
+    {
+    private:
+        struct Batch
+        {
+            std::vector<T> m_items;
+            Batch*         m_next{};
+        };
+
+        std::atomic<Batch*> m_head{ nullptr };
+
+    public:
+        BatchQueue() = default;
+
+        BatchQueue(const BatchQueue&) = delete;
+        BatchQueue& operator= (const BatchQueue&) = delete;
+
+        ~BatchQueue()
+        {
+            Batch* batch{ m_head.exchange(nullptr) };
+            while (batch != nullptr) {
+                Batch* next{ batch->m_next };
+                delete batch;
+                batch = next;
+            }
+        }
+
+        void push(std::vector<T> items)
+        {
+            Batch* batch{ new Batch{ std::move(items) } };
+
+            Batch* head{ m_head.load(std::memory_order_relaxed) };
+            do {
+                batch->m_next = head;
+            } while (!m_head.compare_exchange_weak(head, batch,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // appends all pending batches in the order of pushing, returns their number
+        std::size_t drain(std::vector<std::vector<T>>& batches)
+        {
+            Batch* head{ m_head.exchange(nullptr, std::memory_order_acquire) };
+
+            // stack => restore the order of pushing
+            Batch* ordered{ nullptr };
+            while (head != nullptr) {
+                Batch* next{ head->m_next };
+                head->m_next = ordered;
+                ordered = head;
+                head = next;
+            }
+
+            std::size_t count{};
+            while (ordered != nullptr) {
+                Batch* next{ ordered->m_next };
+                batches.push_back(std::move(ordered->m_items));
+                delete ordered;
+                ordered = next;
+                ++count;
+            }
+
+            return count;
+        }
+    };
+
+    /**
+     * Concrete Mediator for large rooms.
+     *
+     * Members are addressed by a MemberId, names are resolved by a hash index.
+     * Members are partitioned into shards, each shard owns its members and runs
+     * its own thread. Senders push messages in batches into the lock-free inbox
+     * of the target shard; a broadcast is pushed once per shard and fanned out
+     * there. The shard collects the messages of a member and hands them over to
+     * the MessageHandler as one batch - no I/O and no string copies per receiver.
+     */
+    class ShardedChatRoom : public ChatRoomBase
+    {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Kind : std::uint8_t { Join, Private, Broadcast };
+
+        struct Envelope
+        {
+            Kind                               m_kind;
+            MemberId                           m_from;
+            MemberId                           m_to;
+            std::shared_ptr<const std::string> m_text;      // shared by all shards for a broadcast
+            Clock::time_point                  m_sent;
+        };
+
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view sv) const noexcept {
+                return std::hash<std::string_view>{}(sv);
+            }
+        };
+
+        struct Member
+        {
+            MemberId              m_id;
+            std::vector<Delivery> m_inbox;                  // reused, keeps its capacity
+        };
+
+        struct alignas(64) Shard
+        {
+            BatchQueue<Envelope>       m_inbox;
+            std::atomic<std::uint64_t> m_pushed{};
+            std::atomic<std::uint64_t> m_processed{};
+            std::vector<Member>        m_members;           // owned by the shard thread
+            std::jthread               m_thread;
+        };
+
+    public:
+        /**
+         * Collects the messages of one sender and pushes them per shard
+         * as one batch, either when flush() is called or on destruction.
+         * An Outbox must be used by a single thread only.
+         */
+        class Outbox
+        {
+        private:
+            ShardedChatRoom&                   m_room;
+            std::vector<std::vector<Envelope>> m_pending;
+
+        public:
+            explicit Outbox(ShardedChatRoom& room) : m_room{ room }, m_pending(room.m_shardCount) {}
+
+            Outbox(const Outbox&) = delete;
+            Outbox& operator= (const Outbox&) = delete;
+
+            ~Outbox() { flush(); }
+
+            void message(MemberId from, MemberId to, std::string_view msg)
+            {
+                m_pending[m_room.shardOf(to)].push_back(
+                    Envelope{ Kind::Private, from, to, std::make_shared<const std::string>(msg), Clock::now() });
+            }
+
+            void broadcast(MemberId from, std::string_view msg)
+            {
+                auto text{ std::make_shared<const std::string>(msg) };
+                const Clock::time_point now{ Clock::now() };
+                for (auto& pending : m_pending) {
+                    pending.push_back(Envelope{ Kind::Broadcast, from, NoMember, text, now });
+                }
+            }
+
+            void flush()
+            {
+                for (std::size_t shard{}; shard != m_pending.size(); ++shard) {
+                    if (!m_pending[shard].empty()) {
+                        m_room.post(shard, std::move(m_pending[shard]));
+                        m_pending[shard].clear();
+                    }
+                }
+            }
+        };
+
+    private:
+        const std::size_t        m_shardCount;
+        MessageHandler           m_handler;
+
+        mutable std::shared_mutex m_mutex;                  // guards the index, rarely written
+        std::unordered_map<std::string, MemberId, StringHash, std::equal_to<>> m_index;
+        std::vector<std::string> m_names;                   // MemberId => name
+
+        std::unique_ptr<Shard[]> m_shards;                  // last member: threads stop first
+
+    public:
+        ShardedChatRoom(std::size_t shards, MessageHandler handler)
+            : m_shardCount{ std::max<std::size_t>(shards, 1) },
+              m_handler{ std::move(handler) },
+              m_shards{ std::make_unique<Shard[]>(m_shardCount) }
+        {
+            for (std::size_t shard{}; shard != m_shardCount; ++shard) {
+                m_shards[shard].m_thread = std::jthread{ [this, shard](std::stop_token token) { run(shard, token); } };
+            }
+        }
+
+        ShardedChatRoom(const ShardedChatRoom&) = delete;
+        ShardedChatRoom& operator= (const ShardedChatRoom&) = delete;
+
+        ~ShardedChatRoom()
+        {
+            for (std::size_t shard{}; shard != m_shardCount; ++shard) {
+                m_shards[shard].m_thread.request_stop();
+                wakeUp(m_shards[shard]);
+            }
+        }
+
+        std::size_t shards() const noexcept { return m_shardCount; }
+
+        // adds a member, a name joins only once
+        MemberId join(std::string_view name, bool announce = true)
+        {
+            MemberId id{};
+            {
+                std::unique_lock<std::shared_mutex> guard{ m_mutex };
+
+                if (auto pos{ m_index.find(name) }; pos != m_index.end()) {
+                    return pos->second;
+                }
+
+                id = static_cast<MemberId>(m_names.size());
+                m_names.emplace_back(name);
+
+                // the shard creates the member before any message to it is visible
+                post(shardOf(id), std::vector<Envelope>{ Envelope{ Kind::Join, RoomId, id, nullptr, Clock::now() } });
+
+                m_index.emplace(std::string{ name }, id);
+            }
+
+            if (announce) {
+                broadcast(RoomId, std::string{ name } + " joins the chat");
+            }
+
+            return id;
+        }
+
+        MemberId find(std::string_view name) const
+        {
+            std::shared_lock<std::shared_mutex> guard{ m_mutex };
+            auto pos{ m_index.find(name) };
+            return pos == m_index.end() ? NoMember : pos->second;
+        }
+
+        std::string name(MemberId id) const
+        {
+            if (id == RoomId) {
+                return "my_room";
+            }
+
+            std::shared_lock<std::shared_mutex> guard{ m_mutex };
+            return id < m_names.size() ? m_names[id] : std::string{};
+        }
+
+        std::size_t size() const
+        {
+            std::shared_lock<std::shared_mutex> guard{ m_mutex };
+            return m_names.size();
+        }
+
+        // single messages, for many messages an Outbox is cheaper
+        void broadcast(MemberId from, std::string_view msg)
+        {
+            Outbox outbox{ *this };
+            outbox.broadcast(from, msg);
+        }
+
+        void message(MemberId from, MemberId to, std::string_view msg)
+        {
+            Outbox outbox{ *this };
+            outbox.message(from, to, msg);
+        }
+
+        // ChatRoomBase interface: names are resolved by the index
+        void broadcast(const std::string& from, const std::string& msg) override
+        {
+            broadcast(find(from), msg);
+        }
+
+        void message(const std::string& from, const std::string& to, const std::string& msg) override
+        {
+            const MemberId target{ find(to) };
+            if (target != NoMember) {
+                message(find(from), target, msg);
+            }
+        }
+
+        // waits until all messages posted so far have been delivered
+        void waitIdle() const
+        {
+            for (std::size_t shard{}; shard != m_shardCount; ++shard) {
+
+                const Shard& s{ m_shards[shard] };
+                const std::uint64_t pushed{ s.m_pushed.load(std::memory_order_acquire) };
+
+                std::uint64_t processed{ s.m_processed.load(std::memory_order_acquire) };
+                while (processed < pushed) {
+                    s.m_processed.wait(processed);
+                    processed = s.m_processed.load(std::memory_order_acquire);
+                }
+            }
+        }
+
+    private:
+        std::size_t shardOf(MemberId id) const noexcept { return id % m_shardCount; }
+
+        std::size_t localIndexOf(MemberId id) const noexcept { return id / m_shardCount; }
+
+        void post(std::size_t shard, std::vector<Envelope> batch)
+        {
+            Shard& s{ m_shards[shard] };
+            s.m_inbox.push(std::move(batch));
+            wakeUp(s);
+        }
+
+        static void wakeUp(Shard& s)
+        {
+            s.m_pushed.fetch_add(1, std::memory_order_release);
+            s.m_pushed.notify_one();
+        }
+
+        void run(std::size_t shard, std::stop_token token)
+        {
+            Shard& s{ m_shards[shard] };
+
+            std::vector<std::vector<Envelope>> batches{};
+            std::vector<std::uint32_t> ready{};             // members with a non-empty inbox
+
+            while (true) {
+
+                const std::uint64_t signal{ s.m_pushed.load(std::memory_order_acquire) };
+                const std::size_t count{ s.m_inbox.drain(batches) };
+
+                if (count == 0) {
+                    if (token.stop_requested()) {
+                        return;
+                    }
+
+                    s.m_pushed.wait(signal);
+                    continue;
+                }
+
+                for (const auto& batch : batches) {
+                    for (const Envelope& envelope : batch) {
+                        dispatch(s, envelope, ready);
+                    }
+                }
+
+                // batched delivery: one handler call per member
+                for (std::uint32_t local : ready) {
+                    Member& member{ s.m_members[local] };
+                    if (m_handler) {
+                        m_handler(member.m_id, std::span<const Delivery>{ member.m_inbox });
+                    }
+                    member.m_inbox.clear();
+                }
+
+                ready.clear();
+                batches.clear();
+
+                s.m_processed.fetch_add(count, std::memory_order_release);
+                s.m_processed.notify_all();
+            }
+        }
+
+        void dispatch(Shard& s, const Envelope& envelope, std::vector<std::uint32_t>& ready)
+        {
+            auto deliver = [&](std::uint32_t local) {
+                Member& member{ s.m_members[local] };
+                if (member.m_inbox.empty()) {
+                    ready.push_back(local);
+                }
+                member.m_inbox.push_back(
+                    Delivery{ envelope.m_from, *envelope.m_text, envelope.m_kind == Kind::Private, envelope.m_sent });
+            };
+
+            switch (envelope.m_kind)
+            {
+            case Kind::Join:
+                s.m_members.push_back(Member{ envelope.m_to, {} });
+                break;
+
+            case Kind::Private:
+                if (const std::size_t local{ localIndexOf(envelope.m_to) }; local < s.m_members.size()) {
+                    deliver(static_cast<std::uint32_t>(local));
+                }
+                break;
+
+            case Kind::Broadcast:
+                // send message to all chat room members - excluding the sender
+                for (std::size_t local{}; local != s.m_members.size(); ++local) {
+                    if (s.m_members[local].m_id != envelope.m_from) {
+                        deliver(static_cast<std::uint32_t>(local));
+                    }
+                }
+                break;
+            }
+        }
+    };
+}
+
+void test_sharded_chatroom_example()
+{
+    using namespace ChatRoomMediatorPattern;
+
+    std::shared_ptr<ShardedChatRoom> room{};
+
+    // the handler replaces Person::receive, it runs on the thread of a shard
+    auto handler = [&](MemberId to, std::span<const Delivery> messages) {
+        for (const Delivery& message : messages) {
+            std::println("[{}'s chat session] {}: \"{}\"", room->name(to), room->name(message.m_from), message.m_text);
+        }
+    };
+
+    // one shard: the pending messages of a member are delivered (and printed) as one batch
+    room = std::make_shared<ShardedChatRoom>(1, handler);
+
+    MemberId john{ room->join("John") };
+    MemberId jane{ room->join("Jane") };
+
+    room->broadcast(john, "Hi anybody ...");
+    room->broadcast(jane, "Oh, hello John");
+
+    MemberId simon{ room->join("Simon") };
+    room->broadcast(simon, "Hi everyone!");
+
+    // name based interface of the classic mediator
+    room->message("Jane", "Simon", "Glad you found us, simon!");
+
+    room->waitIdle();
+}
+
+namespace ChatRoomMediatorPattern
+{
+    // classic room without I/O: linear search by name, a new string per receiver
+    class LinearChatRoom
+    {
+    private:
+        struct Member
+        {
+            std::string              m_name;
+            std::vector<std::string> m_log;
+        };
+
+        std::vector<Member> m_members;
+
+    public:
+        void join(const std::string& name) { m_members.push_back(Member{ name, {} }); }
+
+        void broadcast(const std::string& from, const std::string& msg)
+        {
+            for (auto& member : m_members) {
+                if (member.m_name != from) {
+                    member.m_log.emplace_back(from + ": \"" + msg + "\"");
+                }
+            }
+        }
+
+        void message(const std::string& from, const std::string& to, const std::string& msg)
+        {
+            auto target{ std::find_if(m_members.begin(), m_members.end(),
+                [&](const auto& member) { return member.m_name == to; }) };
+
+            if (target != m_members.end()) {
+                target->m_log.emplace_back(from + ": \"" + msg + "\"");
+            }
+        }
+
+        void clear()
+        {
+            for (auto& member : m_members) {
+                member.m_log.clear();
+            }
+        }
+    };
+
+    static void benchmark()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::size_t Members{ 100'000 };
+        constexpr std::size_t Messages{ 1'000'000 };
+        constexpr std::size_t LinearMessages{ 2'000 };
+        constexpr std::size_t Broadcasts{ 20 };
+        constexpr std::size_t Producers{ 2 };
+        constexpr std::size_t FlushInterval{ 256 };
+
+        const std::size_t shards{ std::max<std::size_t>(2, std::thread::hardware_concurrency()) };
+
+        auto nameOf = [](std::size_t i) { return "member_" + std::to_string(i); };
+
+        // baseline
+        double linearMessageRate{};
+        double linearBroadcastMillis{};
+        {
+            LinearChatRoom room{};
+            for (std::size_t i{}; i != Members; ++i) {
+                room.join(nameOf(i));
+            }
+
+            auto start{ Clock::now() };
+            for (std::size_t i{}; i != LinearMessages; ++i) {
+                room.message(nameOf(i % Members), nameOf((i * 7919) % Members), "Hello");
+            }
+            auto end{ Clock::now() };
+            linearMessageRate = LinearMessages / std::chrono::duration<double>(end - start).count();
+
+            room.clear();
+
+            start = Clock::now();
+            for (std::size_t i{}; i != Broadcasts; ++i) {
+                room.broadcast(nameOf(i), "Hello everyone");
+            }
+            end = Clock::now();
+            linearBroadcastMillis = std::chrono::duration<double, std::milli>(end - start).count() / Broadcasts;
+        }
+
+        // sharded room
+        std::atomic<std::size_t> delivered{};
+        auto handler = [&](MemberId, std::span<const Delivery> messages) {
+            delivered.fetch_add(messages.size(), std::memory_order_relaxed);
+        };
+
+        ShardedChatRoom room{ shards, handler };
+
+        std::vector<MemberId> ids{};
+        ids.reserve(Members);
+        for (std::size_t i{}; i != Members; ++i) {
+            ids.push_back(room.join(nameOf(i), false));
+        }
+
+        room.waitIdle();
+
+        // private messages, sent by several threads
+        auto start{ Clock::now() };
+        {
+            std::vector<std::jthread> producers{};
+            for (std::size_t p{}; p != Producers; ++p) {
+                producers.emplace_back([&, p] {
+                    ShardedChatRoom::Outbox outbox{ room };
+                    for (std::size_t i{ p }; i < Messages; i += Producers) {
+                        outbox.message(ids[i % Members], ids[(i * 7919) % Members], "Hello");
+                        if (i % FlushInterval == p) {
+                            outbox.flush();
+                        }
+                    }
+                });
+            }
+        }
+        room.waitIdle();
+        auto end{ Clock::now() };
+        const double messageRate{ Messages / std::chrono::duration<double>(end - start).count() };
+        const bool messagesCorrect{ delivered.load() == Messages };
+
+        // broadcast fan-out latency: from sending until the last member received it
+        delivered = 0;
+        double totalMillis{};
+        double worstMillis{};
+        for (std::size_t i{}; i != Broadcasts; ++i) {
+            start = Clock::now();
+            room.broadcast(ids[i], "Hello everyone");
+            room.waitIdle();
+            end = Clock::now();
+            const double millis{ std::chrono::duration<double, std::milli>(end - start).count() };
+            totalMillis += millis;
+            worstMillis = std::max(worstMillis, millis);
+        }
+        const bool broadcastsCorrect{ delivered.load() == Broadcasts * (Members - 1) };
+
+        std::println("{} members, {} shards:", Members, shards);
+        std::println("  private messages: linear {:.0f} msgs/sec, sharded {:.0f} msgs/sec ({})",
+            linearMessageRate, messageRate, messagesCorrect ? "all delivered" : "LOST MESSAGES");
+        std::println("  broadcast:        linear {:.1f} ms, sharded avg {:.1f} ms, max {:.1f} ms ({})",
+            linearBroadcastMillis, totalMillis / Broadcasts, worstMillis, broadcastsCorrect ? "all delivered" : "LOST MESSAGES");
+    }
+}
+
+void benchmark_sharded_chatroom()
+{
+    ChatRoomMediatorPattern::benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
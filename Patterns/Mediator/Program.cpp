@@ -6,12 +6,16 @@
 extern void test_conceptual_example01();
 extern void test_conceptual_example02();
 extern void test_chatroom_example();
+extern void test_sharded_chatroom_example();
+extern void benchmark_sharded_chatroom();
 
 int main()
 {
     test_conceptual_example01();
     //test_conceptual_example02();
     //test_chatroom_example();
+    //test_sharded_chatroom_example();
+    //benchmark_sharded_chatroom();
 
     return 0;
 }
@@ -2,9 +2,19 @@
 // ConceptualExample01.cpp // Memento Pattern
 // ===========================================================================
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
 #include <memory>
 #include <print>
+#include <random>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // very simple example of memento pattern
@@ -19,6 +29,12 @@ namespace ConceptualExample01 {
         // only the Originator is permitted to see Memento internals
         friend class Originator;
 
+    public:
+        // opaque representations for caretakers storing many mementos (see HistoryCareTaker):
+        // they can only be created from mementos and only be turned back into mementos
+        class Delta;
+        class Packed;
+
     private:
         std::string m_state;
 
@@ -27,6 +43,21 @@ namespace ConceptualExample01 {
 
         // private getter: no one other than the originator can read the state.
         const auto& getState() const noexcept { return m_state; }
+
+    public:
+        // bytes held by the memento - doesn't reveal the state itself
+        std::size_t memoryUsage() const noexcept { return sizeof(Memento) + m_state.capacity(); }
+
+        // narrow interface for caretakers, the state isn't revealed
+        [[nodiscard]]
+        Delta deltaTo(const Memento& next) const;
+
+        [[nodiscard]]
+        Packed pack(bool compress) const;
+
+        // the packed memento with the given deltas applied in order
+        [[nodiscard]]
+        static std::unique_ptr<Memento> unpack(const Packed& packed, std::span<const Delta> deltas);
     };
 
     class Originator
@@ -41,7 +72,7 @@ namespace ConceptualExample01 {
         // getter / setter
         void setState(std::string state) { m_state = std::move(state); }
 
-        const std::string& getState() const noexcept { return m_state; } const
+        const std::string& getState() const noexcept { return m_state; }
 
         // public interface
         [[nodiscard]]
@@ -98,6 +129,481 @@ namespace ConceptualExample01 {
             return m_history.size();
         }
     };
+
+    // =======================================================================
+    // history of mementos for large states with small changes
+
+    /**
+     * Minimal LZ77 codec for the checkpoints of the HistoryCareTaker.
+     * Format: repeated [literal count][literals][match length][match offset],
+     * all counts as variable-length integers, terminated by a match length of 0.
+     */
+    class Compressor
+    {
+    private:
+        static constexpr std::size_t MinMatch{ 4 };
+        static constexpr std::size_t HashBits{ 15 };
+
+        static void writeVarint(std::string& out, std::size_t value)
+        {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        static std::size_t readVarint(std::string_view in, std::size_t& pos)
+        {
+            std::size_t value{};
+            for (int shift{}; ; shift += 7) {
+                const auto byte{ static_cast<unsigned char>(in[pos++]) };
+                value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+        }
+
+        static std::uint32_t hash(const char* p) noexcept
+        {
+            std::uint32_t value{};
+            std::memcpy(&value, p, sizeof(value));
+            return (value * 2654435761u) >> (32 - HashBits);
+        }
+
+    public:
+        static std::string compress(std::string_view in)
+        {
+            std::string out{};
+            out.reserve(in.size() / 2);
+
+            std::vector<std::uint32_t> table(std::size_t{ 1 } << HashBits, 0);   // position + 1, 0: empty
+
+            std::size_t literals{};
+            std::size_t pos{};
+
+            while (pos + MinMatch <= in.size()) {
+
+                std::uint32_t& slot{ table[hash(in.data() + pos)] };
+                const std::size_t candidate{ slot };
+                slot = static_cast<std::uint32_t>(pos + 1);
+
+                if (candidate != 0 && std::memcmp(in.data() + candidate - 1, in.data() + pos, MinMatch) == 0) {
+
+                    const std::size_t from{ candidate - 1 };
+                    std::size_t length{ MinMatch };
+                    while (pos + length < in.size() && in[from + length] == in[pos + length]) {
+                        ++length;
+                    }
+
+                    writeVarint(out, pos - literals);
+                    out.append(in.data() + literals, pos - literals);
+                    writeVarint(out, length);
+                    writeVarint(out, pos - from);
+
+                    pos += length;
+                    literals = pos;
+                }
+                else {
+                    ++pos;
+                }
+            }
+
+            writeVarint(out, in.size() - literals);
+            out.append(in.data() + literals, in.size() - literals);
+            writeVarint(out, 0);
+
+            out.shrink_to_fit();
+            return out;
+        }
+
+        static std::string decompress(std::string_view in, std::size_t size)
+        {
+            std::string out(size, '\0');
+            char* dest{ out.data() };
+
+            std::size_t pos{};
+            while (true) {
+
+                const std::size_t literals{ readVarint(in, pos) };
+                std::memcpy(dest, in.data() + pos, literals);
+                dest += literals;
+                pos += literals;
+
+                const std::size_t length{ readVarint(in, pos) };
+                if (length == 0) {
+                    return out;
+                }
+
+                const std::size_t offset{ readVarint(in, pos) };
+                if (offset >= length) {
+                    std::memcpy(dest, dest - offset, length);
+                    dest += length;
+                }
+                else {
+                    // the match overlaps its own output, copy byte by byte
+                    for (std::size_t i{}; i != length; ++i, ++dest) {
+                        *dest = *(dest - offset);
+                    }
+                }
+            }
+        }
+    };
+
+    // replaces m_erased characters at m_offset by m_inserted
+    class Memento::Delta
+    {
+    private:
+        friend class Memento;
+
+        std::size_t m_offset;
+        std::size_t m_erased;
+        std::string m_inserted;
+
+        Delta(std::size_t offset, std::size_t erased, std::string inserted)
+            : m_offset{ offset }, m_erased{ erased }, m_inserted{ std::move(inserted) }
+        {}
+
+    public:
+        std::size_t memoryUsage() const noexcept
+        {
+            return sizeof(Delta) + (m_inserted.size() > 15 ? m_inserted.capacity() : 0);
+        }
+    };
+
+    // full state, compressed if m_compressed
+    class Memento::Packed
+    {
+    private:
+        friend class Memento;
+
+        std::string m_bytes;
+        std::size_t m_size;             // uncompressed size
+        bool        m_compressed;
+
+        Packed(std::string bytes, std::size_t size, bool compressed)
+            : m_bytes{ std::move(bytes) }, m_size{ size }, m_compressed{ compressed }
+        {}
+
+    public:
+        std::size_t memoryUsage() const noexcept { return sizeof(Packed) + m_bytes.capacity(); }
+    };
+
+    Memento::Delta Memento::deltaTo(const Memento& next) const
+    {
+        std::string_view from{ m_state };
+        std::string_view to{ next.m_state };
+
+        std::size_t prefix{};
+        const std::size_t shorter{ std::min(from.size(), to.size()) };
+        while (prefix < shorter && from[prefix] == to[prefix]) {
+            ++prefix;
+        }
+
+        std::size_t suffix{};
+        while (suffix < shorter - prefix && from[from.size() - 1 - suffix] == to[to.size() - 1 - suffix]) {
+            ++suffix;
+        }
+
+        return Delta{ prefix, from.size() - prefix - suffix, std::string{ to.substr(prefix, to.size() - prefix - suffix) } };
+    }
+
+    Memento::Packed Memento::pack(bool compress) const
+    {
+        if (compress) {
+            return Packed{ Compressor::compress(m_state), m_state.size(), true };
+        }
+
+        return Packed{ m_state, m_state.size(), false };
+    }
+
+    // the deltas are applied to a list of pieces of the checkpoint and of the inserted
+    // texts: the state is assembled once at the end, not shifted once per delta
+    std::unique_ptr<Memento> Memento::unpack(const Packed& packed, std::span<const Delta> deltas)
+    {
+        std::string checkpoint{ packed.m_compressed ? Compressor::decompress(packed.m_bytes, packed.m_size) : packed.m_bytes };
+
+        if (deltas.empty()) {
+            return std::unique_ptr<Memento>{ new Memento{ std::move(checkpoint) } };
+        }
+
+        std::vector<std::string_view> pieces{ checkpoint };
+        std::vector<std::string_view> next{};
+
+        for (const Delta& delta : deltas) {
+
+            const std::size_t end{ delta.m_offset + delta.m_erased };
+            std::size_t first{};
+            bool inserted{ delta.m_inserted.empty() };
+
+            next.clear();
+            for (std::string_view piece : pieces) {
+
+                const std::size_t last{ first + piece.size() };
+
+                // part in front of the delta
+                if (first < delta.m_offset) {
+                    next.push_back(piece.substr(0, std::min(piece.size(), delta.m_offset - first)));
+                }
+
+                if (!inserted && last >= delta.m_offset) {
+                    next.push_back(delta.m_inserted);
+                    inserted = true;
+                }
+
+                // part behind the erased characters
+                if (last > end) {
+                    next.push_back(piece.substr(first < end ? end - first : 0));
+                }
+
+                first = last;
+            }
+
+            if (!inserted) {
+                next.push_back(delta.m_inserted);
+            }
+
+            pieces.swap(next);
+        }
+
+        std::size_t size{};
+        for (std::string_view piece : pieces) {
+            size += piece.size();
+        }
+
+        std::string state{};
+        state.reserve(size);
+        for (std::string_view piece : pieces) {
+            state += piece;
+        }
+
+        return std::unique_ptr<Memento>{ new Memento{ std::move(state) } };
+    }
+
+    /**
+     * CareTaker for large states with small changes.
+     *
+     * The history is a sequence of segments: every segment starts with a full
+     * checkpoint (optionally compressed), followed by deltas, each one against its
+     * predecessor. Deltas are stored uncompressed, they hold a few bytes only.
+     * Restoring a snapshot applies at most checkpointInterval - 1 deltas, the state
+     * itself is copied only once. Checkpoints and deltas are opaque: they are
+     * created by and turned back into mementos, the caretaker never sees a state.
+     *
+     * If a memory budget is given, old snapshots are either dropped or merged:
+     * merging joins the oldest two neighbouring segments by turning the checkpoint of
+     * the second one into a delta. No snapshot is lost, but restoring old snapshots takes longer
+     * chains; merged segments are limited to m_maxMergedChain snapshots, beyond that
+     * the oldest snapshots are dropped. Dropping removes the whole oldest segment,
+     * only the last remaining segment is rebased onto a new checkpoint.
+     */
+    class HistoryCareTaker
+    {
+    public:
+        enum class BudgetPolicy { DropOldest, MergeOldest };
+
+        struct Options
+        {
+            std::size_t  m_checkpointInterval{ 64 };
+            bool         m_compress{ true };
+            std::size_t  m_memoryBudget{};          // in bytes, 0: unbounded
+            BudgetPolicy m_policy{ BudgetPolicy::DropOldest };
+            std::size_t  m_maxMergedChain{ 1024 };
+        };
+
+    private:
+        struct Segment
+        {
+            Memento::Packed             m_checkpoint;
+            std::vector<Memento::Delta> m_deltas;
+
+            std::size_t snapshots() const noexcept { return 1 + m_deltas.size(); }
+        };
+
+        Options                  m_options;
+        std::deque<Segment>      m_segments;
+        std::unique_ptr<Memento> m_tip;             // latest snapshot
+        std::size_t              m_size;
+        std::size_t              m_memory;
+
+    public:
+        HistoryCareTaker() : HistoryCareTaker{ Options{} } {}
+
+        explicit HistoryCareTaker(Options options)
+            : m_options{ options }, m_size{}, m_memory{}
+        {
+            if (m_options.m_checkpointInterval == 0) {
+                m_options.m_checkpointInterval = 1;
+            }
+        }
+
+        void backup(std::unique_ptr<Memento> memento)
+        {
+            if (m_segments.empty() || m_segments.back().snapshots() >= m_options.m_checkpointInterval) {
+                m_segments.push_back(Segment{ memento->pack(m_options.m_compress), {} });
+                m_memory += usage(m_segments.back());
+            }
+            else {
+                Memento::Delta delta{ m_tip->deltaTo(*memento) };
+                m_memory += delta.memoryUsage();
+                m_segments.back().m_deltas.push_back(std::move(delta));
+            }
+
+            m_tip = std::move(memento);
+            ++m_size;
+
+            enforceBudget();
+        }
+
+        // removes the latest memento from the history and returns it
+        [[nodiscard]]
+        std::unique_ptr<Memento> latest()
+        {
+            if (m_size == 0) {
+                return nullptr;
+            }
+
+            std::unique_ptr<Memento> memento{ std::move(m_tip) };
+
+            Segment& segment{ m_segments.back() };
+            if (segment.m_deltas.empty()) {
+                m_memory -= usage(segment);
+                m_segments.pop_back();
+            }
+            else {
+                m_memory -= segment.m_deltas.back().memoryUsage();
+                segment.m_deltas.pop_back();
+            }
+
+            --m_size;
+            m_tip = (m_size == 0) ? nullptr : reconstruct(m_segments.size() - 1, m_segments.back().snapshots() - 1);
+
+            return memento;
+        }
+
+        // returns a copy of the memento at the given position (0 = oldest)
+        [[nodiscard]]
+        std::unique_ptr<Memento> at(std::size_t index) const
+        {
+            if (index >= m_size) {
+                return nullptr;
+            }
+
+            if (index == m_size - 1) {
+                return std::make_unique<Memento>(*m_tip);
+            }
+
+            std::size_t segment{};
+            while (index >= m_segments[segment].snapshots()) {
+                index -= m_segments[segment].snapshots();
+                ++segment;
+            }
+
+            return reconstruct(segment, index);
+        }
+
+        bool empty() const noexcept { return m_size == 0; }
+
+        std::size_t size() const noexcept { return m_size; }
+
+        // bytes held by the history, without the state of the latest snapshot
+        std::size_t memoryUsage() const noexcept { return m_memory; }
+
+    private:
+        static std::size_t usage(const Segment& segment) noexcept
+        {
+            std::size_t bytes{ sizeof(Segment) - sizeof(Memento::Packed) + segment.m_checkpoint.memoryUsage() };
+            for (const Memento::Delta& delta : segment.m_deltas) {
+                bytes += delta.memoryUsage();
+            }
+            return bytes;
+        }
+
+        // snapshot 'index' of the given segment: its checkpoint with 'index' deltas applied
+        std::unique_ptr<Memento> reconstruct(std::size_t segment, std::size_t index) const
+        {
+            const Segment& source{ m_segments[segment] };
+            return Memento::unpack(source.m_checkpoint, std::span{ source.m_deltas }.first(index));
+        }
+
+        void enforceBudget()
+        {
+            if (m_options.m_memoryBudget == 0) {
+                return;
+            }
+
+            while (m_memory > m_options.m_memoryBudget && m_size > 1) {
+
+                const std::size_t index{
+                    m_options.m_policy == BudgetPolicy::MergeOldest ? findMergeableSegments() : m_segments.size() };
+
+                if (index != m_segments.size()) {
+                    mergeSegments(index);
+                }
+                else if (m_segments.size() > 1) {
+                    dropOldestSegment();
+                }
+                else {
+                    dropOldestSnapshot();
+                }
+            }
+        }
+
+        // O(1): no checkpoint has to be decoded and encoded again
+        void dropOldestSegment()
+        {
+            m_memory -= usage(m_segments.front());
+            m_size -= m_segments.front().snapshots();
+            m_segments.pop_front();
+        }
+
+        // the second snapshot of the oldest segment becomes its new checkpoint
+        void dropOldestSnapshot()
+        {
+            Segment& oldest{ m_segments.front() };
+            m_memory -= usage(oldest);
+
+            if (oldest.m_deltas.empty()) {
+                m_segments.pop_front();
+            }
+            else {
+                Segment segment{ reconstruct(0, 1)->pack(m_options.m_compress), {} };
+                segment.m_deltas.assign(std::make_move_iterator(oldest.m_deltas.begin() + 1), std::make_move_iterator(oldest.m_deltas.end()));
+                oldest = std::move(segment);
+                m_memory += usage(oldest);
+            }
+
+            --m_size;
+        }
+
+        // oldest pair of neighbouring segments that may be merged, the segment of the latest snapshot excluded
+        std::size_t findMergeableSegments() const noexcept
+        {
+            for (std::size_t i{}; i + 2 < m_segments.size(); ++i) {
+                if (m_segments[i].snapshots() + m_segments[i + 1].snapshots() <= m_options.m_maxMergedChain) {
+                    return i;
+                }
+            }
+            return m_segments.size();
+        }
+
+        // appends a segment to its predecessor, its checkpoint becomes a delta
+        void mergeSegments(std::size_t index)
+        {
+            Segment& first{ m_segments[index] };
+            Segment& second{ m_segments[index + 1] };
+
+            m_memory -= usage(first) + usage(second);
+
+            first.m_deltas.push_back(reconstruct(index, first.m_deltas.size())->deltaTo(*reconstruct(index + 1, 0)));
+            first.m_deltas.insert(first.m_deltas.end(),
+                std::make_move_iterator(second.m_deltas.begin()), std::make_move_iterator(second.m_deltas.end()));
+
+            m_memory += usage(first);
+            m_segments.erase(m_segments.begin() + index + 1);
+        }
+    };
 }
 
 void test_conceptual_example_01() {
@@ -164,6 +670,160 @@ void test_conceptual_example_02() {
     std::println("{}", originator.getState());
 }
 
+void test_conceptual_example_03() {
+
+    using namespace ConceptualExample01;
+
+    Originator originator{ "State A" };
+
+    HistoryCareTaker caretaker{ HistoryCareTaker::Options{ 4, true, 0, HistoryCareTaker::BudgetPolicy::DropOldest } };
+
+    for (char ch{ 'A' }; ch <= 'J'; ++ch) {
+        originator.setState(std::string{ "State " } + ch);
+        caretaker.backup(originator.save());
+    }
+
+    std::println("{} snapshots, {} bytes", caretaker.size(), caretaker.memoryUsage());
+
+    // restore an arbitrary snapshot
+    auto memento{ caretaker.at(5) };
+    if (memento) {
+        originator.restore(*memento);
+    }
+    std::println("{}", originator.getState());
+
+    // undo the last two changes
+    for (int i{}; i != 2; ++i) {
+        memento = caretaker.latest();
+        if (memento) {
+            originator.restore(*memento);
+        }
+        std::println("{}", originator.getState());
+    }
+}
+
+namespace ConceptualExample01 {
+
+    // editor-style state: a large text and many tiny edits
+    static void benchmark() {
+
+        constexpr std::size_t StateSize{ 1024 * 1024 };
+        constexpr std::size_t Snapshots{ 5'000 };
+        constexpr std::size_t BaselineSnapshots{ 200 };
+
+        const std::string_view words[]{ "memento ", "originator ", "caretaker ", "state ", "snapshot ", "history ", "undo ", "redo " };
+
+        std::mt19937 engine{ 4711 };
+        std::string text{};
+        while (text.size() < StateSize) {
+            text += words[engine() % std::size(words)];
+        }
+
+        auto edit = [&](std::string& state) {
+            const std::size_t pos{ engine() % state.size() };
+            if (engine() % 2 == 0) {
+                state.insert(pos, words[engine() % std::size(words)]);
+            }
+            else {
+                state.erase(pos, std::min<std::size_t>(8, state.size() - pos));
+            }
+        };
+
+        // baseline: CareTaker with a full copy per snapshot
+        std::size_t baselinePerSnapshot{};
+        {
+            Originator originator{ text };
+            CareTaker caretaker{};
+            std::string state{ text };
+
+            for (std::size_t i{}; i != BaselineSnapshots; ++i) {
+                edit(state);
+                originator.setState(state);
+                caretaker.backup(originator.save());
+            }
+
+            // size of a stored memento, not of the (grown) working copy
+            std::unique_ptr<Memento> memento{ caretaker.latest() };
+            baselinePerSnapshot = sizeof(std::unique_ptr<Memento>) + memento->memoryUsage();
+        }
+
+        for (auto [compress, title] : { std::pair{ false, "deltas:            " }, std::pair{ true, "deltas, compressed:" } }) {
+
+            Originator originator{ text };
+            HistoryCareTaker caretaker{ HistoryCareTaker::Options{ 64, compress, 0, HistoryCareTaker::BudgetPolicy::DropOldest } };
+            std::string state{ text };
+            std::vector<std::string> expected{};
+
+            auto start{ std::chrono::high_resolution_clock::now() };
+
+            for (std::size_t i{}; i != Snapshots; ++i) {
+                edit(state);
+                originator.setState(state);
+                caretaker.backup(originator.save());
+                if (i % 1000 == 0) {
+                    expected.push_back(state);
+                }
+            }
+
+            auto end{ std::chrono::high_resolution_clock::now() };
+            const double backupMicros{ std::chrono::duration<double, std::micro>(end - start).count() / Snapshots };
+
+            // restore latency for random positions
+            double worstMicros{};
+            double totalMicros{};
+            constexpr std::size_t Restores{ 200 };
+            for (std::size_t i{}; i != Restores; ++i) {
+                const std::size_t index{ engine() % Snapshots };
+                start = std::chrono::high_resolution_clock::now();
+                auto memento{ caretaker.at(index) };
+                originator.restore(*memento);
+                end = std::chrono::high_resolution_clock::now();
+                const double micros{ std::chrono::duration<double, std::micro>(end - start).count() };
+                totalMicros += micros;
+                worstMicros = std::max(worstMicros, micros);
+            }
+
+            bool correct{ true };
+            for (std::size_t i{}; i != expected.size(); ++i) {
+                originator.restore(*caretaker.at(i * 1000));
+                correct = correct && originator.getState() == expected[i];
+            }
+
+            std::println("  {} {:>8} bytes per snapshot, backup {:.1f} us, restore avg {:.1f} us, max {:.1f} us, {}",
+                title, caretaker.memoryUsage() / Snapshots, backupMicros,
+                totalMicros / Restores, worstMicros, correct ? "correct" : "WRONG");
+        }
+
+        // memory budget: 8 MB for the whole history
+        for (auto policy : { HistoryCareTaker::BudgetPolicy::DropOldest, HistoryCareTaker::BudgetPolicy::MergeOldest }) {
+
+            Originator originator{ text };
+            HistoryCareTaker caretaker{ HistoryCareTaker::Options{ 64, true, 8 * 1024 * 1024, policy } };
+            std::string state{ text };
+
+            for (std::size_t i{}; i != Snapshots; ++i) {
+                edit(state);
+                originator.setState(state);
+                caretaker.backup(originator.save());
+            }
+
+            originator.restore(*caretaker.at(caretaker.size() - 1));
+
+            std::println("  budget 8 MB, {}: {} snapshots kept, {} KB used, latest {}",
+                policy == HistoryCareTaker::BudgetPolicy::DropOldest ? "drop oldest " : "merge oldest",
+                caretaker.size(), caretaker.memoryUsage() / 1024,
+                originator.getState() == state ? "correct" : "WRONG");
+        }
+
+        std::println("  full copies:        {:>8} bytes per snapshot", baselinePerSnapshot);
+    }
+}
+
+void benchmark_conceptual_example()
+{
+    ConceptualExample01::benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -0,0 +1,614 @@
+// ===========================================================================
+// PersistentState.cpp // Memento Pattern
+// ===========================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// memento pattern with an immutable, structurally shared state
+namespace PersistentMementoExample {
+
+    /**
+     * Persistent (immutable) text, implemented as a height-balanced rope.
+     * Every modification returns a new Rope, which shares all untouched nodes
+     * with the original one. Copying a Rope copies a single pointer.
+     * Nodes are never modified after construction, so Ropes may be read by
+     * any number of threads without synchronization.
+     */
+    class Rope
+    {
+    private:
+        static constexpr std::size_t MaxLeaf{ 512 };
+
+        struct Node;
+        using NodePtr = std::shared_ptr<const Node>;
+
+        struct Node
+        {
+            std::size_t m_size{};
+            int         m_height{};         // 0: leaf
+            NodePtr     m_left;
+            NodePtr     m_right;
+            std::string m_text;             // leaves only
+        };
+
+        NodePtr m_root;
+
+        explicit Rope(NodePtr root) noexcept : m_root{ std::move(root) } {}
+
+    public:
+        Rope() = default;
+
+        explicit Rope(std::string_view text) : m_root{ build(text) } {}
+
+        std::size_t size() const noexcept { return m_root ? m_root->m_size : 0; }
+
+        bool empty() const noexcept { return size() == 0; }
+
+        int height() const noexcept { return m_root ? m_root->m_height : 0; }
+
+        char at(std::size_t pos) const
+        {
+            const Node* node{ m_root.get() };
+            while (node->m_height != 0) {
+                if (pos < node->m_left->m_size) {
+                    node = node->m_left.get();
+                }
+                else {
+                    pos -= node->m_left->m_size;
+                    node = node->m_right.get();
+                }
+            }
+            return node->m_text[pos];
+        }
+
+        [[nodiscard]]
+        Rope insert(std::size_t pos, std::string_view text) const
+        {
+            pos = std::min(pos, size());
+
+            if (text.empty()) {
+                return *this;
+            }
+
+            if (!m_root) {
+                return Rope{ build(text) };
+            }
+
+            // small edits stay inside a single leaf: copy the leaf and its path only
+            if (NodePtr root{ insertIntoLeaf(m_root, pos, text) }; root) {
+                return Rope{ std::move(root) };
+            }
+
+            auto [left, right] { split(m_root, pos) };
+            return Rope{ join(join(std::move(left), build(text)), std::move(right)) };
+        }
+
+        [[nodiscard]]
+        Rope erase(std::size_t pos, std::size_t count) const
+        {
+            pos = std::min(pos, size());
+            count = std::min(count, size() - pos);
+
+            if (count == 0) {
+                return *this;
+            }
+
+            if (NodePtr root{ eraseFromLeaf(m_root, pos, count) }; root) {
+                return Rope{ std::move(root) };
+            }
+
+            auto [left, rest] { split(m_root, pos) };
+            auto [erased, right] { split(std::move(rest), count) };
+            return Rope{ join(std::move(left), std::move(right)) };
+        }
+
+        // invokes visitor(std::string_view) for all leaves from left to right
+        template <typename TVisitor>
+        void forEachChunk(TVisitor&& visitor) const
+        {
+            if (m_root) {
+                visitChunks(*m_root, visitor);
+            }
+        }
+
+        std::string toString() const
+        {
+            std::string result{};
+            result.reserve(size());
+            forEachChunk([&](std::string_view chunk) { result += chunk; });
+            return result;
+        }
+
+        // bytes of all distinct nodes reachable from the given ropes: shared nodes count once
+        static std::size_t footprint(const std::vector<Rope>& ropes)
+        {
+            std::unordered_set<const Node*> visited{};
+            std::size_t bytes{};
+
+            std::vector<const Node*> stack{};
+            for (const Rope& rope : ropes) {
+                if (rope.m_root) {
+                    stack.push_back(rope.m_root.get());
+                }
+            }
+
+            while (!stack.empty()) {
+
+                const Node* node{ stack.back() };
+                stack.pop_back();
+
+                if (!visited.insert(node).second) {
+                    continue;
+                }
+
+                // node and control block are allocated together by std::make_shared
+                bytes += sizeof(Node) + 2 * sizeof(long) + node->m_text.capacity();
+                if (node->m_height != 0) {
+                    stack.push_back(node->m_left.get());
+                    stack.push_back(node->m_right.get());
+                }
+            }
+
+            return bytes;
+        }
+
+    private:
+        static NodePtr makeLeaf(std::string text)
+        {
+            return std::make_shared<const Node>(Node{ text.size(), 0, nullptr, nullptr, std::move(text) });
+        }
+
+        static NodePtr makeNode(NodePtr left, NodePtr right)
+        {
+            const std::size_t size{ left->m_size + right->m_size };
+            const int height{ 1 + std::max(left->m_height, right->m_height) };
+            return std::make_shared<const Node>(Node{ size, height, std::move(left), std::move(right), {} });
+        }
+
+        // balanced tree of half-filled leaves, leaving room for later edits
+        static NodePtr build(std::string_view text)
+        {
+            if (text.empty()) {
+                return nullptr;
+            }
+
+            if (text.size() <= MaxLeaf / 2) {
+                return makeLeaf(std::string{ text });
+            }
+
+            const std::size_t leaves{ (text.size() + MaxLeaf / 2 - 1) / (MaxLeaf / 2) };
+            const std::size_t middle{ (leaves / 2) * (MaxLeaf / 2) };
+            return makeNode(build(text.substr(0, middle)), build(text.substr(middle)));
+        }
+
+        static NodePtr rotateLeft(const NodePtr& node)
+        {
+            const NodePtr& right{ node->m_right };
+            return makeNode(makeNode(node->m_left, right->m_left), right->m_right);
+        }
+
+        static NodePtr rotateRight(const NodePtr& node)
+        {
+            const NodePtr& left{ node->m_left };
+            return makeNode(left->m_left, makeNode(left->m_right, node->m_right));
+        }
+
+        // AVL join, left is higher than right by at least 2
+        static NodePtr joinRight(const NodePtr& left, NodePtr right)
+        {
+            const NodePtr& inner{ left->m_right };
+
+            if (inner->m_height <= right->m_height + 1) {
+                NodePtr node{ makeNode(inner, std::move(right)) };
+                if (node->m_height <= left->m_left->m_height + 1) {
+                    return makeNode(left->m_left, std::move(node));
+                }
+                return rotateLeft(makeNode(left->m_left, rotateRight(node)));
+            }
+
+            NodePtr node{ joinRight(inner, std::move(right)) };
+            NodePtr result{ makeNode(left->m_left, node) };
+            if (node->m_height <= left->m_left->m_height + 1) {
+                return result;
+            }
+            return rotateLeft(result);
+        }
+
+        // mirror image of joinRight, right is higher than left by at least 2
+        static NodePtr joinLeft(NodePtr left, const NodePtr& right)
+        {
+            const NodePtr& inner{ right->m_left };
+
+            if (inner->m_height <= left->m_height + 1) {
+                NodePtr node{ makeNode(std::move(left), inner) };
+                if (node->m_height <= right->m_right->m_height + 1) {
+                    return makeNode(std::move(node), right->m_right);
+                }
+                return rotateRight(makeNode(rotateLeft(node), right->m_right));
+            }
+
+            NodePtr node{ joinLeft(std::move(left), inner) };
+            NodePtr result{ makeNode(node, right->m_right) };
+            if (node->m_height <= right->m_right->m_height + 1) {
+                return result;
+            }
+            return rotateRight(result);
+        }
+
+        // concatenates two balanced ropes, the result is balanced again
+        static NodePtr join(NodePtr left, NodePtr right)
+        {
+            if (!left) {
+                return right;
+            }
+            if (!right) {
+                return left;
+            }
+
+            // avoid fragmentation into tiny leaves
+            if (left->m_height == 0 && right->m_height == 0 && left->m_size + right->m_size <= MaxLeaf) {
+                return makeLeaf(left->m_text + right->m_text);
+            }
+
+            if (left->m_height > right->m_height + 1) {
+                return joinRight(left, std::move(right));
+            }
+            if (right->m_height > left->m_height + 1) {
+                return joinLeft(std::move(left), right);
+            }
+            return makeNode(std::move(left), std::move(right));
+        }
+
+        // splits into [0, pos) and [pos, size), empty parts are nullptr
+        static std::pair<NodePtr, NodePtr> split(NodePtr node, std::size_t pos)
+        {
+            if (!node || pos == 0) {
+                return { nullptr, std::move(node) };
+            }
+            if (pos >= node->m_size) {
+                return { std::move(node), nullptr };
+            }
+
+            if (node->m_height == 0) {
+                std::string_view text{ node->m_text };
+                return { makeLeaf(std::string{ text.substr(0, pos) }), makeLeaf(std::string{ text.substr(pos) }) };
+            }
+
+            const std::size_t leftSize{ node->m_left->m_size };
+            if (pos < leftSize) {
+                auto [left, right] { split(node->m_left, pos) };
+                return { std::move(left), join(std::move(right), node->m_right) };
+            }
+            if (pos > leftSize) {
+                auto [left, right] { split(node->m_right, pos - leftSize) };
+                return { join(node->m_left, std::move(left)), std::move(right) };
+            }
+            return { node->m_left, node->m_right };
+        }
+
+        // path copying, returns nullptr if the text does not fit into the leaf
+        static NodePtr insertIntoLeaf(const NodePtr& node, std::size_t pos, std::string_view text)
+        {
+            if (node->m_height == 0) {
+                if (node->m_size + text.size() > MaxLeaf) {
+                    return nullptr;
+                }
+                std::string copy{ node->m_text };
+                copy.insert(pos, text);
+                return makeLeaf(std::move(copy));
+            }
+
+            const std::size_t leftSize{ node->m_left->m_size };
+            if (pos <= leftSize) {
+                NodePtr left{ insertIntoLeaf(node->m_left, pos, text) };
+                return left ? makeNode(std::move(left), node->m_right) : nullptr;
+            }
+
+            NodePtr right{ insertIntoLeaf(node->m_right, pos - leftSize, text) };
+            return right ? makeNode(node->m_left, std::move(right)) : nullptr;
+        }
+
+        // path copying, returns nullptr if the range is not inside a single leaf or empties it
+        static NodePtr eraseFromLeaf(const NodePtr& node, std::size_t pos, std::size_t count)
+        {
+            if (node->m_height == 0) {
+                if (pos + count > node->m_size || count == node->m_size) {
+                    return nullptr;
+                }
+                std::string copy{ node->m_text };
+                copy.erase(pos, count);
+                return makeLeaf(std::move(copy));
+            }
+
+            const std::size_t leftSize{ node->m_left->m_size };
+            if (pos < leftSize) {
+                NodePtr left{ eraseFromLeaf(node->m_left, pos, count) };
+                return left ? makeNode(std::move(left), node->m_right) : nullptr;
+            }
+
+            NodePtr right{ eraseFromLeaf(node->m_right, pos - leftSize, count) };
+            return right ? makeNode(node->m_left, std::move(right)) : nullptr;
+        }
+
+        template <typename TVisitor>
+        static void visitChunks(const Node& node, TVisitor& visitor)
+        {
+            if (node.m_height == 0) {
+                visitor(std::string_view{ node.m_text });
+                return;
+            }
+            visitChunks(*node.m_left, visitor);
+            visitChunks(*node.m_right, visitor);
+        }
+    };
+
+    class PersistentOriginator;
+
+    /**
+     * Immutable snapshot of a PersistentOriginator. It only holds the root of the
+     * rope, so copying a Memento is cheap and a Memento may be handed over to
+     * other threads as it is.
+     */
+    class Memento
+    {
+    private:
+        friend class PersistentOriginator;
+
+        Rope m_state;
+
+        explicit Memento(Rope state) noexcept : m_state{ std::move(state) } {}
+
+    public:
+        std::size_t size() const noexcept { return m_state.size(); }
+
+        // materializes the state, e.g. for readers in other threads
+        std::string toString() const { return m_state.toString(); }
+    };
+
+    /**
+     * Opt-in alternative to ConceptualExample01::Originator for large states:
+     * save() is O(1), restore() only swaps the root of the rope.
+     */
+    class PersistentOriginator
+    {
+    private:
+        Rope m_state;
+
+    public:
+        explicit PersistentOriginator(std::string_view state) : m_state{ state } {}
+
+        // getter / setter
+        void setState(std::string_view state) { m_state = Rope{ state }; }
+
+        std::string getState() const { return m_state.toString(); }
+
+        std::size_t size() const noexcept { return m_state.size(); }
+
+        // edits, O(log n)
+        void insert(std::size_t pos, std::string_view text) { m_state = m_state.insert(pos, text); }
+
+        void erase(std::size_t pos, std::size_t count) { m_state = m_state.erase(pos, count); }
+
+        // public interface
+        [[nodiscard]]
+        Memento save() const noexcept { return Memento{ m_state }; }
+
+        void restore(const Memento& memento) noexcept { m_state = memento.m_state; }
+
+        // shared nodes of all mementos count once
+        static std::size_t footprint(const std::vector<Memento>& mementos)
+        {
+            std::vector<Rope> ropes{};
+            ropes.reserve(mementos.size());
+            for (const Memento& memento : mementos) {
+                ropes.push_back(memento.m_state);
+            }
+            return Rope::footprint(ropes);
+        }
+    };
+
+    class CareTaker
+    {
+    private:
+        std::vector<Memento> m_history;
+
+    public:
+        void backup(Memento memento) { m_history.push_back(std::move(memento)); }
+
+        const Memento& at(std::size_t index) const { return m_history.at(index); }
+
+        const std::vector<Memento>& history() const noexcept { return m_history; }
+
+        bool empty() const noexcept { return m_history.empty(); }
+
+        std::size_t size() const noexcept { return m_history.size(); }
+    };
+}
+
+void test_persistent_memento()
+{
+    using namespace PersistentMementoExample;
+
+    PersistentOriginator originator{ "Memento Pattern" };
+    CareTaker caretaker{};
+
+    caretaker.backup(originator.save());
+
+    originator.insert(8, "Design ");
+    caretaker.backup(originator.save());
+
+    originator.erase(0, 8);
+    caretaker.backup(originator.save());
+
+    originator.insert(originator.size(), " with persistent state");
+    std::println("{}", originator.getState());
+
+    for (std::size_t i{ caretaker.size() }; i != 0; --i) {
+        originator.restore(caretaker.at(i - 1));
+        std::println("{}", originator.getState());
+    }
+}
+
+namespace PersistentMementoExample {
+
+    // editor-style state: a large text, a snapshot after every edit
+    static void benchmark() {
+
+        constexpr std::size_t StateSize{ 1024 * 1024 };
+        constexpr std::size_t Snapshots{ 20'000 };
+        constexpr std::size_t BaselineSnapshots{ 200 };
+        constexpr std::size_t Readers{ 2 };
+
+        const std::string_view words[]{ "memento ", "originator ", "caretaker ", "state ", "snapshot ", "history ", "undo ", "redo " };
+
+        std::mt19937 engine{ 4711 };
+        std::string text{};
+        while (text.size() < StateSize) {
+            text += words[engine() % std::size(words)];
+        }
+
+        // baseline: deep copy of the state per snapshot
+        double copyMicros{};
+        std::size_t copyBytes{};
+        {
+            std::string state{ text };
+            std::vector<std::string> history{};
+
+            auto start{ std::chrono::high_resolution_clock::now() };
+
+            for (std::size_t i{}; i != BaselineSnapshots; ++i) {
+                const std::size_t pos{ engine() % state.size() };
+                state.insert(pos, words[engine() % std::size(words)]);
+                history.push_back(state);
+            }
+
+            auto end{ std::chrono::high_resolution_clock::now() };
+            copyMicros = std::chrono::duration<double, std::micro>(end - start).count() / BaselineSnapshots;
+            copyBytes = history.back().capacity();
+        }
+
+        PersistentOriginator originator{ text };
+        CareTaker caretaker{};
+        std::string state{ text };
+        std::vector<std::pair<std::size_t, std::string>> expected{};
+        expected.reserve(Snapshots / 1000 + 1);
+
+        // readers verify published snapshots while the originator keeps editing
+        std::vector<Memento> published{};
+        published.reserve(Snapshots / 1000 + 1);
+        std::atomic<std::size_t> publishedCount{};
+        std::atomic<bool> done{};
+        std::atomic<std::size_t> readerChecks{};
+        std::atomic<std::size_t> readerErrors{};
+
+        std::vector<std::jthread> readers{};
+        for (std::size_t i{}; i != Readers; ++i) {
+            readers.emplace_back([&] {
+
+                std::size_t next{};
+                while (true) {
+                    const bool finished{ done.load(std::memory_order_acquire) };
+                    const std::size_t count{ publishedCount.load(std::memory_order_acquire) };
+                    for (; next < count; ++next) {
+                        // snapshots are immutable: no lock needed while reading them
+                        std::string snapshot{ published[next].toString() };
+                        if (snapshot != expected[next].second) {
+                            readerErrors.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        readerChecks.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    if (finished) {
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        auto start{ std::chrono::high_resolution_clock::now() };
+        double editMicros{};
+
+        for (std::size_t i{}; i != Snapshots; ++i) {
+
+            const std::size_t pos{ engine() % originator.size() };
+            const std::string_view word{ words[engine() % std::size(words)] };
+            const bool isInsert{ engine() % 2 == 0 };
+
+            if (isInsert) {
+                originator.insert(pos, word);
+                state.insert(pos, word);
+            }
+            else {
+                originator.erase(pos, 8);
+                state.erase(pos, std::min<std::size_t>(8, state.size() - pos));
+            }
+
+            caretaker.backup(originator.save());
+
+            if (i % 1000 == 0) {
+                // excluded from the timing: copying the reference state is not part of the pattern
+                auto pause{ std::chrono::high_resolution_clock::now() };
+                expected.emplace_back(i, state);
+                published.push_back(caretaker.at(i));
+                publishedCount.store(published.size(), std::memory_order_release);
+                start += std::chrono::high_resolution_clock::now() - pause;
+            }
+        }
+
+        auto end{ std::chrono::high_resolution_clock::now() };
+        editMicros = std::chrono::duration<double, std::micro>(end - start).count() / Snapshots;
+
+        done.store(true, std::memory_order_release);
+        readers.clear();
+
+        // restore: swaps the root only
+        constexpr std::size_t Restores{ 100'000 };
+        start = std::chrono::high_resolution_clock::now();
+        std::size_t checksum{};
+        for (std::size_t i{}; i != Restores; ++i) {
+            originator.restore(caretaker.at(engine() % Snapshots));
+            checksum += originator.size();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        const double restoreNanos{ std::chrono::duration<double, std::nano>(end - start).count() / Restores };
+
+        bool correct{ checksum != 0 };
+        for (const auto& [index, snapshot] : expected) {
+            originator.restore(caretaker.at(index));
+            correct = correct && originator.getState() == snapshot;
+        }
+
+        const std::size_t ropeBytes{ PersistentOriginator::footprint(caretaker.history()) };
+        const std::size_t baseBytes{ PersistentOriginator::footprint({ caretaker.at(0) }) };
+
+        std::println("{} snapshots of a {} KB state:", Snapshots, StateSize / 1024);
+        std::println("  deep copy:  edit + save {:8.1f} us, {:>8} bytes per snapshot", copyMicros, copyBytes);
+        std::println("  persistent: edit + save {:8.1f} us, {:>8} bytes per snapshot, restore {:.1f} ns",
+            editMicros, (ropeBytes - baseBytes) / (Snapshots - 1), restoreNanos);
+        std::println("  all snapshots: {} MB instead of {} MB, snapshots {}",
+            ropeBytes / (1024 * 1024), copyBytes * Snapshots / (1024 * 1024), correct ? "correct" : "WRONG");
+        std::println("  {} readers: {} snapshots checked concurrently, {} errors",
+            Readers, readerChecks.load(), readerErrors.load());
+    }
+}
+
+void benchmark_persistent_memento()
+{
+    PersistentMementoExample::benchmark();
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -5,13 +5,21 @@
 // function prototypes
 extern void test_conceptual_example_01();
 extern void test_conceptual_example_02();
+extern void test_conceptual_example_03();
+extern void benchmark_conceptual_example();
+extern void test_persistent_memento();
+extern void benchmark_persistent_memento();
 extern void test_bank_account_example();
 
 int main()
 {
     test_conceptual_example_01();
     test_conceptual_example_02();
+    test_conceptual_example_03();
+    test_persistent_memento();
     test_bank_account_example();
+    //benchmark_conceptual_example();
+    //benchmark_persistent_memento();
     return 0;
 }
 
@@ -17,9 +17,14 @@
 #endif
 #endif  // _DEBUG
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <print>
+#include <random>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -55,12 +60,51 @@ namespace ConceptualExample_Observer_Pattern_RAII {
      * Connection object. When that Connection is destroyed (goes out of
      * scope, is reset, etc.), the observer is automatically detached.
      * This removes the need for clients to remember to call detach().
+     *
+     * The observers are kept in a slot map: a Connection holds a handle
+     * (slot index + generation), the observers themselves are stored in a
+     * dense array. detach() is O(1) (swap with the last entry), notify()
+     * iterates the dense array, and a stale handle is recognized by its
+     * generation.
+     *
+     * The subscription owns its observer: the Subject holds a strong
+     * reference, which is released together with the Connection. So an
+     * observer stays alive during its update() call - even if it drops the
+     * last client reference to itself or disconnects from within update() -
+     * without a lock() and unlock() per call. Consequently, a Connection must
+     * not be owned by the observer it refers to (that would be a cycle).
      */
 
     class Subject : public ISubject {
+    public:
+        struct Handle
+        {
+            std::uint32_t m_index{ UINT32_MAX };
+            std::uint32_t m_generation{};
+        };
+
     private:
-        std::vector<std::weak_ptr<IObserver>> m_observers;
-        std::string                           m_message;
+        struct Slot
+        {
+            std::uint32_t m_generation{};
+            std::uint32_t m_dense{};        // index into m_entries or next free slot
+        };
+
+        struct Entry
+        {
+            std::shared_ptr<IObserver> m_observer;
+            std::uint32_t              m_slot;
+            bool                       m_detached;  // detached during notify()
+        };
+
+        static constexpr std::uint32_t NoSlot{ UINT32_MAX };
+
+        std::vector<Slot>  m_slots;
+        std::vector<Entry> m_entries;
+        std::uint32_t      m_freeSlot{ NoSlot };
+        bool               m_notifying{ false };
+        bool               m_tombstones{ false };
+        std::string        m_message;
 
     public:
         class Connection
@@ -68,11 +112,9 @@ namespace ConceptualExample_Observer_Pattern_RAII {
         public:
             Connection() = default;
 
-            Connection(Subject* subject, std::weak_ptr<IObserver> observer)
-                : m_subject(subject), m_observer(std::move(observer))
+            Connection(Subject* subject, Handle handle)
+                : m_subject(subject), m_handle(handle)
             {}
-            
-     //       ~Connection() { if (m_subject) m_subject->detach(m_observer); }
 
             ~Connection() {
                 release();
@@ -80,14 +122,12 @@ namespace ConceptualExample_Observer_Pattern_RAII {
             
             // move-only: ownership of "being subscribed" can move,
             // but must not be duplicated (would cause double-detach).
-            //Connection(Connection&&) noexcept = default;
-            //Connection& operator=(Connection&&) noexcept = default;
 
             Connection(const Connection&) = delete;
             Connection& operator=(const Connection&) = delete;
 
             Connection(Connection&& other) noexcept
-                : m_subject(other.m_subject), m_observer(std::move(other.m_observer))
+                : m_subject(other.m_subject), m_handle(other.m_handle)
             {
                 other.m_subject = nullptr;
             }
@@ -96,7 +136,7 @@ namespace ConceptualExample_Observer_Pattern_RAII {
                 if (this != &other) {
                     release();
                     m_subject = other.m_subject;
-                    m_observer = std::move(other.m_observer);
+                    m_handle = other.m_handle;
                     other.m_subject = nullptr;
                 }
                 return *this;
@@ -108,19 +148,19 @@ namespace ConceptualExample_Observer_Pattern_RAII {
             }
 
             [[nodiscard]] bool isConnected() const {
-                return m_subject != nullptr && !m_observer.expired();
+                return m_subject != nullptr && m_subject->isAttached(m_handle);
             }
 
         private:
             void release() {
                 if (m_subject != nullptr) {
-                    m_subject->detach(m_observer);
+                    m_subject->detach(m_handle);
                     m_subject = nullptr;
                 }
             }
 
-            Subject*                 m_subject{ nullptr };
-            std::weak_ptr<IObserver> m_observer;
+            Subject* m_subject{ nullptr };
+            Handle   m_handle;
         };
 
         Subject() = default;
@@ -141,24 +181,66 @@ namespace ConceptualExample_Observer_Pattern_RAII {
          * subscription management methods
          */
 
-
+        // a null observer isn't attached: the Connection is not connected
         [[nodiscard]]
-        Connection attach(std::weak_ptr<IObserver> observer) {
-            m_observers.push_back(observer);
-            return Connection{ this, std::move(observer) };
+        Connection attach(std::shared_ptr<IObserver> observer) {
+
+            if (observer == nullptr) {
+                return Connection{};
+            }
+
+            std::uint32_t index = m_freeSlot;
+            if (index != NoSlot) {
+                m_freeSlot = m_slots[index].m_dense;
+            }
+            else {
+                index = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            m_slots[index].m_dense = static_cast<std::uint32_t>(m_entries.size());
+            m_entries.push_back({ std::move(observer), index, false });
+
+            return Connection{ this, Handle{ index, m_slots[index].m_generation } };
         }
 
-        void detach(const std::weak_ptr<IObserver>& observer) override {
+        // O(1); a stale handle is ignored
+        void detach(Handle handle) {
 
-            // https://stackoverflow.com/questions/10120623/removing-item-from-list-of-weak-ptrs
+            if (!isValid(handle)) {
+                return;
+            }
 
-            // C++20: std::erase_if is the modern and cleanest way to implement the erase-remove pattern.
-            std::erase_if(m_observers, [&observer](const std::weak_ptr<IObserver>& wp) {
-                return sameOwner(wp, observer);
+            Slot& slot = m_slots[handle.m_index];
+            ++slot.m_generation;
+
+            if (m_notifying) {
+                // don't move entries while notify() iterates over them,
+                // the observer is released after the notification
+                m_entries[slot.m_dense].m_detached = true;
+                m_tombstones = true;
+                return;
+            }
+
+            removeEntry(slot.m_dense);
+        }
+
+        void detach(const std::weak_ptr<IObserver>& observer) override {
+
+            for (const Entry& entry : m_entries) {
+                if (!entry.m_detached && sameOwner(entry.m_observer, observer)) {
+                    detach(Handle{ entry.m_slot, m_slots[entry.m_slot].m_generation });
+                    return;
                 }
-            );
+            }
+        }
+
+        [[nodiscard]] bool isAttached(Handle handle) const {
+            return isValid(handle);
         }
 
+        std::size_t size() const { return m_entries.size(); }
+
         void setMessage(std::string_view message) {
             m_message = message;
             notify();
@@ -176,40 +258,56 @@ namespace ConceptualExample_Observer_Pattern_RAII {
         }
 
     private:
-        static bool sameOwner(const std::weak_ptr<IObserver>& lhs, const std::weak_ptr<IObserver>& rhs)
+        bool isValid(Handle handle) const {
+            return handle.m_index < m_slots.size()
+                && m_slots[handle.m_index].m_generation == handle.m_generation;
+        }
+
+        static bool sameOwner(const std::shared_ptr<IObserver>& lhs, const std::weak_ptr<IObserver>& rhs)
         {
             return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
         }
 
+        // swap with the last entry, the moved entry's slot is updated
+        void removeEntry(std::uint32_t dense) {
+
+            std::uint32_t slot = m_entries[dense].m_slot;
+
+            if (dense != m_entries.size() - 1) {
+                m_entries[dense] = std::move(m_entries.back());
+                m_slots[m_entries[dense].m_slot].m_dense = dense;
+            }
+            m_entries.pop_back();
+
+            m_slots[slot].m_dense = m_freeSlot;
+            m_freeSlot = slot;
+        }
+
         void notify() {
 
-            // clean up expired weak pointers while notifying active observers
-            std::erase_if(
-                m_observers,
-                [this](const std::weak_ptr<IObserver>& wp) {
-                    if (auto sharedPtr = wp.lock()) {
-                        sharedPtr->update(m_message);
-                        return false; // keep, as actively notified.
+            // observers attached by update() are notified next time
+            const std::size_t count = m_entries.size();
+
+            m_notifying = true;
+            for (std::size_t i = 0; i != count; ++i) {
+                // update() may attach observers and thus reallocate m_entries,
+                // the entry's reference keeps the observer alive meanwhile
+                if (!m_entries[i].m_detached) {
+                    IObserver* observer = m_entries[i].m_observer.get();
+                    observer->update(m_message);
+                }
+            }
+            m_notifying = false;
+
+            // clean up entries detached during notification
+            if (m_tombstones) {
+                m_tombstones = false;
+                for (std::size_t i = m_entries.size(); i-- != 0; ) {
+                    if (m_entries[i].m_detached) {
+                        removeEntry(static_cast<std::uint32_t>(i));
                     }
-                    return true; // remove, because expired
                 }
-            );
-
-            //// 1) clean up expired weak pointers first
-            //std::erase_if(m_observers, [](const std::weak_ptr<IObserver>& wp) {
-            //    return wp.expired();
-            //    }
-            //);
-
-            //// 2) notify on a snapshot copy, so that re-entrant attach()/detach()
-            ////    calls from within an observer's update() don't invalidate
-            ////    the vector we're currently iterating over.
-            //auto snapshot = m_observers;
-            //for (const auto& wp : snapshot) {
-            //    if (auto sharedPtr = wp.lock()) {
-            //        sharedPtr->update(m_message);
-            //    }
-            //}
+            }
         }
     };
 
@@ -269,6 +367,18 @@ namespace ConceptualExample_Observer_Pattern_RAII {
         
          // no more observers attached at this point
         subject.setMessage("Nobody is listening anymore");
+
+        // the subscription keeps its observer alive:
+        // it is released together with the connection
+        auto connection4 = subject.attach(observer1);
+        observer1.reset();
+        subject.setMessage("Still listening");
+        std::println("connected after last client reference is gone: {}", connection4.isConnected());
+        connection4.disconnect();
+
+        // a null observer isn't attached at all
+        auto connection5 = subject.attach(observer1);
+        std::println("connected to null observer: {}, observers: {}", connection5.isConnected(), subject.size());
     }
 
 
@@ -300,6 +410,114 @@ namespace ConceptualExample_Observer_Pattern_RAII {
         // remaining connections are cleaned up automatically
         // when 'connections' goes out of scope.
     }
+
+    // ===========================================================================
+    // Benchmark: the former registry (std::vector<std::weak_ptr<IObserver>>,
+    // lock() per call, linear detach) versus the slot map above
+
+    class WeakPtrSubject {
+    private:
+        std::vector<std::weak_ptr<IObserver>> m_observers;
+
+    public:
+        void attach(std::weak_ptr<IObserver> observer) {
+            m_observers.push_back(std::move(observer));
+        }
+
+        void detach(const std::weak_ptr<IObserver>& observer) {
+            std::erase_if(m_observers, [&observer](const std::weak_ptr<IObserver>& wp) {
+                return !wp.owner_before(observer) && !observer.owner_before(wp);
+                }
+            );
+        }
+
+        void notify(std::string_view message) {
+            std::erase_if(
+                m_observers,
+                [message](const std::weak_ptr<IObserver>& wp) {
+                    if (auto sharedPtr = wp.lock()) {
+                        sharedPtr->update(message);
+                        return false;
+                    }
+                    return true;
+                }
+            );
+        }
+    };
+
+    class CountingObserver final : public IObserver {
+    public:
+        std::size_t m_count{};
+
+        void update(std::string_view) override { ++m_count; }
+    };
+
+    template <typename Function>
+    static void measure(std::string_view name, Function function)
+    {
+        const auto start{ std::chrono::steady_clock::now() };
+        function();
+        const auto end{ std::chrono::steady_clock::now() };
+
+        std::println("{:<40} {:>6} msecs", name,
+            std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    }
+
+    static void benchmark() {
+
+        constexpr std::size_t Observers{ 5'000 };
+        constexpr std::size_t Notifications{ 5'000 };
+
+        std::vector<std::shared_ptr<IObserver>> observers;
+        for (std::size_t i = 0; i < Observers; ++i) {
+            observers.push_back(std::make_shared<CountingObserver>());
+        }
+
+        std::vector<std::size_t> order(Observers);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937{ 4711 });
+
+        std::println("{} observers, {} notifications:", Observers, Notifications);
+
+        {
+            WeakPtrSubject subject;
+            for (const auto& observer : observers) {
+                subject.attach(observer);
+            }
+
+            measure("weak_ptr vector: notify", [&]() {
+                for (std::size_t i = 0; i < Notifications; ++i) {
+                    subject.notify("message");
+                }
+            });
+
+            measure("weak_ptr vector: detach all", [&]() {
+                for (std::size_t index : order) {
+                    subject.detach(observers[index]);
+                }
+            });
+        }
+
+        {
+            Subject subject;
+            std::vector<Subject::Connection> connections;
+            for (const auto& observer : observers) {
+                connections.push_back(subject.attach(observer));
+            }
+
+            measure("slot map: notify", [&]() {
+                for (std::size_t i = 0; i < Notifications; ++i) {
+                    subject.setMessage("message");
+                }
+            });
+
+            measure("slot map: detach all", [&]() {
+                for (std::size_t index : order) {
+                    connections[index].disconnect();
+                }
+            });
+        }
+    }
 }
 
 // ===========================================================================
@@ -318,6 +536,13 @@ void test_conceptual_example_02()
     clientCode_ManagedConnections();
 }
 
+void benchmark_conceptual_example_02()
+{
+    using namespace ConceptualExample_Observer_Pattern_RAII;
+
+    benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -0,0 +1,667 @@
+// ===========================================================================
+// ConceptualExample05.cpp // Observer // Variant 5 // Concurrent Event Bus
+// ===========================================================================
+
+/**
+ * Observer Design Pattern
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+    Ein Event Bus auf Basis der std::function-Variante (siehe Variant 4),
+    der von mehreren Threads gleichzeitig benutzt werden kann:
+
+    Copy-on-Write: attach() und detach() erzeugen eine neue, unveränderliche
+    Liste der Subscriptions und veröffentlichen sie atomar. notify() liest
+    die jeweils aktuelle Liste, ohne eine Sperre anzufordern.
+
+    Epoch-based Reclamation: Alte Listen und abgemeldete Subscriptions werden
+    erst freigegeben, wenn kein notify() mehr läuft, das sie sehen konnte.
+
+    Asynchrone Zustellung: Ein Observer kann seine Nachrichten auf einem
+    EventExecutor erhalten. Jeder dieser Observer besitzt eine beschränkte,
+    lock-freie Queue; ist sie voll, wartet der Publisher (Backpressure)
+    oder die Nachricht wird verworfen. Auf einem Executor-Thread, also in
+    einem asynchronen Callback, wird statt zu warten immer verworfen:
+    Der Executor könnte sonst auf sich selbst warten.
+*/
+
+namespace ObserverDesignPattern_StdFunction
+{
+    using Callback = std::move_only_function<void(std::string_view) const>;
+
+    using Message = std::shared_ptr<const std::string>;
+
+    // Block: the publisher waits until the observer has caught up,
+    //        except on an executor thread (see EventBus::notify())
+    // Drop:  the message is dropped and counted
+    enum class Backpressure { Block, Drop };
+
+    /**
+     * Bounded lock-free queue (ring buffer with a sequence number per cell).
+     * Usually there is one publisher, so it's used as SPSC queue,
+     * but notify() may be called from several threads at the same time:
+     * therefore the producer side tolerates multiple producers.
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> m_sequence;
+            T m_value;
+        };
+
+        std::size_t m_mask;
+        std::unique_ptr<Cell[]> m_cells;
+        alignas(64) std::atomic<std::size_t> m_enqueuePos{};
+        alignas(64) std::size_t m_dequeuePos{};
+
+    public:
+        explicit BoundedQueue(std::size_t capacity)
+            : m_mask{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 },
+              m_cells{ std::make_unique<Cell[]>(m_mask + 1) }
+        {
+            for (std::size_t i = 0; i <= m_mask; ++i) {
+                m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // returns false, if the queue is full
+        bool push(const T& value)
+        {
+            std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+            while (true) {
+                Cell& cell = m_cells[pos & m_mask];
+                std::size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+                if (diff == 0) {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.m_value = value;
+                        cell.m_sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // consumer only
+        bool pop(T& value)
+        {
+            Cell& cell = m_cells[m_dequeuePos & m_mask];
+
+            if (cell.m_sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+                return false;
+            }
+
+            value = std::move(cell.m_value);
+            cell.m_value = T{};
+            cell.m_sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+            ++m_dequeuePos;
+            return true;
+        }
+
+        // consumer only
+        bool empty() const
+        {
+            return m_cells[m_dequeuePos & m_mask].m_sequence.load() != m_dequeuePos + 1;
+        }
+    };
+
+    class EventExecutor;
+
+    /**
+     * One registered callback. Asynchronous subscriptions are shared
+     * between the bus and the executor and are reference counted.
+     */
+    struct Subscription
+    {
+        Subscription(std::size_t id, Callback callback)
+            : m_id{ id }, m_callback{ std::move(callback) }
+        {}
+
+        std::size_t m_id;
+        Callback m_callback;
+
+        // asynchronous delivery only
+        EventExecutor* m_executor{};
+        std::unique_ptr<BoundedQueue<Message>> m_queue;
+        Backpressure m_backpressure{ Backpressure::Block };
+        std::atomic<bool> m_scheduled{ false };
+        std::atomic<bool> m_detached{ false };
+        std::atomic<std::size_t> m_references{ 1 };
+        std::atomic<std::size_t> m_dropped{};
+        Subscription* m_next{};     // run queue of the executor
+
+        static void release(Subscription* subscription)
+        {
+            if (subscription->m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete subscription;
+            }
+        }
+    };
+
+    /**
+     * Delivers queued messages on a dedicated thread.
+     * Subscriptions with pending messages are pushed onto a lock-free stack,
+     * the executor thread takes all of them at once and drains their queues.
+     */
+    class EventExecutor
+    {
+    private:
+        static constexpr std::size_t BatchSize{ 256 };
+
+        std::atomic<Subscription*> m_ready{ nullptr };
+        std::atomic<std::uint32_t> m_signal{};
+        std::atomic<bool> m_stopping{ false };
+        std::thread m_thread;
+
+    public:
+        EventExecutor() : m_thread{ [this] () { run(); } } {}
+
+        EventExecutor(const EventExecutor&) = delete;
+        EventExecutor& operator= (const EventExecutor&) = delete;
+
+        ~EventExecutor()
+        {
+            m_stopping = true;
+            wakeUp();
+            m_thread.join();
+        }
+
+        // true on the thread of any executor, e.g. within asynchronous callbacks
+        static bool onExecutorThread() { return executorThread(); }
+
+        // called by notify() for a subscription with a new message
+        void schedule(Subscription* subscription)
+        {
+            if (subscription->m_scheduled.exchange(true)) {
+                return;
+            }
+
+            subscription->m_references.fetch_add(1, std::memory_order_relaxed);
+            enqueue(subscription);
+        }
+
+    private:
+        static bool& executorThread()
+        {
+            static thread_local bool executorThread{ false };
+            return executorThread;
+        }
+
+        void enqueue(Subscription* subscription)
+        {
+            Subscription* head = m_ready.load(std::memory_order_relaxed);
+            do {
+                subscription->m_next = head;
+            } while (!m_ready.compare_exchange_weak(head, subscription,
+                std::memory_order_release, std::memory_order_relaxed));
+
+            if (head == nullptr) {
+                wakeUp();
+            }
+        }
+
+        void wakeUp()
+        {
+            m_signal.fetch_add(1);
+            m_signal.notify_one();
+        }
+
+        void run()
+        {
+            executorThread() = true;
+
+            while (true) {
+
+                std::uint32_t signal = m_signal.load();
+                Subscription* ready = m_ready.exchange(nullptr, std::memory_order_acquire);
+
+                if (ready == nullptr) {
+                    if (m_stopping) {
+                        return;
+                    }
+
+                    m_signal.wait(signal);
+                    continue;
+                }
+
+                // stack => restore the order of scheduling
+                Subscription* ordered{ nullptr };
+                while (ready != nullptr) {
+                    Subscription* next = ready->m_next;
+                    ready->m_next = ordered;
+                    ordered = ready;
+                    ready = next;
+                }
+
+                while (ordered != nullptr) {
+                    Subscription* next = ordered->m_next;
+                    deliver(ordered);
+                    ordered = next;
+                }
+            }
+        }
+
+        void deliver(Subscription* subscription)
+        {
+            Message message;
+            std::size_t count{};
+
+            while (count < BatchSize && subscription->m_queue->pop(message)) {
+                if (!subscription->m_detached.load(std::memory_order_relaxed)) {
+                    subscription->m_callback(*message);
+                }
+                ++count;
+            }
+
+            message.reset();
+
+            // a publisher may have pushed a message after the queue was drained
+            subscription->m_scheduled.store(false);
+            if (!subscription->m_queue->empty() && !subscription->m_scheduled.exchange(true)) {
+                enqueue(subscription);
+                return;
+            }
+
+            Subscription::release(subscription);
+        }
+    };
+
+    /**
+     * The subject: notify() may be called from any number of threads,
+     * concurrently with attach() and detach().
+     */
+    class EventBus
+    {
+    private:
+        struct SubscriberList
+        {
+            std::vector<Subscription*> m_subscriptions;
+            bool m_hasAsync{};
+        };
+
+        struct Retired
+        {
+            std::vector<const SubscriberList*> m_lists;
+            std::vector<Subscription*> m_subscriptions;
+        };
+
+        struct alignas(64) ReaderCount
+        {
+            std::atomic<std::size_t> m_count{};
+        };
+
+        static constexpr std::size_t Stripes{ 16 };
+
+        // notify() announces itself in the counter of the current epoch
+        class ReadGuard
+        {
+        private:
+            ReaderCount& m_counter;
+
+        public:
+            explicit ReadGuard(EventBus& bus)
+                : m_counter{ bus.m_readers[bus.m_epoch.load() & 1][stripe()] }
+            {
+                m_counter.m_count.fetch_add(1);
+            }
+
+            ~ReadGuard() { m_counter.m_count.fetch_sub(1); }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator= (const ReadGuard&) = delete;
+
+        private:
+            static std::size_t stripe()
+            {
+                static std::atomic<std::size_t> nextStripe{};
+                static thread_local std::size_t stripe{ nextStripe++ % Stripes };
+                return stripe;
+            }
+        };
+
+        std::atomic<const SubscriberList*> m_list;
+        std::atomic<std::uint64_t> m_epoch{};
+        std::array<std::array<ReaderCount, Stripes>, 2> m_readers{};
+
+        std::mutex m_writer;                // attach() and detach() only
+        std::array<Retired, 2> m_retired;
+        std::size_t m_nextId{};
+
+    public:
+        EventBus() : m_list{ new SubscriberList{} } {}
+
+        EventBus(const EventBus&) = delete;
+        EventBus& operator= (const EventBus&) = delete;
+
+        ~EventBus()
+        {
+            for (Retired& retired : m_retired) {
+                reclaim(retired);
+            }
+
+            const SubscriberList* list = m_list.load();
+            for (Subscription* subscription : list->m_subscriptions) {
+                subscription->m_detached = true;
+                Subscription::release(subscription);
+            }
+            delete list;
+        }
+
+        std::size_t attach(Callback callback)
+        {
+            std::lock_guard guard{ m_writer };
+
+            auto subscription = new Subscription{ m_nextId++, std::move(callback) };
+            publish(subscription, SIZE_MAX);
+            return subscription->m_id;
+        }
+
+        // messages are delivered on 'executor', which must outlive the bus;
+        // the callback of one observer is never called concurrently
+        std::size_t attachAsync(
+            Callback callback,
+            EventExecutor& executor,
+            std::size_t capacity = 1024,
+            Backpressure backpressure = Backpressure::Block)
+        {
+            std::lock_guard guard{ m_writer };
+
+            auto subscription = new Subscription{ m_nextId++, std::move(callback) };
+            subscription->m_executor = &executor;
+            subscription->m_queue = std::make_unique<BoundedQueue<Message>>(capacity);
+            subscription->m_backpressure = backpressure;
+            publish(subscription, SIZE_MAX);
+            return subscription->m_id;
+        }
+
+        bool detach(std::size_t id)
+        {
+            std::lock_guard guard{ m_writer };
+            return publish(nullptr, id);
+        }
+
+        // lock-free: never waits for attach() or detach().
+        // It waits, however, for an asynchronous observer with a full queue and
+        // Backpressure::Block - unless it's called on an executor thread: there,
+        // waiting could livelock the executor (a callback publishing to a queue,
+        // that only its own executor drains), so the message is dropped instead.
+        void notify(std::string_view message)
+        {
+            ReadGuard guard{ *this };
+
+            const SubscriberList* list = m_list.load();
+
+            Message shared;
+            if (list->m_hasAsync) {
+                shared = std::make_shared<const std::string>(message);
+            }
+
+            for (Subscription* subscription : list->m_subscriptions) {
+                if (subscription->m_executor == nullptr) {
+                    subscription->m_callback(message);
+                }
+                else {
+                    post(subscription, shared);
+                }
+            }
+        }
+
+        std::size_t size() const { return m_list.load()->m_subscriptions.size(); }
+
+        // number of messages dropped for an asynchronous observer
+        std::size_t dropped(std::size_t id)
+        {
+            ReadGuard guard{ *this };
+
+            for (Subscription* subscription : m_list.load()->m_subscriptions) {
+                if (subscription->m_id == id) {
+                    return subscription->m_dropped.load();
+                }
+            }
+            return 0;
+        }
+
+    private:
+        static void post(Subscription* subscription, const Message& message)
+        {
+            while (!subscription->m_queue->push(message)) {
+                if (subscription->m_backpressure == Backpressure::Drop
+                    || EventExecutor::onExecutorThread()) {
+                    subscription->m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                // backpressure: the observer must catch up first
+                subscription->m_executor->schedule(subscription);
+                std::this_thread::yield();
+            }
+
+            subscription->m_executor->schedule(subscription);
+        }
+
+        // copy-on-write: builds and publishes a new list, retires the old one
+        bool publish(Subscription* added, std::size_t removedId)
+        {
+            const SubscriberList* current = m_list.load();
+
+            auto list = new SubscriberList{};
+            list->m_subscriptions.reserve(current->m_subscriptions.size() + 1);
+
+            Subscription* removed{ nullptr };
+            for (Subscription* subscription : current->m_subscriptions) {
+                if (subscription->m_id == removedId) {
+                    removed = subscription;
+                }
+                else {
+                    list->m_subscriptions.push_back(subscription);
+                }
+            }
+
+            if (added != nullptr) {
+                list->m_subscriptions.push_back(added);
+            }
+
+            if (added == nullptr && removed == nullptr) {
+                delete list;
+                return false;
+            }
+
+            for (Subscription* subscription : list->m_subscriptions) {
+                list->m_hasAsync = list->m_hasAsync || subscription->m_executor != nullptr;
+            }
+
+            m_list.store(list);
+
+            std::uint64_t epoch = m_epoch.load();
+            Retired& retired = m_retired[epoch & 1];
+            retired.m_lists.push_back(current);
+            if (removed != nullptr) {
+                removed->m_detached = true;
+                retired.m_subscriptions.push_back(removed);
+            }
+
+            // readers of the previous epoch are gone: whatever was retired
+            // back then is unreachable, and the epoch may advance
+            if (readers((epoch + 1) & 1) == 0) {
+                reclaim(m_retired[(epoch + 1) & 1]);
+                m_epoch.store(epoch + 1);
+            }
+
+            return true;
+        }
+
+        std::size_t readers(std::size_t parity) const
+        {
+            std::size_t count{};
+            for (const ReaderCount& reader : m_readers[parity]) {
+                count += reader.m_count.load();
+            }
+            return count;
+        }
+
+        static void reclaim(Retired& retired)
+        {
+            for (const SubscriberList* list : retired.m_lists) {
+                delete list;
+            }
+
+            for (Subscription* subscription : retired.m_subscriptions) {
+                Subscription::release(subscription);
+            }
+
+            retired.m_lists.clear();
+            retired.m_subscriptions.clear();
+        }
+    };
+}
+
+void test_conceptual_example_05() {
+
+    using namespace ObserverDesignPattern_StdFunction;
+
+    EventExecutor executor;
+    EventBus bus;
+
+    std::atomic<std::size_t> syncCount{};
+    std::atomic<std::size_t> asyncCount{};
+
+    auto id1 = bus.attach([&](std::string_view) { ++syncCount; });
+    auto id2 = bus.attachAsync([&](std::string_view) { ++asyncCount; }, executor);
+
+    // two publishers, one thread subscribing and unsubscribing meanwhile
+    std::thread publisher1{ [&] () { for (int i = 0; i < 10000; ++i) bus.notify("Hello"); } };
+    std::thread publisher2{ [&] () { for (int i = 0; i < 10000; ++i) bus.notify("World"); } };
+    std::thread subscriber{ [&] () {
+        for (int i = 0; i < 1000; ++i) {
+            auto id = bus.attach([](std::string_view) {});
+            bus.detach(id);
+        }
+    } };
+
+    publisher1.join();
+    publisher2.join();
+    subscriber.join();
+
+    while (asyncCount < 20000) {
+        std::this_thread::yield();
+    }
+
+    std::println("Synchronous observer: {} messages, asynchronous observer: {} messages",
+        syncCount.load(), asyncCount.load());
+
+    bus.detach(id1);
+    bus.detach(id2);
+
+    // an asynchronous observer publishing on its own bus: on the executor
+    // thread, Backpressure::Block drops instead of waiting for itself
+    std::atomic<bool> echoed{ false };
+    std::atomic<std::size_t> echoCount{};
+
+    auto id3 = bus.attachAsync([&](std::string_view) {
+        ++echoCount;
+        if (!echoed.exchange(true)) {
+            for (int i = 0; i < 8; ++i) {
+                bus.notify("Echo");
+            }
+        }
+    }, executor, 4);
+
+    bus.notify("Hello");
+
+    while (echoCount < 5) {
+        std::this_thread::yield();
+    }
+
+    std::println("Echoing observer: {} messages, {} dropped", echoCount.load(), bus.dropped(id3));
+
+    bus.detach(id3);
+}
+
+void benchmark_conceptual_example_05() {
+
+    using namespace ObserverDesignPattern_StdFunction;
+
+    constexpr std::size_t Deliveries{ 2'000'000 };
+
+    for (std::size_t observers : { 1, 10, 100, 1000 }) {
+
+        const std::size_t messages = Deliveries / observers;
+
+        // synchronous delivery on the publishing thread
+        {
+            EventBus bus;
+            std::vector<std::size_t> counts(observers);
+
+            for (std::size_t i = 0; i < observers; ++i) {
+                bus.attach([count = &counts[i]](std::string_view) { ++*count; });
+            }
+
+            const auto start{ std::chrono::steady_clock::now() };
+            for (std::size_t i = 0; i < messages; ++i) {
+                bus.notify("message");
+            }
+            const auto end{ std::chrono::steady_clock::now() };
+
+            double seconds{ std::chrono::duration<double>(end - start).count() };
+            std::println("{:>5} observers, synchronous:  {:>8} msecs, {:.0f} deliveries/sec",
+                observers, static_cast<long long>(seconds * 1000), messages * observers / seconds);
+        }
+
+        // asynchronous delivery on an executor, with backpressure
+        {
+            EventExecutor executor;
+            EventBus bus;
+            std::atomic<std::size_t> delivered{};
+
+            for (std::size_t i = 0; i < observers; ++i) {
+                bus.attachAsync([&](std::string_view) {
+                    delivered.fetch_add(1, std::memory_order_relaxed);
+                }, executor, 256);
+            }
+
+            const auto start{ std::chrono::steady_clock::now() };
+            for (std::size_t i = 0; i < messages; ++i) {
+                bus.notify("message");
+            }
+            while (delivered.load() < messages * observers) {
+                std::this_thread::yield();
+            }
+            const auto end{ std::chrono::steady_clock::now() };
+
+            double seconds{ std::chrono::duration<double>(end - start).count() };
+            std::println("{:>5} observers, asynchronous: {:>8} msecs, {:.0f} deliveries/sec",
+                observers, static_cast<long long>(seconds * 1000), messages * observers / seconds);
+        }
+    }
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -5,15 +5,21 @@
 // function prototypes
 extern void test_conceptual_example_01();
 extern void test_conceptual_example_02();
+extern void benchmark_conceptual_example_02();
 extern void test_conceptual_example_03();
 extern void test_conceptual_example_04();
+extern void test_conceptual_example_05();
+extern void benchmark_conceptual_example_05();
 
 int main()
 {
     test_conceptual_example_01();
     test_conceptual_example_02();
+    benchmark_conceptual_example_02();
     test_conceptual_example_03();
     test_conceptual_example_04();
+    test_conceptual_example_05();
+    benchmark_conceptual_example_05();
 
     return 0;
 }
@@ -0,0 +1,590 @@
+// ===========================================================================
+// AsyncVirtualProxy.cpp // Proxy Pattern
+// ===========================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace AsyncVirtualProxy {
+
+    struct Image {
+        virtual ~Image() = default;
+        virtual void draw() = 0;
+    };
+
+    /**
+     * Decoded bitmap, shared between the cache and the proxies currently drawing it
+     */
+    class BitmapData
+    {
+    private:
+        std::string               m_filename;
+        std::vector<std::uint8_t> m_pixels;
+
+    public:
+        BitmapData(std::string filename, std::vector<std::uint8_t> pixels)
+            : m_filename{ std::move(filename) }, m_pixels{ std::move(pixels) }
+        {}
+
+        const std::string& filename() const noexcept { return m_filename; }
+
+        std::size_t bytes() const noexcept { return m_pixels.size(); }
+
+        // stands for blitting the bitmap
+        std::uint64_t render() const noexcept
+        {
+            std::uint64_t checksum{};
+            for (std::size_t i{}; i < m_pixels.size(); i += 64) {
+                checksum += m_pixels[i];
+            }
+            return checksum;
+        }
+    };
+
+    using BitmapPtr = std::shared_ptr<const BitmapData>;
+    using BitmapFuture = std::shared_future<BitmapPtr>;
+    using BitmapLoader = std::function<BitmapPtr(const std::string&)>;
+
+    /**
+     * Fixed set of background threads for blocking I/O
+     */
+    class IoThreadPool
+    {
+    private:
+        std::mutex                               m_mutex;
+        std::condition_variable                  m_condition;
+        std::deque<std::move_only_function<void()>> m_tasks;
+        bool                                     m_shutdown;
+        std::vector<std::thread>                 m_workers;
+
+    public:
+        explicit IoThreadPool(std::size_t threads) : m_shutdown{ false }
+        {
+            for (std::size_t i{}; i != threads; ++i) {
+                m_workers.emplace_back([this]() { run(); });
+            }
+        }
+
+        // pending tasks are discarded, their futures report a broken promise
+        ~IoThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> guard{ m_mutex };
+                m_shutdown = true;
+            }
+
+            m_condition.notify_all();
+
+            for (auto& worker : m_workers) {
+                worker.join();
+            }
+        }
+
+        IoThreadPool(const IoThreadPool&) = delete;
+        IoThreadPool& operator=(const IoThreadPool&) = delete;
+
+        void submit(std::move_only_function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> guard{ m_mutex };
+                m_tasks.push_back(std::move(task));
+            }
+
+            m_condition.notify_one();
+        }
+
+    private:
+        void run()
+        {
+            while (true) {
+
+                std::move_only_function<void()> task{};
+
+                {
+                    std::unique_lock<std::mutex> guard{ m_mutex };
+                    m_condition.wait(guard, [this]() { return m_shutdown || !m_tasks.empty(); });
+
+                    if (m_shutdown) {
+                        return;
+                    }
+
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+
+                task();
+            }
+        }
+    };
+
+    struct BitmapCacheStatistics
+    {
+        std::size_t m_hits{};
+        std::size_t m_misses{};
+        std::size_t m_prefetches{};
+        std::size_t m_evictions{};
+        std::size_t m_bytes{};
+    };
+
+    /**
+     * Shared cache of bitmaps, bounded by the total size of the loaded bitmaps.
+     *
+     * Bitmaps are loaded asynchronously on an I/O thread pool owned by the cache.
+     * Least recently used bitmaps are evicted when the budget is exceeded; bitmaps
+     * which are pinned or still loading are never evicted. An evicted bitmap stays
+     * alive as long as a proxy is drawing it.
+     */
+    class BitmapCache
+    {
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(std::string_view sv) const noexcept {
+                return std::hash<std::string_view>{}(sv);
+            }
+        };
+
+        using LruList = std::list<const std::string*>;      // most recently used first
+
+        struct Entry
+        {
+            BitmapFuture      m_future;
+            std::size_t       m_bytes{};
+            std::size_t       m_pins{};
+            bool              m_loaded{};
+            LruList::iterator m_lru;
+        };
+
+        mutable std::mutex    m_mutex;
+        std::unordered_map<std::string, Entry, StringHash, std::equal_to<>> m_entries;
+        LruList               m_lru;
+        std::size_t           m_capacity;
+        BitmapCacheStatistics m_statistics;
+        BitmapLoader          m_loader;
+        IoThreadPool          m_pool;       // last member: workers are joined before the cache dies
+
+    public:
+        BitmapCache(BitmapLoader loader, std::size_t capacityInBytes, std::size_t ioThreads = 2)
+            : m_capacity{ capacityInBytes }, m_statistics{}, m_loader{ std::move(loader) }, m_pool{ ioThreads }
+        {}
+
+        // returns the future of a bitmap, starts loading it if necessary
+        BitmapFuture request(std::string_view filename)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            return lookup(filename, false).m_future;
+        }
+
+        // hint: the bitmap will be needed soon
+        void prefetch(std::string_view filename)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            lookup(filename, true);
+        }
+
+        // returns the bitmap if it is already loaded, nullptr otherwise (starting the load)
+        BitmapPtr tryGet(std::string_view filename)
+        {
+            BitmapFuture future{ request(filename) };
+
+            if (future.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready) {
+                return nullptr;
+            }
+
+            try {
+                return future.get();
+            }
+            catch (const std::exception&) {
+                return nullptr;
+            }
+        }
+
+        void pin(std::string_view filename)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            ++lookup(filename, true).m_pins;
+        }
+
+        void unpin(std::string_view filename)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+
+            auto pos{ m_entries.find(filename) };
+            if (pos != m_entries.end() && pos->second.m_pins != 0) {
+                --pos->second.m_pins;
+                evict();
+            }
+        }
+
+        BitmapCacheStatistics statistics() const
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            return m_statistics;
+        }
+
+    private:
+        // expects m_mutex to be locked
+        Entry& lookup(std::string_view filename, bool prefetch)
+        {
+            if (auto pos{ m_entries.find(filename) }; pos != m_entries.end()) {
+
+                m_lru.splice(m_lru.begin(), m_lru, pos->second.m_lru);
+                if (!prefetch) {
+                    ++m_statistics.m_hits;
+                }
+                return pos->second;
+            }
+
+            if (prefetch) {
+                ++m_statistics.m_prefetches;
+            }
+            else {
+                ++m_statistics.m_misses;
+            }
+
+            auto [pos, inserted] { m_entries.try_emplace(std::string{ filename }) };
+            m_lru.push_front(&pos->first);
+
+            Entry& entry{ pos->second };
+            entry.m_lru = m_lru.begin();
+
+            std::promise<BitmapPtr> promise{};
+            entry.m_future = promise.get_future().share();
+
+            m_pool.submit([this, key = pos->first, promise = std::move(promise)]() mutable {
+
+                try {
+                    BitmapPtr bitmap{ m_loader(key) };
+                    loaded(key, bitmap);
+                    promise.set_value(std::move(bitmap));
+                }
+                catch (...) {
+                    loaded(key, nullptr);
+                    promise.set_exception(std::current_exception());
+                }
+            });
+
+            return entry;
+        }
+
+        void loaded(const std::string& filename, const BitmapPtr& bitmap)
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+
+            auto pos{ m_entries.find(filename) };
+
+            if (bitmap == nullptr) {
+                // failed loads are not cached, the next request tries again
+                m_lru.erase(pos->second.m_lru);
+                m_entries.erase(pos);
+                return;
+            }
+
+            pos->second.m_loaded = true;
+            pos->second.m_bytes = bitmap->bytes();
+            m_statistics.m_bytes += bitmap->bytes();
+
+            evict();
+        }
+
+        // expects m_mutex to be locked
+        void evict()
+        {
+            for (auto lru{ m_lru.end() }; m_statistics.m_bytes > m_capacity && lru != m_lru.begin(); ) {
+
+                --lru;
+                auto pos{ m_entries.find(**lru) };
+                Entry& entry{ pos->second };
+
+                if (!entry.m_loaded || entry.m_pins != 0) {
+                    continue;
+                }
+
+                m_statistics.m_bytes -= entry.m_bytes;
+                ++m_statistics.m_evictions;
+
+                lru = m_lru.erase(lru);
+                m_entries.erase(pos);
+            }
+        }
+    };
+
+    enum class DrawPolicy { Block, Placeholder };
+
+    /**
+     * Virtual proxy of a bitmap: the real bitmap is loaded in the background and
+     * kept in a shared BitmapCache. draw() either waits for its own bitmap only
+     * or draws a placeholder while the bitmap is still loading.
+     */
+    class AsyncLazyBitmap : public Image
+    {
+    private:
+        std::string  m_filename;
+        BitmapCache& m_cache;
+        DrawPolicy   m_policy;
+
+    public:
+        AsyncLazyBitmap(const std::string& filename, BitmapCache& cache, DrawPolicy policy = DrawPolicy::Block)
+            : m_filename{ filename }, m_cache{ cache }, m_policy{ policy }
+        {}
+
+        void prefetch() { m_cache.prefetch(m_filename); }
+        void pin() { m_cache.pin(m_filename); }
+        void unpin() { m_cache.unpin(m_filename); }
+
+        void draw() override
+        {
+            std::uint64_t checksum{};
+            if (render(checksum)) {
+                std::println("drawing image {}", m_filename);
+            }
+            else {
+                std::println("drawing placeholder for image {}", m_filename);
+            }
+        }
+
+        // returns false if the placeholder has been drawn: the bitmap
+        // isn't loaded yet (Placeholder only) or couldn't be loaded
+        bool render(std::uint64_t& checksum)
+        {
+            BitmapPtr bitmap{};
+
+            if (m_policy == DrawPolicy::Block) {
+                try {
+                    bitmap = m_cache.request(m_filename).get();
+                }
+                catch (const std::exception&) {
+                    // missing or unreadable file: the placeholder is drawn
+                    bitmap = nullptr;
+                }
+            }
+            else {
+                bitmap = m_cache.tryGet(m_filename);
+            }
+
+            if (bitmap == nullptr) {
+                return false;
+            }
+
+            checksum += bitmap->render();
+            return true;
+        }
+    };
+
+    // ---------------------------------------------------------------------------
+    // loader reading the bitmap from a file, decoding is simulated by hashing the content
+
+    static BitmapPtr loadBitmapFromFile(const std::string& filename)
+    {
+        std::ifstream file{ filename, std::ios::binary };
+        if (!file) {
+            throw std::runtime_error{ "cannot open " + filename };
+        }
+
+        std::vector<std::uint8_t> pixels(
+            (std::istreambuf_iterator<char>{ file }),
+            std::istreambuf_iterator<char>{}
+        );
+
+        std::uint32_t state{ 2166136261u };
+        for (int pass{}; pass != 4; ++pass) {
+            for (std::uint8_t& pixel : pixels) {
+                state = (state ^ pixel) * 16777619u;
+                pixel = static_cast<std::uint8_t>(pixel ^ (state & 1));
+            }
+        }
+
+        return std::make_shared<const BitmapData>(filename, std::move(pixels));
+    }
+
+    static void test()
+    {
+        std::filesystem::path directory{ std::filesystem::temp_directory_path() / "async_virtual_proxy_test" };
+        std::filesystem::create_directories(directory);
+
+        std::vector<std::string> filenames{};
+        for (int i{ 1 }; i <= 3; ++i) {
+            std::filesystem::path path{ directory / ("image_" + std::to_string(i) + ".bmp") };
+            std::ofstream{ path, std::ios::binary } << std::string(4096, static_cast<char>(i));
+            filenames.push_back(path.string());
+        }
+
+        BitmapCache cache{ loadBitmapFromFile, 2 * 4096 };
+
+        AsyncLazyBitmap img_1{ filenames[0], cache, DrawPolicy::Placeholder };
+        AsyncLazyBitmap img_2{ filenames[1], cache, DrawPolicy::Block };
+        AsyncLazyBitmap img_3{ filenames[2], cache, DrawPolicy::Block };
+
+        img_1.draw();       // placeholder, unless the I/O thread has been very fast
+        img_2.prefetch();
+        img_2.pin();
+        img_2.draw();
+        img_3.draw();       // exceeds the budget: img_1 is evicted, img_2 is pinned
+        img_2.unpin();
+
+        AsyncLazyBitmap missing{ (directory / "missing.bmp").string(), cache, DrawPolicy::Block };
+        missing.draw();     // loading fails: placeholder
+
+        BitmapCacheStatistics statistics{ cache.statistics() };
+        std::println("Hits: {}, Misses: {}, Prefetches: {}, Evictions: {}, Bytes: {}",
+            statistics.m_hits, statistics.m_misses, statistics.m_prefetches,
+            statistics.m_evictions, statistics.m_bytes);
+
+        std::filesystem::remove_all(directory);
+    }
+
+    // ---------------------------------------------------------------------------
+    // benchmark: scrolling through a gallery of images
+
+    struct Latencies
+    {
+        std::vector<double> m_frames;       // microseconds
+
+        double percentile(double p)
+        {
+            std::sort(m_frames.begin(), m_frames.end());
+            return m_frames[static_cast<std::size_t>(p * (m_frames.size() - 1))];
+        }
+    };
+
+    static void printLatencies(std::string_view title, Latencies& latencies, std::size_t placeholders)
+    {
+        std::println("  {:<28} p50 {:>8.1f} us, p99 {:>8.1f} us, max {:>9.1f} us, placeholders {}",
+            title, latencies.percentile(0.5), latencies.percentile(0.99), latencies.percentile(1.0), placeholders);
+    }
+
+    static void benchmark()
+    {
+        constexpr std::size_t ImageCount{ 2000 };
+        constexpr std::size_t ImageSize{ 32 * 1024 };
+        constexpr std::size_t Visible{ 12 };        // images on screen per frame
+        constexpr std::size_t Lookahead{ 24 };      // prefetch hint for the next images
+        constexpr std::size_t CacheBudget{ 128 * ImageSize };
+
+        std::filesystem::path directory{ std::filesystem::temp_directory_path() / "async_virtual_proxy_benchmark" };
+        std::filesystem::create_directories(directory);
+
+        std::vector<std::string> filenames{};
+        std::string content(ImageSize, '\0');
+        for (std::size_t i{}; i != ImageCount; ++i) {
+            for (std::size_t k{}; k != content.size(); ++k) {
+                content[k] = static_cast<char>((i * 131 + k * 7) & 0xFF);
+            }
+            std::filesystem::path path{ directory / ("image_" + std::to_string(i) + ".bmp") };
+            std::ofstream{ path, std::ios::binary } << content;
+            filenames.push_back(path.string());
+        }
+
+        auto idle = []() {
+            // remaining time of the frame, the I/O threads may work now
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        };
+
+        std::println("Scrolling through {} images of {} KB, {} visible, cache budget {} images:",
+            ImageCount, ImageSize / 1024, Visible, CacheBudget / ImageSize);
+
+        // LazyBitmap: synchronous load on the first draw, nothing is ever evicted
+        {
+            std::vector<BitmapPtr> bitmaps(ImageCount);
+            Latencies latencies{};
+            std::uint64_t checksum{};
+
+            for (std::size_t first{}; first + Visible <= ImageCount; ++first) {
+
+                const auto start{ std::chrono::high_resolution_clock::now() };
+                for (std::size_t i{ first }; i != first + Visible; ++i) {
+                    if (bitmaps[i] == nullptr) {
+                        bitmaps[i] = loadBitmapFromFile(filenames[i]);
+                    }
+                    checksum += bitmaps[i]->render();
+                }
+                const auto end{ std::chrono::high_resolution_clock::now() };
+
+                latencies.m_frames.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+                idle();
+            }
+
+            printLatencies("LazyBitmap (synchronous):", latencies, 0);
+            std::println("  {:<28} {} MB resident", "", ImageCount * ImageSize / (1024 * 1024));
+        }
+
+        for (DrawPolicy policy : { DrawPolicy::Block, DrawPolicy::Placeholder }) {
+
+            BitmapCache cache{ loadBitmapFromFile, CacheBudget };
+
+            std::vector<AsyncLazyBitmap> images{};
+            images.reserve(ImageCount);
+            for (const std::string& filename : filenames) {
+                images.emplace_back(filename, cache, policy);
+            }
+
+            Latencies latencies{};
+            std::uint64_t checksum{};
+            std::size_t placeholders{};
+
+            for (std::size_t first{}; first + Visible <= ImageCount; ++first) {
+
+                const auto start{ std::chrono::high_resolution_clock::now() };
+                for (std::size_t i{ first }; i != first + Visible; ++i) {
+                    if (!images[i].render(checksum)) {
+                        ++placeholders;
+                    }
+                }
+                const auto end{ std::chrono::high_resolution_clock::now() };
+
+                latencies.m_frames.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+                for (std::size_t i{ first + Visible }; i < std::min(first + Visible + Lookahead, ImageCount); ++i) {
+                    images[i].prefetch();
+                }
+
+                idle();
+            }
+
+            BitmapCacheStatistics statistics{ cache.statistics() };
+
+            printLatencies(policy == DrawPolicy::Block ? "Prefetching, blocking:" : "Prefetching, placeholder:",
+                latencies, placeholders);
+            std::println("  {:<28} {} MB resident, hits {}, misses {}, prefetches {}, evictions {}", "",
+                statistics.m_bytes / (1024 * 1024), statistics.m_hits, statistics.m_misses,
+                statistics.m_prefetches, statistics.m_evictions);
+        }
+
+        std::filesystem::remove_all(directory);
+    }
+}
+
+void test_async_virtual_proxy()
+{
+    AsyncVirtualProxy::test();
+}
+
+void benchmark_async_virtual_proxy()
+{
+    AsyncVirtualProxy::benchmark();
+}
+
+// ===========================================================================
+// End-of-File
+// ===========================================================================
@@ -6,12 +6,16 @@
 extern void test_conceptual_example();
 extern void test_property_proxy();
 extern void test_virtual_proxy();
+extern void test_async_virtual_proxy();
+extern void benchmark_async_virtual_proxy();
 
 int main()
 {
     test_conceptual_example();
     test_property_proxy();
     test_virtual_proxy();
+    test_async_virtual_proxy();
+    //benchmark_async_virtual_proxy();     // writes 64 MB of temporary files
     return 0;
 }
 
@@ -2,9 +2,15 @@
 // ConceptualExample02.cpp
 // ===========================================================================
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 namespace ConceptualExample02 {
 
@@ -24,7 +30,7 @@ namespace ConceptualExample02 {
          * operator.
          */
     private:
-        static Singleton* m_instance;
+        static std::atomic<Singleton*> m_instance;
         static std::mutex m_mutex;
 
     protected:
@@ -67,7 +73,7 @@ namespace ConceptualExample02 {
         }
     };
 
-    Singleton* Singleton::m_instance{ nullptr };
+    std::atomic<Singleton*> Singleton::m_instance{ nullptr };
     std::mutex Singleton::m_mutex{};
 
     /**
@@ -77,30 +83,205 @@ namespace ConceptualExample02 {
     // simple implementation
     Singleton* Singleton::getInstance(const std::string& value)
     {
-        if (m_instance == nullptr) {
-            m_instance = new Singleton{ value };
+        if (m_instance.load() == nullptr) {
+            m_instance.store(new Singleton{ value });     // <=== NOTE: not thread-safe, two threads may both create an instance
         }
 
-        return m_instance;
+        return m_instance.load();
     }
 
     /**
      * The first time we call getInstanceEx we will lock the storage location
      * and then we make sure again that the variable is null and then we
      * set the value.
+     *
+     * The instance pointer is published with release semantics and read with
+     * acquire semantics: a thread which sees the pointer also sees the completely
+     * constructed object. Once created, the access path is a single atomic load.
      */
     Singleton* Singleton::getInstanceEx(const std::string& value)
     {
-        if (m_instance == nullptr)
+        Singleton* instance{ m_instance.load(std::memory_order_acquire) };
+
+        if (instance == nullptr)
         {
             std::lock_guard<std::mutex> lock{ m_mutex };
-            if (m_instance == nullptr)  // <=== NOTE: double-check of m_instance being nullptr
+            instance = m_instance.load(std::memory_order_relaxed);
+            if (instance == nullptr)  // <=== NOTE: double-check of m_instance being nullptr
             {
-                m_instance = new Singleton{ value };
+                instance = new Singleton{ value };
+                m_instance.store(instance, std::memory_order_release);
+            }
+        }
+
+        return instance;
+    }
+}
+
+namespace SingletonAccess {
+
+    /**
+     * Thread-safe access variants for a singleton type T.
+     * T must be default constructible, a private c'tor can be opened with
+     *
+     *     template <typename> friend class ...Access;
+     *
+     * After the instance has been created, all variants are wait-free:
+     * the access path consists of a single (acquire) load.
+     */
+
+    // C++11 "magic statics": the compiler generates the thread-safe initialization
+    template <typename T>
+    class MeyersAccess
+    {
+    public:
+        static T& instance()
+        {
+            static T s_instance{};
+            return s_instance;
+        }
+    };
+
+    // std::call_once: the initialization function runs exactly once
+    template <typename T>
+    class CallOnceAccess
+    {
+    private:
+        static inline std::once_flag s_flag{};
+        static inline T* s_instance{ nullptr };
+
+    public:
+        static T& instance()
+        {
+            std::call_once(s_flag, []() { s_instance = new T{}; });
+            return *s_instance;
+        }
+    };
+
+    // double-checked locking with acquire/release ordering
+    template <typename T>
+    class AtomicAccess
+    {
+    private:
+        static inline std::atomic<T*> s_instance{ nullptr };
+        static inline std::mutex s_mutex{};
+
+    public:
+        static T& instance()
+        {
+            T* instance{ s_instance.load(std::memory_order_acquire) };
+
+            if (instance == nullptr) {
+                std::lock_guard<std::mutex> lock{ s_mutex };
+                instance = s_instance.load(std::memory_order_relaxed);
+                if (instance == nullptr) {
+                    instance = new T{};
+                    s_instance.store(instance, std::memory_order_release);
+                }
+            }
+
+            return *instance;
+        }
+    };
+
+    // every thread caches the pointer delivered by another access variant
+    template <typename T, template <typename> class TAccess = AtomicAccess>
+    class ThreadCachedAccess
+    {
+    public:
+        static T& instance()
+        {
+            thread_local T* t_instance{ nullptr };
+
+            if (t_instance == nullptr) {
+                t_instance = &TAccess<T>::instance();
             }
+
+            return *t_instance;
+        }
+    };
+
+    // a registry as it is looked up on every request
+    class Registry
+    {
+    private:
+        std::size_t m_id;
+
+        Registry() : m_id{ 123 } {}
+
+        template <typename> friend class MeyersAccess;
+        template <typename> friend class CallOnceAccess;
+        template <typename> friend class AtomicAccess;
+
+    public:
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        std::size_t id() const noexcept { return m_id; }
+    };
+
+    template <typename TAccess>
+    static double lookupsPerSecond(std::size_t threadCount, std::size_t lookupsPerThread)
+    {
+        std::vector<std::thread> threads{};
+        std::vector<std::size_t> sums(threadCount);
+        std::atomic<bool> go{ false };
+
+        for (std::size_t t{}; t != threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                std::size_t sum{};
+                for (std::size_t i{}; i != lookupsPerThread; ++i) {
+                    sum += TAccess::instance().id();
+                    std::atomic_signal_fence(std::memory_order_seq_cst);    // keeps the lookup inside the loop
+                }
+                sums[t] = sum;
+            });
         }
 
-        return m_instance;
+        const auto start{ std::chrono::steady_clock::now() };
+        go.store(true, std::memory_order_release);
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const auto end{ std::chrono::steady_clock::now() };
+
+        for (std::size_t sum : sums) {
+            if (sum != lookupsPerThread * 123) {
+                std::cout << "Wrong instance detected!" << std::endl;
+            }
+        }
+
+        const double seconds{ std::chrono::duration<double>(end - start).count() };
+        return static_cast<double>(threadCount * lookupsPerThread) / seconds;
+    }
+
+    static void benchmark()
+    {
+        constexpr std::size_t LookupsPerThread{ 5'000'000 };
+
+        std::cout << "Million lookups per second:" << std::endl;
+        std::cout << "Threads    Meyers  CallOnce    Atomic  Cached" << std::endl;
+
+        for (std::size_t threads : { 1, 2, 4, 8, 16, 32, 64 }) {
+
+            double meyers{ lookupsPerSecond<MeyersAccess<Registry>>(threads, LookupsPerThread) };
+            double callOnce{ lookupsPerSecond<CallOnceAccess<Registry>>(threads, LookupsPerThread) };
+            double atomic{ lookupsPerSecond<AtomicAccess<Registry>>(threads, LookupsPerThread) };
+            double cached{ lookupsPerSecond<ThreadCachedAccess<Registry>>(threads, LookupsPerThread) };
+
+            std::cout << std::fixed << std::setprecision(1)
+                << std::setw(7) << threads
+                << std::setw(10) << meyers / 1e6
+                << std::setw(10) << callOnce / 1e6
+                << std::setw(10) << atomic / 1e6
+                << std::setw(8) << cached / 1e6 << std::endl;
+        }
     }
 }
 
@@ -124,6 +305,11 @@ void test_singleton_03()
     std::cout << singleton4->value() << std::endl;
 }
 
+void benchmark_singleton_access()
+{
+    SingletonAccess::benchmark();
+}
+
 // ===========================================================================
 // End-of-File
 // ===========================================================================
@@ -7,6 +7,7 @@ extern void test_singleton_01();
 extern void test_singleton_02();
 extern void test_singleton_03();
 extern void test_singleton_vs_di();
+extern void benchmark_singleton_access();
 
 int main()
 {
@@ -14,6 +15,7 @@ int main()
     test_singleton_02();
     test_singleton_03();
     test_singleton_vs_di();
+    benchmark_singleton_access();
     return 0;
 }
 
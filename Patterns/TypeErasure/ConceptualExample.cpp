@@ -3,9 +3,18 @@
 // ===========================================================================
 
 #include <iostream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 namespace ConceptualExample
 {
@@ -484,6 +493,577 @@ namespace ConceptualExample
             animals.print();
         }
     }
+
+    namespace Motivation08
+    {
+        class Cow
+        {
+        public:
+            std::string see() const { return "cow"; }
+            std::string say() const { return "moo"; }
+        };
+
+        class Pig
+        {
+        public:
+            std::string see() const { return "pig"; }
+            std::string say() const { return "oink"; }
+        };
+
+        class Dog
+        {
+        public:
+            std::string see() const { return "dog"; }
+            std::string say() const { return "woof"; }
+        };
+
+        // too large for the inline buffer: stored on the heap
+        class Parrot
+        {
+        private:
+            std::string m_word;
+
+        public:
+            Parrot(std::string word) : m_word{ std::move(word) } {}
+
+            std::string see() const { return "parrot"; }
+            std::string say() const { return m_word; }
+
+            void learn(std::string word) { m_word = std::move(word); }
+        };
+
+        // 'manual vtable': one function pointer per operation of the interface;
+        // stored inline in every erased object, no virtual base class
+        struct AnimalVTable
+        {
+            std::string (*see)(const void*);
+            std::string (*say)(const void*);
+
+            template <typename T>
+                requires requires (const T& animal) { animal.see(); animal.say(); }
+            static constexpr AnimalVTable create()
+            {
+                return {
+                    [](const void* animal) { return static_cast<const T*>(animal)->see(); },
+                    [](const void* animal) { return static_cast<const T*>(animal)->say(); }
+                };
+            }
+        };
+
+        // types, for which 'VTable' can provide the operations
+        template <typename T, typename VTable>
+        concept Erasable = requires { VTable::template create<T>(); };
+
+        // owning, value semantics: objects up to 'BufferSize' bytes are stored
+        // inline (small buffer optimization), larger objects on the heap
+        template <typename VTable, std::size_t BufferSize = 16>
+        class Erased
+        {
+        private:
+            // copy, move and destroy: rarely used, therefore shared per type;
+            // trivially copyable objects stored inline are just copied bytewise
+            struct Lifecycle
+            {
+                bool m_trivial;
+                void (*m_destroy)(Erased& self) noexcept;
+                void (*m_copy)(const Erased& from, Erased& to);
+                void (*m_move)(Erased& from, Erased& to) noexcept;
+            };
+
+            template <typename T>
+            static constexpr bool fitsInline =
+                sizeof(T) <= BufferSize &&
+                alignof(T) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible_v<T>;
+
+            template <typename T>
+            static constexpr Lifecycle InlineLifecycle
+            {
+                std::is_trivially_copyable_v<T>,
+                [](Erased& self) noexcept {
+                    static_cast<T*>(self.m_object)->~T();
+                },
+                [](const Erased& from, Erased& to) {
+                    to.m_object = ::new (to.m_buffer) T(*static_cast<const T*>(from.m_object));
+                },
+                [](Erased& from, Erased& to) noexcept {
+                    to.m_object = ::new (to.m_buffer) T(std::move(*static_cast<T*>(from.m_object)));
+                    static_cast<T*>(from.m_object)->~T();
+                }
+            };
+
+            template <typename T>
+            static constexpr Lifecycle HeapLifecycle
+            {
+                false,
+                [](Erased& self) noexcept {
+                    delete static_cast<T*>(self.m_object);
+                },
+                [](const Erased& from, Erased& to) {
+                    to.m_object = new T(*static_cast<const T*>(from.m_object));
+                },
+                [](Erased& from, Erased& to) noexcept {
+                    to.m_object = from.m_object;
+                }
+            };
+
+            alignas(std::max_align_t) std::byte m_buffer[BufferSize];
+            void* m_object{ nullptr };     // into m_buffer or onto the heap
+            const Lifecycle* m_lifecycle{ nullptr };
+            VTable m_vtable{};
+
+        public:
+            template <typename T>
+                requires Erasable<std::remove_cvref_t<T>, VTable>
+            Erased(T&& object)
+                : m_vtable{ VTable::template create<std::remove_cvref_t<T>>() }
+            {
+                using U = std::remove_cvref_t<T>;
+
+                if constexpr (fitsInline<U>) {
+                    m_object = ::new (m_buffer) U(std::forward<T>(object));
+                    m_lifecycle = &InlineLifecycle<U>;
+                }
+                else {
+                    m_object = new U(std::forward<T>(object));
+                    m_lifecycle = &HeapLifecycle<U>;
+                }
+            }
+
+            Erased(const Erased& other)
+                : m_vtable{ other.m_vtable }
+            {
+                if (other.m_lifecycle != nullptr) {
+                    if (other.m_lifecycle->m_trivial) {
+                        std::memcpy(m_buffer, other.m_buffer, BufferSize);
+                        m_object = m_buffer;
+                    }
+                    else {
+                        other.m_lifecycle->m_copy(other, *this);
+                    }
+                    m_lifecycle = other.m_lifecycle;
+                }
+            }
+
+            Erased(Erased&& other) noexcept
+                : m_vtable{ other.m_vtable }
+            {
+                take(other);
+            }
+
+            ~Erased() { reset(); }
+
+            Erased& operator=(const Erased& other)
+            {
+                if (this != &other) {
+                    Erased copy{ other };
+                    *this = std::move(copy);
+                }
+                return *this;
+            }
+
+            Erased& operator=(Erased&& other) noexcept
+            {
+                if (this != &other) {
+                    reset();
+                    m_vtable = other.m_vtable;
+                    take(other);
+                }
+                return *this;
+            }
+
+            void reset() noexcept
+            {
+                if (m_lifecycle != nullptr) {
+                    if (!m_lifecycle->m_trivial) {
+                        m_lifecycle->m_destroy(*this);
+                    }
+                    m_lifecycle = nullptr;
+                    m_object = nullptr;
+                }
+            }
+
+            bool hasValue() const { return m_lifecycle != nullptr; }
+            bool isInline() const { return m_object == m_buffer; }
+
+            const void* object() const { return m_object; }
+            const VTable& vtable() const { return m_vtable; }
+
+        private:
+            void take(Erased& other) noexcept
+            {
+                if (other.m_lifecycle != nullptr) {
+                    if (other.m_lifecycle->m_trivial) {
+                        std::memcpy(m_buffer, other.m_buffer, BufferSize);
+                        m_object = m_buffer;
+                    }
+                    else {
+                        other.m_lifecycle->m_move(other, *this);
+                    }
+                    m_lifecycle = other.m_lifecycle;
+                    other.m_lifecycle = nullptr;
+                    other.m_object = nullptr;
+                }
+            }
+        };
+
+        // non-owning: refers to an object living elsewhere, trivially copyable
+        template <typename VTable>
+        class ErasedView
+        {
+        private:
+            const void* m_object;
+            VTable m_vtable;
+
+        public:
+            template <typename T>
+                requires Erasable<T, VTable>
+            ErasedView(const T& object)
+                : m_object{ &object }, m_vtable{ VTable::template create<T>() }
+            {}
+
+            template <std::size_t BufferSize>
+            ErasedView(const Erased<VTable, BufferSize>& erased)
+                : m_object{ erased.object() }, m_vtable{ erased.vtable() }
+            {}
+
+            const void* object() const { return m_object; }
+            const VTable& vtable() const { return m_vtable; }
+        };
+
+        // copy-on-write: copies share one object on the heap, which is cloned
+        // on the first mutable access through a shared instance
+        template <typename VTable>
+        class SharedErased
+        {
+        private:
+            struct Block
+            {
+                std::atomic<std::size_t> m_count{ 1 };
+                const std::type_info* m_type;       // not the function pointers: /OPT:ICF may fold them
+                void (*m_destroy)(Block*) noexcept;
+                Block* (*m_clone)(const Block*);
+            };
+
+            template <typename T>
+            struct Model : Block
+            {
+                T m_value;
+
+                Model(const T& value) : m_value{ value }
+                {
+                    this->m_type = &typeid(T);
+                    this->m_destroy = &destroy;
+                    this->m_clone = &clone;
+                }
+
+                Model(T&& value) : m_value{ std::move(value) }
+                {
+                    this->m_type = &typeid(T);
+                    this->m_destroy = &destroy;
+                    this->m_clone = &clone;
+                }
+
+                static void destroy(Block* block) noexcept { delete static_cast<Model*>(block); }
+
+                static Block* clone(const Block* block) { return new Model{ static_cast<const Model*>(block)->m_value }; }
+            };
+
+            Block* m_block;
+            void* m_object;
+            VTable m_vtable;
+
+        public:
+            template <typename T>
+                requires Erasable<std::remove_cvref_t<T>, VTable>
+            SharedErased(T&& object)
+                : m_vtable{ VTable::template create<std::remove_cvref_t<T>>() }
+            {
+                auto model{ new Model<std::remove_cvref_t<T>>{ std::forward<T>(object) } };
+                m_block = model;
+                m_object = &model->m_value;
+            }
+
+            SharedErased(const SharedErased& other)
+                : m_block{ other.m_block }, m_object{ other.m_object }, m_vtable{ other.m_vtable }
+            {
+                if (m_block != nullptr) {
+                    m_block->m_count.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            // moving transfers the reference: no reference count update,
+            // the moved-from instance is empty and may only be assigned or destroyed
+            SharedErased(SharedErased&& other) noexcept
+                : m_block{ std::exchange(other.m_block, nullptr) },
+                  m_object{ std::exchange(other.m_object, nullptr) },
+                  m_vtable{ other.m_vtable }
+            {}
+
+            SharedErased& operator=(const SharedErased& other)
+            {
+                SharedErased copy{ other };
+                swap(copy);
+                return *this;
+            }
+
+            SharedErased& operator=(SharedErased&& other) noexcept
+            {
+                SharedErased moved{ std::move(other) };
+                swap(moved);
+                return *this;
+            }
+
+            ~SharedErased() { release(m_block); }
+
+            std::size_t useCount() const
+            {
+                return m_block != nullptr ? m_block->m_count.load(std::memory_order_relaxed) : 0;
+            }
+
+            const void* object() const { return m_object; }
+            const VTable& vtable() const { return m_vtable; }
+
+            // mutable access; returns nullptr, if the object isn't a 'T'
+            template <typename T>
+            T* mutate()
+            {
+                if (m_block == nullptr or *m_block->m_type != typeid(T)) {
+                    return nullptr;
+                }
+
+                if (m_block->m_count.load(std::memory_order_acquire) != 1) {
+                    Block* copy{ m_block->m_clone(m_block) };
+                    release(m_block);
+                    m_block = copy;
+                    m_object = &static_cast<Model<T>*>(copy)->m_value;
+                }
+
+                return static_cast<T*>(m_object);
+            }
+
+        private:
+            void swap(SharedErased& other) noexcept
+            {
+                std::swap(m_block, other.m_block);
+                std::swap(m_object, other.m_object);
+                std::swap(m_vtable, other.m_vtable);
+            }
+
+            static void release(Block* block) noexcept
+            {
+                if (block != nullptr and block->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    block->m_destroy(block);
+                }
+            }
+        };
+
+        using Animal = Erased<AnimalVTable>;
+        using AnimalView = ErasedView<AnimalVTable>;
+        using SharedAnimal = SharedErased<AnimalVTable>;
+
+        // works with all three flavours
+        template <typename TAnimal>
+        std::string see(const TAnimal& animal) { return animal.vtable().see(animal.object()); }
+
+        template <typename TAnimal>
+        std::string say(const TAnimal& animal) { return animal.vtable().say(animal.object()); }
+
+        class SeeAndSay
+        {
+            // registered animals: stored by value, no allocation for small animals
+            std::vector<Animal> m_animals;
+
+        public:
+            template <typename T>
+            void addAnimal(T&& animal)
+            {
+                m_animals.emplace_back(std::forward<T>(animal));
+            }
+
+            void seeAndSay(AnimalView animal) {
+                std::cout
+                    << "The " << see(animal) << " says '"
+                    << say(animal) << "' :)." << std::endl;
+            }
+
+            void print() {
+                for (const auto& animal : m_animals) {
+                    seeAndSay(animal);
+                }
+            }
+        };
+
+        static void clientCode()
+        {
+            SeeAndSay animals;
+
+            animals.addAnimal(Cow{});
+            animals.addAnimal(Pig{});
+            animals.addAnimal(Dog{});
+            animals.addAnimal(Parrot{ "hello" });
+
+            animals.print();
+
+            Animal aCow{ Cow{} };
+            Animal aParrot{ Parrot{ "hello" } };
+            std::cout << std::boolalpha
+                << "cow stored inline: " << aCow.isInline()
+                << ", parrot stored inline: " << aParrot.isInline() << std::endl;
+
+            // copy-on-write
+            SharedAnimal parrot{ Parrot{ "hello" } };
+            SharedAnimal copy{ parrot };
+            std::cout << "shared by " << copy.useCount() << " animals" << std::endl;
+
+            copy.mutate<Parrot>()->learn("goodbye");
+            std::cout << "The " << see(parrot) << " says '" << say(parrot) << "', "
+                << "the copy says '" << say(copy) << "'." << std::endl;
+
+            // mutable access with the wrong type is rejected
+            SharedAnimal cow{ Cow{} };
+            std::cout << "cow mutable as pig: " << (cow.mutate<Pig>() != nullptr) << std::endl;
+        }
+
+        // classic design for comparison: one shared_ptr per animal
+        class AnimalConcept
+        {
+        public:
+            virtual ~AnimalConcept() = default;
+
+            virtual std::string see() const = 0;
+            virtual std::string say() const = 0;
+        };
+
+        template <typename T>
+        class AnimalModel : public AnimalConcept
+        {
+        private:
+            T m_animal;
+
+        public:
+            AnimalModel(const T& animal) : m_animal{ animal } {}
+
+            std::string see() const override { return m_animal.see(); }
+            std::string say() const override { return m_animal.say(); }
+        };
+
+        template <typename Function>
+        static void measure(const std::string& name, Function function)
+        {
+            const auto start{ std::chrono::steady_clock::now() };
+            std::size_t result{ function() };
+            const auto end{ std::chrono::steady_clock::now() };
+
+            std::cout << std::left << std::setw(36) << name << std::right << std::setw(6)
+                << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                << " msecs (" << result << ")" << std::endl;
+        }
+
+        static void benchmark()
+        {
+            constexpr std::size_t Count{ 10'000'000 };
+
+            std::cout << Count << " animals:" << std::endl;
+
+            {
+                std::vector<std::shared_ptr<AnimalConcept>> animals;
+
+                measure("shared_ptr: create", [&]() {
+                    animals.reserve(Count);
+                    for (std::size_t i{}; i < Count; ++i) {
+                        switch (i % 3) {
+                        case 0: animals.push_back(std::make_shared<AnimalModel<Cow>>(Cow{})); break;
+                        case 1: animals.push_back(std::make_shared<AnimalModel<Pig>>(Pig{})); break;
+                        default: animals.push_back(std::make_shared<AnimalModel<Dog>>(Dog{})); break;
+                        }
+                    }
+                    return animals.size();
+                });
+
+                measure("shared_ptr: call", [&]() {
+                    std::size_t length{};
+                    for (const auto& animal : animals) {
+                        length += animal->say().size();
+                    }
+                    return length;
+                });
+
+                measure("shared_ptr: copy collection", [&]() {
+                    std::vector<std::shared_ptr<AnimalConcept>> copy{ animals };
+                    return copy.size();
+                });
+            }
+
+            {
+                std::vector<Animal> animals;
+
+                measure("Erased (SBO): create", [&]() {
+                    animals.reserve(Count);
+                    for (std::size_t i{}; i < Count; ++i) {
+                        switch (i % 3) {
+                        case 0: animals.emplace_back(Cow{}); break;
+                        case 1: animals.emplace_back(Pig{}); break;
+                        default: animals.emplace_back(Dog{}); break;
+                        }
+                    }
+                    return animals.size();
+                });
+
+                measure("Erased (SBO): call", [&]() {
+                    std::size_t length{};
+                    for (const auto& animal : animals) {
+                        length += say(animal).size();
+                    }
+                    return length;
+                });
+
+                measure("Erased (SBO): copy collection", [&]() {
+                    std::vector<Animal> copy{ animals };
+                    return copy.size();
+                });
+
+                std::vector<AnimalView> views{ animals.begin(), animals.end() };
+
+                measure("ErasedView: call", [&]() {
+                    std::size_t length{};
+                    for (const auto& animal : views) {
+                        length += say(animal).size();
+                    }
+                    return length;
+                });
+            }
+
+            {
+                std::vector<SharedAnimal> animals;
+
+                measure("SharedErased (COW): create", [&]() {
+                    animals.reserve(Count);
+                    for (std::size_t i{}; i < Count; ++i) {
+                        switch (i % 3) {
+                        case 0: animals.emplace_back(Cow{}); break;
+                        case 1: animals.emplace_back(Pig{}); break;
+                        default: animals.emplace_back(Dog{}); break;
+                        }
+                    }
+                    return animals.size();
+                });
+
+                measure("SharedErased (COW): call", [&]() {
+                    std::size_t length{};
+                    for (const auto& animal : animals) {
+                        length += say(animal).size();
+                    }
+                    return length;
+                });
+
+                measure("SharedErased (COW): copy collection", [&]() {
+                    std::vector<SharedAnimal> copy{ animals };
+                    return copy.size();
+                });
+            }
+        }
+    }
 }
 
 void test_conceptual_example()
@@ -495,6 +1075,12 @@ void test_conceptual_example()
     ConceptualExample::Motivation05::clientCode();
     ConceptualExample::Motivation06::clientCode();
     ConceptualExample::Motivation07::clientCode();
+    ConceptualExample::Motivation08::clientCode();
+}
+
+void benchmark_conceptual_example()
+{
+    ConceptualExample::Motivation08::benchmark();
 }
 
 // ===========================================================================
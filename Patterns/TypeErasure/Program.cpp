@@ -4,10 +4,12 @@
 
 // function prototypes
 extern void test_conceptual_example();
+extern void benchmark_conceptual_example();
 
 int main()
 {
     test_conceptual_example();
+    benchmark_conceptual_example();
     return 0;
 }
 
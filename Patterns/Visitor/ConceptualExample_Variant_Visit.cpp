@@ -2,9 +2,22 @@
 // ConceptualExample_Variant_Visit.cpp // Visitor Pattern - Mopdern C++
 // ===========================================================================
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <print>
+#include <random>
 #include <span>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -93,6 +106,440 @@ namespace ConceptualExample_Visitor_Pattern_Modern {
             std::visit(visitor, comp);
         }
     }
+
+    // =======================================================================
+    // Visiting very large heterogeneous arrays.
+    // An interleaved std::vector<Component> dispatches on every element.
+    // PartitionedComponents stores one std::vector per alternative
+    // (struct of arrays), so a visitor overload runs over one homogeneous,
+    // contiguous range - no dispatch inside the loop, which the compiler
+    // is free to vectorize. Ranges are split into chunks, which can be
+    // processed by a thread pool; the per chunk results are reduced in
+    // chunk order, so the result doesn't depend on the number of threads.
+    // =======================================================================
+
+    class VisitorThreadPool
+    {
+    public:
+        explicit VisitorThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+        {
+            // the calling thread takes part in each job
+            for (std::size_t i = 1; i < std::max<std::size_t>(threads, 1); ++i) {
+                m_threads.emplace_back([this] () { run(); });
+            }
+        }
+
+        VisitorThreadPool(const VisitorThreadPool&) = delete;
+        VisitorThreadPool& operator= (const VisitorThreadPool&) = delete;
+
+        ~VisitorThreadPool()
+        {
+            {
+                std::lock_guard guard{ m_mutex };
+                m_stop = true;
+            }
+
+            m_start.notify_all();
+
+            for (auto& thread : m_threads) {
+                thread.join();
+            }
+        }
+
+        std::size_t size() const { return m_threads.size() + 1; }
+
+        // calls job(index) for each index in [0, count); indices are claimed
+        // by a lock-free counter, the mutex is only used to start and join
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)>& job)
+        {
+            {
+                std::lock_guard guard{ m_mutex };
+                m_job = &job;
+                m_count = count;
+                m_next.store(0);
+                m_active = m_threads.size();
+                ++m_generation;
+            }
+
+            m_start.notify_all();
+
+            work(job, count);
+
+            std::unique_lock lock{ m_mutex };
+            m_done.wait(lock, [this] () { return m_active == 0; });
+            m_job = nullptr;
+        }
+
+    private:
+        void run()
+        {
+            std::size_t generation{};
+
+            while (true) {
+
+                const std::function<void(std::size_t)>* job{};
+                std::size_t count{};
+
+                {
+                    std::unique_lock lock{ m_mutex };
+                    m_start.wait(lock, [&] () { return m_stop || m_generation != generation; });
+
+                    if (m_stop) {
+                        return;
+                    }
+
+                    generation = m_generation;
+                    job = m_job;
+                    count = m_count;
+                }
+
+                work(*job, count);
+
+                {
+                    std::lock_guard guard{ m_mutex };
+                    --m_active;
+                }
+
+                m_done.notify_one();
+            }
+        }
+
+        void work(const std::function<void(std::size_t)>& job, std::size_t count)
+        {
+            for (std::size_t index = m_next.fetch_add(1); index < count; index = m_next.fetch_add(1)) {
+                job(index);
+            }
+        }
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_start;
+        std::condition_variable m_done;
+        const std::function<void(std::size_t)>* m_job{};
+        std::size_t m_count{};
+        std::size_t m_active{};
+        std::size_t m_generation{};
+        bool m_stop{};
+        std::atomic<std::size_t> m_next{};
+    };
+
+    template <typename TVariant>
+    class PartitionedComponents;
+
+    template <typename... TAlternatives>
+    class PartitionedComponents<std::variant<TAlternatives...>>
+    {
+    public:
+        static constexpr std::size_t DefaultGrainSize{ 16 * 1024 };
+
+        PartitionedComponents() = default;
+
+        explicit PartitionedComponents(std::span<const std::variant<TAlternatives...>> components)
+        {
+            for (const auto& component : components) {
+                add(component);
+            }
+        }
+
+        void add(const std::variant<TAlternatives...>& component)
+        {
+            std::visit(
+                [this] (const auto& alternative) {
+                    using T = std::decay_t<decltype(alternative)>;
+                    std::get<std::vector<T>>(m_alternatives).push_back(alternative);
+                },
+                component
+            );
+        }
+
+        template <typename T, typename... TArgs>
+        T& emplace(TArgs&&... args)
+        {
+            return std::get<std::vector<T>>(m_alternatives).emplace_back(std::forward<TArgs>(args)...);
+        }
+
+        template <typename T>
+        std::span<const T> get() const { return std::get<std::vector<T>>(m_alternatives); }
+
+        std::size_t size() const
+        {
+            return std::apply([] (const auto&... vectors) { return (vectors.size() + ... + 0); }, m_alternatives);
+        }
+
+        void clear()
+        {
+            std::apply([] (auto&... vectors) { (vectors.clear(), ...); }, m_alternatives);
+        }
+
+        // visits all elements, one alternative after the other
+        template <typename Visitor>
+        void forEach(const Visitor& visitor) const
+        {
+            std::apply(
+                [&] (const auto&... vectors) {
+                    (std::for_each(vectors.begin(), vectors.end(), visitor), ...);
+                },
+                m_alternatives
+            );
+        }
+
+        // reduce(init, visitor(element)) over all elements; with a thread pool
+        // the chunks are processed in parallel and reduced afterwards in order
+        template <typename R, typename Visitor, typename Reduce>
+        R transformReduce(
+            const Visitor& visitor,
+            R init,
+            Reduce reduce,
+            VisitorThreadPool* pool = nullptr,
+            std::size_t grainSize = DefaultGrainSize) const
+        {
+            grainSize = std::max<std::size_t>(grainSize, 1);
+
+            std::array<std::size_t, sizeof...(TAlternatives) + 1> firstChunk{};
+            std::size_t index{};
+            std::apply(
+                [&] (const auto&... vectors) {
+                    ((firstChunk[index + 1] = firstChunk[index] + (vectors.size() + grainSize - 1) / grainSize, ++index), ...);
+                },
+                m_alternatives
+            );
+
+            const std::size_t chunks{ firstChunk.back() };
+            std::vector<R> partials(chunks, init);
+
+            auto job = [&] (std::size_t chunk) {
+                visitChunk(chunk, firstChunk, grainSize, visitor, reduce, partials[chunk],
+                    std::index_sequence_for<TAlternatives...>{});
+            };
+
+            if (pool == nullptr || pool->size() == 1 || chunks < 2) {
+                for (std::size_t chunk{}; chunk < chunks; ++chunk) {
+                    job(chunk);
+                }
+            }
+            else {
+                pool->parallelFor(chunks, job);
+            }
+
+            R result{ init };
+            for (const R& partial : partials) {
+                result = reduce(result, partial);
+            }
+
+            return result;
+        }
+
+    private:
+        template <typename Visitor, typename Reduce, typename R, std::size_t... Is>
+        void visitChunk(
+            std::size_t chunk,
+            const std::array<std::size_t, sizeof...(TAlternatives) + 1>& firstChunk,
+            std::size_t grainSize,
+            const Visitor& visitor,
+            Reduce& reduce,
+            R& partial,
+            std::index_sequence<Is...>) const
+        {
+            // find the alternative owning this chunk, then run a plain loop
+            ((chunk < firstChunk[Is + 1]
+                ? (visitRange(std::get<Is>(m_alternatives), (chunk - firstChunk[Is]) * grainSize, grainSize, visitor, reduce, partial), true)
+                : false) || ...);
+        }
+
+        template <typename T, typename Visitor, typename Reduce, typename R>
+        static void visitRange(
+            const std::vector<T>& elements,
+            std::size_t first,
+            std::size_t count,
+            const Visitor& visitor,
+            Reduce& reduce,
+            R& partial)
+        {
+            // chunks are never empty: start with the first element, so that
+            // 'init' enters the result exactly once
+            const std::size_t last{ std::min(first + count, elements.size()) };
+            R result{ visitor(elements[first]) };
+
+            for (std::size_t i = first + 1; i < last; ++i) {
+                result = reduce(result, visitor(elements[i]));
+            }
+
+            partial = result;
+        }
+
+        std::tuple<std::vector<TAlternatives>...> m_alternatives;
+    };
+
+    template <typename Visitor>
+    static void clientCodePartitioned(const PartitionedComponents<Component>& components, const Visitor& visitor)
+    {
+        components.forEach(visitor);
+    }
+
+    // =======================================================================
+    // Benchmark: area of many shapes - classic double dispatch,
+    // interleaved std::variant and partitioned (serial and parallel)
+    // =======================================================================
+
+    struct Circle { double m_radius; };
+    struct Rectangle { double m_width; double m_height; };
+    struct Triangle { double m_base; double m_height; };
+
+    using Shape = std::variant<Circle, Rectangle, Triangle>;
+
+    struct AreaVisitor
+    {
+        double operator() (const Circle& circle) const { return 3.14159265358979 * circle.m_radius * circle.m_radius; }
+        double operator() (const Rectangle& rectangle) const { return rectangle.m_width * rectangle.m_height; }
+        double operator() (const Triangle& triangle) const { return 0.5 * triangle.m_base * triangle.m_height; }
+    };
+
+    class ClassicShapeVisitor;
+
+    class ClassicShape
+    {
+    public:
+        virtual ~ClassicShape() = default;
+        virtual void accept(ClassicShapeVisitor& visitor) const = 0;
+    };
+
+    class ClassicCircle;
+    class ClassicRectangle;
+    class ClassicTriangle;
+
+    class ClassicShapeVisitor
+    {
+    public:
+        virtual ~ClassicShapeVisitor() = default;
+        virtual void visit(const ClassicCircle&) = 0;
+        virtual void visit(const ClassicRectangle&) = 0;
+        virtual void visit(const ClassicTriangle&) = 0;
+    };
+
+    class ClassicCircle final : public ClassicShape, public Circle
+    {
+    public:
+        explicit ClassicCircle(const Circle& circle) : Circle{ circle } {}
+        void accept(ClassicShapeVisitor& visitor) const override { visitor.visit(*this); }
+    };
+
+    class ClassicRectangle final : public ClassicShape, public Rectangle
+    {
+    public:
+        explicit ClassicRectangle(const Rectangle& rectangle) : Rectangle{ rectangle } {}
+        void accept(ClassicShapeVisitor& visitor) const override { visitor.visit(*this); }
+    };
+
+    class ClassicTriangle final : public ClassicShape, public Triangle
+    {
+    public:
+        explicit ClassicTriangle(const Triangle& triangle) : Triangle{ triangle } {}
+        void accept(ClassicShapeVisitor& visitor) const override { visitor.visit(*this); }
+    };
+
+    class ClassicAreaVisitor final : public ClassicShapeVisitor
+    {
+    public:
+        double m_area{};
+
+        void visit(const ClassicCircle& circle) override { m_area += AreaVisitor{}(circle); }
+        void visit(const ClassicRectangle& rectangle) override { m_area += AreaVisitor{}(rectangle); }
+        void visit(const ClassicTriangle& triangle) override { m_area += AreaVisitor{}(triangle); }
+    };
+
+    template <typename Function>
+    static void measure(std::string_view name, Function function)
+    {
+        const auto start{ std::chrono::steady_clock::now() };
+        double area{ function() };
+        const auto end{ std::chrono::steady_clock::now() };
+
+        std::println("{:<34} {:>8} msecs (area: {:.6e})", name,
+            std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), area);
+    }
+
+    static void benchmark()
+    {
+        constexpr std::size_t Count{ 4'000'000 };
+        constexpr int Repetitions{ 10 };
+
+        std::mt19937 generator{ 4711 };
+        std::uniform_int_distribution<int> kind{ 0, 2 };
+        std::uniform_real_distribution<double> length{ 0.5, 2.0 };
+
+        std::vector<Shape> shapes;
+        shapes.reserve(Count);
+
+        std::vector<std::unique_ptr<ClassicShape>> classicShapes;
+        classicShapes.reserve(Count);
+
+        for (std::size_t i{}; i < Count; ++i) {
+            switch (kind(generator)) {
+            case 0: {
+                Circle circle{ length(generator) };
+                shapes.emplace_back(circle);
+                classicShapes.push_back(std::make_unique<ClassicCircle>(circle));
+                break;
+            }
+            case 1: {
+                Rectangle rectangle{ length(generator), length(generator) };
+                shapes.emplace_back(rectangle);
+                classicShapes.push_back(std::make_unique<ClassicRectangle>(rectangle));
+                break;
+            }
+            default: {
+                Triangle triangle{ length(generator), length(generator) };
+                shapes.emplace_back(triangle);
+                classicShapes.push_back(std::make_unique<ClassicTriangle>(triangle));
+                break;
+            }
+            }
+        }
+
+        const PartitionedComponents<Shape> partitioned{ shapes };
+        VisitorThreadPool pool;
+
+        std::println("{} shapes, {} repetitions, {} threads:", Count, Repetitions, pool.size());
+
+        measure("classic double dispatch", [&] () {
+            double area{};
+            for (int n{}; n < Repetitions; ++n) {
+                ClassicAreaVisitor visitor;
+                for (const auto& shape : classicShapes) {
+                    shape->accept(visitor);
+                }
+                area = visitor.m_area;
+            }
+            return area;
+        });
+
+        measure("interleaved std::variant", [&] () {
+            double area{};
+            for (int n{}; n < Repetitions; ++n) {
+                area = 0.0;
+                for (const auto& shape : shapes) {
+                    area += std::visit(AreaVisitor{}, shape);
+                }
+            }
+            return area;
+        });
+
+        measure("partitioned, serial", [&] () {
+            double area{};
+            for (int n{}; n < Repetitions; ++n) {
+                area = partitioned.transformReduce(AreaVisitor{}, 0.0, std::plus<>{});
+            }
+            return area;
+        });
+
+        measure("partitioned, thread pool", [&] () {
+            double area{};
+            for (int n{}; n < Repetitions; ++n) {
+                area = partitioned.transformReduce(AreaVisitor{}, 0.0, std::plus<>{}, &pool);
+            }
+            return area;
+        });
+    }
 }
 
 void test_conceptual_example_02() {
@@ -113,6 +560,19 @@ void test_conceptual_example_02() {
     std::println("It allows the same client code to work with different types of visitors");
     Visitor2 visitor2;
     clientCode<Visitor2>(components, visitor2);
+    std::println();
+
+    std::println("Partitioned by alternative, each visitor overload runs over one range:");
+    PartitionedComponents<Component> partitioned{ components };
+    partitioned.emplace<ConcreteComponentA>();
+    clientCodePartitioned(partitioned, visitor1);
+}
+
+void benchmark_conceptual_example_02() {
+
+    using namespace ConceptualExample_Visitor_Pattern_Modern;
+
+    benchmark();
 }
 
 // ===========================================================================
@@ -5,6 +5,7 @@
 // function prototypes
 extern void test_conceptual_example_01();
 extern void test_conceptual_example_02();
+extern void benchmark_conceptual_example_02();
 
 extern void test_motivation_example();
 extern void test_onlineshop_example();
@@ -14,6 +15,7 @@ int main()
 {
     test_conceptual_example_01();
     test_conceptual_example_02();
+    benchmark_conceptual_example_02();
 
     test_motivation_example();
     test_bookstore_example();